@@ -0,0 +1,157 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVector>
+#include <QThread>
+#include <QTransform>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+#include "core/qimagescanner.h"
+#include "core/qdirectoryindex.h"
+#include "core/qimagedecoder.h"
+#include "core/qimageeditpipeline.h"
+#include "core/qjpegdecoder.h"
+#include "core/qimagerotation.h"
+#include "core/qimagestatistics.h"
+#include "core/qpixelkernels.h"
+#include "core/qthumbnailer.h"
+
+//! qimagewidget_bench [megapixels] [image directory]
+//! Use 20 to 100 megapixels to compare rotation with QImage::transformed().
+//! Times the hot paths on a synthetic image, and thumbnailing when a
+//! directory is given. Prints the minimum and the median of the runs.
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream stream( stdout );
+    return stream;
+}
+
+void run( const QString &name, const int &runs, const std::function < void () > &function )
+{
+    QVector < qint64 > times;
+    for ( int i = 0; i < runs; ++i ) {
+        QElapsedTimer timer;
+        timer.start();
+        function();
+        times.append( timer.nsecsElapsed() );
+    }
+
+    std::sort( times.begin(), times.end() );
+    out() << qSetFieldWidth( 32 ) << left << name << qSetFieldWidth( 0 )
+          << "min " << times.first() / 1e6 << " ms, median " << times.at( times.size() / 2 ) / 1e6 << " ms" << endl;
+}
+
+QImage syntheticImage( const int &megapixels )
+{
+    const int width = 4 * int( std::sqrt( megapixels * 1e6 / 12 ) );
+    const int height = int( megapixels * 1e6 / width );
+
+    QImage image( width, height, QImage::Format_ARGB32 );
+    for ( int y = 0; y < height; ++y ) {
+        QRgb *line = reinterpret_cast < QRgb * > ( image.scanLine( y ) );
+        for ( int x = 0; x < width; ++x ) {
+            line[ x ] = qRgba( x, y, x ^ y, 255 );
+        }
+    }
+
+    return image;
+}
+
+} // namespace
+
+int main( int argc, char *argv[] )
+{
+    QCoreApplication app( argc, argv );
+
+    const QStringList arguments = app.arguments();
+    const int megapixels = arguments.size() > 1 ? qMax( 1, arguments.at( 1 ).toInt() ) : 24;
+
+    out() << "threads " << QThread::idealThreadCount() << ", image " << megapixels << " MP"
+          << ", kernels " << QPixelKernels::pathName( QPixelKernels::activePath() ) << endl;
+
+    const QImage image = syntheticImage( megapixels );
+    const QImage other = QImageEditPipeline::rotated( QImageEditPipeline::rotated( image, 180 ), 180 );
+
+    run( "statistics", 10, [ & ] () {
+        QImageStatistics::compute( image );
+    } );
+
+    run( "statistics, crop 10%", 10, [ & ] () {
+        QImageStatistics::compute( image, QRect( 0, 0, image.width(), image.height() / 10 ) );
+    } );
+
+    QImage difference( image.size(), QImage::Format_ARGB32 );
+    run( "difference", 10, [ & ] () {
+        for ( int y = 0; y < image.height(); ++y ) {
+            QPixelKernels::absDiff( reinterpret_cast < const QRgb * > ( image.constScanLine( y ) ),
+                                    reinterpret_cast < const QRgb * > ( other.constScanLine( y ) ),
+                                    reinterpret_cast < QRgb * > ( difference.scanLine( y ) ),
+                                    image.width() );
+        }
+    } );
+
+    const QImage rgb888 = image.convertToFormat( QImage::Format_RGB888 );
+    const int angles[] = { 90, 180, 270 };
+    for ( int i = 0; i < 3; ++i ) {
+        const int degrees = angles[ i ];
+
+        run( QString( "rotate %1" ).arg( degrees ), 5, [ & ] () {
+            QImageRotation::rotated( image, degrees );
+        } );
+
+        run( QString( "rotate %1, transformed()" ).arg( degrees ), 5, [ & ] () {
+            image.transformed( QTransform().rotate( degrees ) );
+        } );
+
+        run( QString( "rotate %1 RGB888" ).arg( degrees ), 5, [ & ] () {
+            QImageRotation::rotated( rgb888, degrees );
+        } );
+
+        run( QString( "rotate %1 RGB888, transformed()" ).arg( degrees ), 5, [ & ] () {
+            rgb888.transformed( QTransform().rotate( degrees ) );
+        } );
+    }
+
+    QTemporaryDir directory;
+    const QString jpeg = directory.filePath( "bench.jpg" );
+    if ( image.save( jpeg, "JPEG", 90 ) ) {
+        out() << "jpeg preview decoder " << ( QJpegDecoder::isAvailable() ? "libjpeg" : "QImageReader" ) << endl;
+
+        run( "jpeg preview 256", 5, [ & ] () {
+            QImageDecoder::decode( jpeg, QSize( 256, 256 ), Qt::KeepAspectRatioByExpanding );
+        } );
+
+        run( "jpeg preview 256, full decode", 5, [ & ] () {
+            QImage( jpeg ).scaled( QSize( 256, 256 ), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation );
+        } );
+    }
+
+    if ( arguments.size() > 2 ) {
+        const QStringList paths = QImageScanner::scan( arguments.at( 2 ) );
+        out() << paths.size() << " images in " << arguments.at( 2 ) << endl;
+
+        run( "scan", 3, [ & ] () {
+            QImageScanner::scan( arguments.at( 2 ) );
+        } );
+
+        QDirectoryIndex index( QString() );
+        index.scan( arguments.at( 2 ), QImageScanner::defaultNameFilters() );
+        run( "scan, unchanged and cached", 3, [ & ] () {
+            index.scan( arguments.at( 2 ), QImageScanner::defaultNameFilters() );
+        } );
+
+        run( "thumbnails 256", 1, [ & ] () {
+            foreach ( const QString &path, paths ) {
+                QThumbnailer::thumbnail( path, QSize( 256, 256 ) );
+            }
+        } );
+    }
+
+    return 0;
+}
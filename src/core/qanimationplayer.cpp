@@ -0,0 +1,381 @@
+#include "qanimationplayer.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QScopedPointer>
+#include <QDebug>
+
+namespace {
+
+// browsers treat tiny GIF delays as 100 ms, so do we
+int frameDelay( const int &delay )
+{
+    return delay <= 10 ? 100 : delay;
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! ANIMATION DECODE THREAD //!
+QAnimationDecodeThread::QAnimationDecodeThread( const QString &path, const int &capacity,
+                                                const bool &firstFrameShown, QObject *parent )
+    : QThread( parent ),
+      m_path( path ),
+      m_capacity( qMax( 1, capacity ) ),
+      m_firstFrameShown( firstFrameShown ),
+      m_seekTarget( -1 ),
+      m_seekGeneration( 0 ),
+      m_aborted( false )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QAnimationDecodeThread::~QAnimationDecodeThread()
+{
+    abort();
+    wait();
+}
+
+//---------------------------------------------------------------------------
+
+bool QAnimationDecodeThread::takeFrame( QAnimationFrame *frame )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_frames.isEmpty() ) {
+        return false;
+    }
+
+    *frame = m_frames.dequeue();
+    m_notFull.wakeAll();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationDecodeThread::seek( const int &frame )
+{
+    QMutexLocker locker( &m_mutex );
+    m_seekTarget = qMax( 0, frame );
+    m_seekGeneration++;
+    m_frames.clear();
+    m_notFull.wakeAll();
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationDecodeThread::abort()
+{
+    QMutexLocker locker( &m_mutex );
+    m_aborted = true;
+    m_notFull.wakeAll();
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationDecodeThread::run()
+{
+    QScopedPointer < QImageReader > reader( new QImageReader( m_path ) );
+    const int loopCount = reader->loopCount();   // -1 forever
+    int loops = 0;
+    int number = 0;
+    bool counted = false;
+    bool firstFrameShown = m_firstFrameShown;
+
+    forever {
+        int seekTarget = -1;
+        int generation = 0;
+        {
+            QMutexLocker locker( &m_mutex );
+            while ( !m_aborted && m_seekTarget < 0 && m_frames.size() >= m_capacity ) {
+                m_notFull.wait( &m_mutex );
+            }
+            if ( m_aborted ) {
+                return;
+            }
+
+            seekTarget = m_seekTarget;
+            m_seekTarget = -1;
+            generation = m_seekGeneration;
+        }
+
+        if ( seekTarget >= 0 ) {
+            // not every handler can jump, then read up to the frame
+            if ( !reader->jumpToImage( seekTarget ) ) {
+                reader.reset( new QImageReader( m_path ) );
+                for ( int i = 0; i < seekTarget && reader->canRead(); ++i ) {
+                    reader->read();
+                }
+            }
+            number = seekTarget;
+            firstFrameShown = false;
+        }
+
+        // frame 0 shown by the caller goes out without its image; a handler
+        // able to jump past it does not decode it at all, others must, the
+        // next frames may be drawn over it
+        const bool shown = firstFrameShown && number == 0;
+        firstFrameShown = false;
+        const int shownDelay = shown ? reader->nextImageDelay() : 0;
+        const bool jumped = shown && reader->jumpToImage( 1 );
+
+        const QImage image = jumped ? QImage() : reader->read();
+        if ( !jumped && image.isNull() ) {
+            if ( number == 0 ) {
+                qWarning() << Q_FUNC_INFO << m_path << reader->errorString();
+                emit failed();
+                return;
+            }
+
+            // the count comes from reading the frames, imageCount() would
+            // read a GIF through once more
+            if ( !counted ) {
+                counted = true;
+                emit framesCounted( number );
+                if ( number == 1 ) {
+                    return;
+                }
+            }
+
+            // end of the animation, start over unless loops are done
+            loops++;
+            if ( loopCount >= 0 && loops > loopCount ) {
+                return;
+            }
+
+            reader.reset( new QImageReader( m_path ) );
+            number = 0;
+            continue;
+        }
+
+        QAnimationFrame frame;
+        frame.image = shown ? QImage() : image;
+        frame.number = number++;
+        frame.delay = frameDelay( jumped ? shownDelay : reader->nextImageDelay() );
+
+        {
+            QMutexLocker locker( &m_mutex );
+            if ( generation != m_seekGeneration ) { // seeked meanwhile
+                continue;
+            }
+            m_frames.enqueue( frame );
+        }
+
+        emit frameReady();
+    }
+}
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! ANIMATION PLAYER //!
+QAnimationPlayer::QAnimationPlayer( QObject *parent )
+    : QObject( parent ),
+      m_thread( 0 ),
+      m_deadline( 0 ),
+      m_waiting( false ),
+      m_paused( false ),
+      m_pausedRemaining( 0 ),
+      m_cacheFrames( DefaultCacheFrames ),
+      m_frameCount( 0 ),
+      m_currentFrame( -1 )
+{
+    m_probes.setMaxCost( MaxProbes );
+
+    m_timer = new QTimer( this );
+    m_timer->setSingleShot( true );
+    m_timer->setTimerType( Qt::PreciseTimer );
+    connect( m_timer, &QTimer::timeout,
+             this, &QAnimationPlayer::showNextFrame );
+}
+
+//---------------------------------------------------------------------------
+
+QAnimationPlayer::~QAnimationPlayer()
+{
+    stop();
+}
+
+//---------------------------------------------------------------------------
+
+bool QAnimationPlayer::isAnimated( const QString &path )
+{
+    return probe( path ).animated;
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+void QAnimationPlayer::start( const QString &path, const bool &firstFrameShown )
+{
+    stop();
+
+    m_path = path;
+    m_frameCount = probe( path ).frameCount;
+    m_currentFrame = -1;
+    m_paused = false;
+    m_waiting = true;
+
+    m_thread = new QAnimationDecodeThread( path, m_cacheFrames, firstFrameShown, this );
+    connect( m_thread, &QAnimationDecodeThread::frameReady,
+             this, &QAnimationPlayer::frameReady, Qt::QueuedConnection );
+    connect( m_thread, &QAnimationDecodeThread::failed,
+             this, &QAnimationPlayer::stop, Qt::QueuedConnection );
+    connect( m_thread, &QAnimationDecodeThread::framesCounted,
+             this, &QAnimationPlayer::framesCounted, Qt::QueuedConnection );
+
+    m_clock.start();
+    m_deadline = 0;
+    m_thread->start();
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::stop()
+{
+    m_timer->stop();
+    m_waiting = false;
+
+    if ( m_thread ) {
+        m_thread->disconnect( this );
+        delete m_thread; // aborts and joins
+        m_thread = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::pause()
+{
+    if ( !m_thread || m_paused ) {
+        return;
+    }
+
+    m_paused = true;
+    m_pausedRemaining = qMax < qint64 > ( 0, m_deadline - m_clock.elapsed() );
+    m_timer->stop();
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::resume()
+{
+    if ( !m_thread || !m_paused ) {
+        return;
+    }
+
+    m_paused = false;
+    m_deadline = m_clock.elapsed() + m_pausedRemaining;
+    schedule();
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::seek( const int &frame )
+{
+    if ( !m_thread ) {
+        return;
+    }
+
+    m_thread->seek( m_frameCount > 0 ? qBound( 0, frame, m_frameCount - 1 ) : frame );
+
+    // show the target as soon as it is decoded, even when paused
+    m_timer->stop();
+    m_deadline = m_clock.elapsed();
+    m_waiting = true;
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::setCacheFrames( const int &frames )
+{
+    m_cacheFrames = qMax( 1, frames );
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::showNextFrame()
+{
+    if ( !m_thread ) {
+        return;
+    }
+
+    QAnimationFrame frame;
+    if ( !m_thread->takeFrame( &frame ) ) {
+        m_waiting = true;   // late, frameReady() shows it
+        return;
+    }
+
+    m_waiting = false;
+    m_currentFrame = frame.number;
+    emit frameChanged( frame.image, frame.number );
+
+    const qint64 now = m_clock.elapsed();
+    m_deadline = qMax( m_deadline, now - frame.delay ) + frame.delay; // no catch-up bursts
+
+    if ( !m_paused ) {
+        schedule();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::frameReady()
+{
+    if ( m_waiting && ( !m_paused || m_currentFrame < 0 || m_deadline <= m_clock.elapsed() ) ) {
+        showNextFrame();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::framesCounted( const int &frames )
+{
+    m_frameCount = frames;
+
+    // known for the next visit; one frame is no animation, nothing to play
+    Probe *cached = m_probes.object( m_path );
+    if ( cached ) {
+        cached->frameCount = frames;
+        cached->animated = frames != 1;
+    }
+
+    if ( frames == 1 ) {
+        stop();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QAnimationPlayer::schedule()
+{
+    m_timer->start( int( qMax < qint64 > ( 0, m_deadline - m_clock.elapsed() ) ) );
+}
+
+//---------------------------------------------------------------------------
+
+QAnimationPlayer::Probe QAnimationPlayer::probe( const QString &path )
+{
+    // a stat per navigation, a header read per new file: on the user
+    // interface thread, so never imageCount(), it reads a GIF to its end
+    const QFileInfo info( path );
+    const qint64 lastModified = info.lastModified().toMSecsSinceEpoch();
+    const Probe *cached = m_probes.object( path );
+    if ( cached && cached->size == info.size() && cached->lastModified == lastModified ) {
+        return *cached;
+    }
+
+    Probe *probe = new Probe;
+    probe->size = info.size();
+    probe->lastModified = lastModified;
+    probe->animated = QImageReader( path ).supportsAnimation();
+
+    const Probe result = *probe;
+    m_probes.insert( path, probe );
+    return result;
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,151 @@
+#ifndef QAnimationPlayer_H
+#define QAnimationPlayer_H
+
+#include <QObject>
+#include <QThread>
+#include <QImage>
+#include <QCache>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QTimer>
+#include <QElapsedTimer>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! ANIMATION FRAME
+struct QAnimationFrame
+{
+    QAnimationFrame()
+        : number( -1 ), delay( 0 ) {}
+
+    QImage image;
+    int number;
+    int delay;  // ms to show this frame
+};
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! ANIMATION DECODE THREAD
+//! Streams frames with QImageReader into a small bounded queue. The thread
+//! sleeps while the queue is full, so memory does not depend on the frame
+//! count of the animation. A first frame shown by the caller already is
+//! queued without its image, only its delay.
+class QAnimationDecodeThread : public QThread
+{
+    Q_OBJECT
+
+signals:
+    void frameReady();
+    void failed();
+    // at the first end of the animation; a single frame ends the thread
+    void framesCounted( const int &frames );
+
+public:
+    QAnimationDecodeThread( const QString &path, const int &capacity, const bool &firstFrameShown,
+                            QObject *parent = 0 );
+    ~QAnimationDecodeThread();
+
+    bool takeFrame( QAnimationFrame *frame );   // never blocks
+    void seek( const int &frame );              // drops queued frames
+    void abort();
+
+protected:
+    void run();
+
+private:
+    QString m_path;
+    int m_capacity;
+    bool m_firstFrameShown;
+
+    QMutex m_mutex;
+    QWaitCondition m_notFull;
+    QQueue < QAnimationFrame > m_frames;
+    int m_seekTarget;   // -1 if none
+    int m_seekGeneration;
+    bool m_aborted;
+};
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! ANIMATION PLAYER
+//! Shows frames decoded ahead by QAnimationDecodeThread. Frame times are
+//! absolute deadlines on a monotonic clock, the GUI thread only swaps
+//! already decoded images.
+class QAnimationPlayer : public QObject
+{
+    Q_OBJECT
+
+signals:
+    // frame is null for frame 0 when the caller shows it already
+    void frameChanged( const QImage &frame, const int &number );
+
+public:
+    enum { DefaultCacheFrames = 8 };
+
+    explicit QAnimationPlayer( QObject *parent = 0 );
+    ~QAnimationPlayer();
+
+    // by the format alone, a header read: a file in an animation format
+    // may hold one image, start() finds out off this thread; cached per
+    // path while the file's size and time are unchanged
+    bool isAnimated( const QString &path );
+
+    //! [1] CONTROL
+    // firstFrameShown: the caller shows frame 0 from a decode of its own,
+    // it is neither handed over again nor, where the format allows, decoded
+    void start( const QString &path, const bool &firstFrameShown = false );
+    void stop();
+
+    void pause();
+    void resume();
+    void seek( const int &frame );
+    //! [1]
+
+    //! [2] STATE
+    bool isRunning() const { return m_thread != 0; }
+    bool isPaused() const { return m_paused; }
+    int frameCount() const { return m_frameCount; } // 0 until the first pass ends
+    int currentFrame() const { return m_currentFrame; }
+    //! [2]
+
+    void setCacheFrames( const int &frames );
+    int cacheFrames() const { return m_cacheFrames; }
+
+private slots:
+    void showNextFrame();
+    void frameReady();
+    void framesCounted( const int &frames );
+
+private:
+    struct Probe {
+        Probe()
+            : size( -1 ), lastModified( 0 ), frameCount( 0 ), animated( false ) {}
+
+        qint64 size;
+        qint64 lastModified; // ms since epoch
+        int frameCount;      // 0 until a decode thread counted them
+        bool animated;
+    };
+
+    enum { MaxProbes = 1024 };
+
+    void schedule();
+    Probe probe( const QString &path );
+
+    QCache < QString, Probe > m_probes;
+    QString m_path; // playing
+    QAnimationDecodeThread *m_thread;
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_deadline;  // ms on m_clock
+    bool m_waiting;     // deadline passed, no frame decoded yet
+    bool m_paused;
+    qint64 m_pausedRemaining;
+
+    int m_cacheFrames;
+    int m_frameCount;
+    int m_currentFrame;
+};
+
+#endif // QAnimationPlayer_H
@@ -0,0 +1,114 @@
+#include "qbatchoperation.h"
+#include "qimagewidgetlogging.h"
+#include "qioscheduler.h"
+
+#include <QCoreApplication>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! BATCH OPERATION //!
+QBatchOperation::QBatchOperation( QObject *parent )
+    : QObject( parent ),
+      m_scheduler( QIoScheduler::globalInstance() ),
+      m_total( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QBatchOperation::~QBatchOperation()
+{
+    // a running task still posts to this, wait for it
+    foreach ( const quint64 &task, m_tasks ) {
+        if ( !m_scheduler->cancel( task ) ) {
+            m_scheduler->wait( task );
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+bool QBatchOperation::start( const QStringList &paths, const Operation &operation )
+{
+    if ( isRunning() || paths.isEmpty() ) {
+        return false;
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Batch operation, files:", paths.size() );
+
+    m_total = paths.size();
+    m_succeeded.clear();
+    m_failed.clear();
+
+    QBatchOperation *batch = this;
+    foreach ( const QString &path, paths ) {
+        m_tasks.append( m_scheduler->submit( path, QIoScheduler::Batch, [ batch, path, operation ] () {
+            const bool succeeded = operation( path );
+            QMetaObject::invokeMethod( batch, "fileFinished", Qt::QueuedConnection,
+                                       Q_ARG( QString, path ), Q_ARG( bool, succeeded ) );
+        } ) );
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+void QBatchOperation::cancel()
+{
+    if ( !isRunning() ) {
+        return;
+    }
+
+    // the dropped ones are neither succeeded nor failed
+    foreach ( const quint64 &task, m_tasks ) {
+        if ( m_scheduler->cancel( task ) ) {
+            --m_total;
+        }
+    }
+
+    // none left running, nothing else would finish it
+    if ( m_succeeded.size() + m_failed.size() == m_total ) {
+        fileFinished( QString(), false );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QBatchOperation::waitForFinished()
+{
+    foreach ( const quint64 &task, m_tasks ) {
+        m_scheduler->wait( task );
+    }
+
+    // the results are queued, deliver them now
+    QCoreApplication::sendPostedEvents( this, QEvent::MetaCall );
+}
+
+//---------------------------------------------------------------------------
+
+void QBatchOperation::fileFinished( const QString &path, const bool &succeeded )
+{
+    if ( !path.isNull() ) {
+        ( succeeded ? m_succeeded : m_failed ).append( path );
+    }
+
+    const int done = m_succeeded.size() + m_failed.size();
+    emit progress( done, m_total );
+
+    if ( done < m_total ) {
+        return;
+    }
+
+    const QStringList succeededPaths = m_succeeded;
+    const QStringList failedPaths = m_failed;
+    m_tasks.clear();
+    m_total = 0;
+    m_succeeded.clear();
+    m_failed.clear();
+
+    emit finished( succeededPaths, failedPaths );
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,56 @@
+#ifndef QBatchOperation_H
+#define QBatchOperation_H
+
+#include <QObject>
+#include <QList>
+#include <QStringList>
+
+#include <functional>
+
+class QIoScheduler;
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! BATCH OPERATION
+//! One operation over many files, the files in parallel as Batch work of
+//! the global QIoScheduler: the shown image and its prefetching go first
+//! and a rotational disk is read one file at a time. All files report
+//! through one progress() and one finished().
+class QBatchOperation : public QObject
+{
+    Q_OBJECT
+
+signals:
+    void progress( const int &done, const int &total );
+    void finished( const QStringList &succeeded, const QStringList &failed );
+
+public:
+    // runs on a worker thread, true on success
+    typedef std::function < bool ( const QString &path ) > Operation;
+
+    explicit QBatchOperation( QObject *parent = 0 );
+    ~QBatchOperation(); // files not started are dropped, running ones waited for
+
+    // false while a batch runs
+    bool start( const QStringList &paths, const Operation &operation );
+
+    // files not started are dropped, finished() reports the others
+    void cancel();
+    // and delivers progress() and finished() before returning
+    void waitForFinished();
+
+    bool isRunning() const { return m_total > 0; }
+
+private slots:
+    void fileFinished( const QString &path, const bool &succeeded );
+
+private:
+    QIoScheduler *m_scheduler;
+
+    QList < quint64 > m_tasks;
+    int m_total; // 0 when idle
+    QStringList m_succeeded;
+    QStringList m_failed;
+};
+
+#endif // QBatchOperation_H
@@ -0,0 +1,189 @@
+#include "qdecodequeue.h"
+#include "qimagedecoder.h"
+#include "qimagewidgetlogging.h"
+#include "qioscheduler.h"
+#include "qmappedfile.h"
+
+#include <QElapsedTimer>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! DECODE QUEUE //!
+QDecodeQueue::QDecodeQueue( QObject *parent )
+    : QObject( parent ),
+      m_scheduler( QIoScheduler::globalInstance() ),
+      m_averageDecodeTime( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QDecodeQueue::~QDecodeQueue()
+{
+    // a running task still posts to this, wait for it
+    foreach ( const quint64 &task, m_pending ) {
+        if ( !m_scheduler->cancel( task ) ) {
+            m_scheduler->wait( task );
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+void QDecodeQueue::prefetch( const QStringList &paths )
+{
+    m_wanted = paths;
+
+    // drop what is not wanted any more
+    QHash < QString, Ready >::iterator it = m_ready.begin();
+    while ( it != m_ready.end() ) {
+        if ( m_wanted.contains( it.key() ) ) {
+            ++it;
+        } else {
+            it = m_ready.erase( it );
+        }
+    }
+
+    cancelUnwanted();
+
+    foreach ( const QString &path, m_wanted ) {
+        if ( isReady( path ) || isPending( path ) ) {
+            continue;
+        }
+
+        // the pool may not get to it for a while, the disk can start now
+        QMappedFile::readAhead( path );
+
+        QDecodeQueue *queue = this;
+        m_pending.insert( path, m_scheduler->submit( path, QIoScheduler::Prefetch, [ queue, path ] () {
+            QElapsedTimer timer;
+            timer.start();
+            const QImage image = QImageDecoder::decode( path );
+            QMetaObject::invokeMethod( queue, "jobFinished", Qt::QueuedConnection, Q_ARG( QString, path ),
+                                       Q_ARG( QImage, image ), Q_ARG( qint64, timer.elapsed() ) );
+        } ) );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QDecodeQueue::prioritize( const QString &path )
+{
+    if ( m_pending.contains( path ) ) {
+        m_scheduler->setPriority( m_pending.value( path ), QIoScheduler::Interactive );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QDecodeQueue::clear()
+{
+    m_wanted.clear();
+    m_ready.clear();
+    cancelUnwanted();
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+void QDecodeQueue::jobFinished( const QString &path, const QImage &image, const qint64 &decodeTime )
+{
+    m_pending.remove( path );
+
+    // first sample seeds the average
+    m_averageDecodeTime = m_averageDecodeTime > 0 ? 0.8 * m_averageDecodeTime + 0.2 * decodeTime
+                                                  : decodeTime;
+
+    if ( !m_wanted.contains( path ) ) {
+        emit dropped( path );
+        return;
+    }
+
+    if ( !image.isNull() ) {
+        Ready ready;
+        ready.image = image;
+        ready.decodeTime = decodeTime;
+        ready.readyTime = QMemoryGovernor::now();
+        m_ready.insert( path, ready );
+        grown();
+    }
+
+    emit decoded( path );
+}
+
+//---------------------------------------------------------------------------
+
+//! [3]
+qint64 QDecodeQueue::bytes() const
+{
+    qint64 bytes = 0;
+    foreach ( const Ready &ready, m_ready ) {
+        bytes += ready.image.byteCount();
+    }
+
+    return bytes;
+}
+
+//---------------------------------------------------------------------------
+
+bool QDecodeQueue::candidate( QMemoryGovernor::Candidate *candidate ) const
+{
+    const QString path = lastWantedReady();
+    if ( path.isNull() ) {
+        return false;
+    }
+
+    const Ready ready = m_ready.value( path );
+    candidate->lastUsed = ready.readyTime;
+    candidate->cost = ready.decodeTime;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QDecodeQueue::evict()
+{
+    const QString path = lastWantedReady();
+    if ( path.isNull() ) {
+        return 0;
+    }
+
+    QIW_TRACE( lcImageWidgetPixmap, "Prefetched image evicted." );
+    return m_ready.take( path ).image.byteCount();
+}
+//! [3]
+
+//---------------------------------------------------------------------------
+
+QString QDecodeQueue::lastWantedReady() const
+{
+    // shown last, wanted least
+    for ( int i = m_wanted.size() - 1; i >= 0; --i ) {
+        if ( m_ready.contains( m_wanted.at( i ) ) ) {
+            return m_wanted.at( i );
+        }
+    }
+
+    return QString();
+}
+
+//---------------------------------------------------------------------------
+
+void QDecodeQueue::cancelUnwanted()
+{
+    // not started yet, the scheduler forgets them
+    QHash < QString, quint64 >::iterator it = m_pending.begin();
+    while ( it != m_pending.end() ) {
+        if ( !m_wanted.contains( it.key() ) && m_scheduler->cancel( it.value() ) ) {
+            const QString path = it.key();
+            it = m_pending.erase( it );
+            emit dropped( path );
+        } else {
+            ++it;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
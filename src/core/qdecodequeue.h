@@ -0,0 +1,87 @@
+#ifndef QDecodeQueue_H
+#define QDecodeQueue_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QStringList>
+
+#include "qmemorygovernor.h"
+
+class QIoScheduler;
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! DECODE QUEUE
+//! Decode-ahead of the images that will be shown next. prefetch() names the
+//! wanted paths, decodes of new ones go to the global QIoScheduler as
+//! prefetch work and results of paths no longer wanted are dropped, so
+//! memory is bounded by the window; under a QMemoryGovernor the images
+//! wanted last go first. Keeps a moving average of the decode time to size
+//! it.
+class QDecodeQueue : public QObject, public QMemoryGovernor::Client
+{
+    Q_OBJECT
+
+signals:
+    // also emitted when decoding failed, then isReady() is false
+    void decoded( const QString &path );
+    // a decode cancelled or its result not wanted any more; emitted from
+    // within prefetch() and clear(), connect queued to ask again
+    void dropped( const QString &path );
+
+public:
+    explicit QDecodeQueue( QObject *parent = 0 );
+    ~QDecodeQueue();
+
+    //! [1] REQUESTS
+    // everything not in paths is dropped, decodes not started yet are
+    // cancelled, running ones are let run out
+    void prefetch( const QStringList &paths );
+    void clear();
+
+    // the user waits for path, its decode goes ahead of all prefetching
+    void prioritize( const QString &path );
+    //! [1]
+
+    //! [2] RESULTS
+    bool isReady( const QString &path ) const { return m_ready.contains( path ); }
+    bool isPending( const QString &path ) const { return m_pending.contains( path ); }
+    QImage image( const QString &path ) const { return m_ready.value( path ).image; }
+
+    // ms, exponential moving average, 0 before the first decode
+    double averageDecodeTime() const { return m_averageDecodeTime; }
+    //! [2]
+
+    //! [3] GOVERNOR
+    qint64 bytes() const override;
+    bool candidate( QMemoryGovernor::Candidate *candidate ) const override;
+    qint64 evict() override;
+    //! [3]
+
+private slots:
+    void jobFinished( const QString &path, const QImage &image, const qint64 &decodeTime );
+
+private:
+    struct Ready
+    {
+        Ready() : decodeTime( 0 ), readyTime( 0 ) {}
+
+        QImage image;
+        qint64 decodeTime; // ms
+        qint64 readyTime;  // QMemoryGovernor::now()
+    };
+
+    void cancelUnwanted();
+    QString lastWantedReady() const; // next to evict
+
+    QIoScheduler *m_scheduler;
+
+    QStringList m_wanted;
+    QHash < QString, Ready > m_ready;
+    QHash < QString, quint64 > m_pending; // path, scheduler task
+
+    double m_averageDecodeTime;
+};
+
+#endif // QDecodeQueue_H
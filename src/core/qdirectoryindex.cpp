@@ -0,0 +1,556 @@
+#include "qdirectoryindex.h"
+#include "qimagewidgetlogging.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <QtConcurrent>
+
+#if defined( Q_OS_LINUX ) || defined( Q_OS_BSD4 )
+#define QIW_DIRENT_TYPES
+#endif
+
+#ifdef QIW_DIRENT_TYPES
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const quint32 CacheMagic = 0x51444931; // "QDI1"
+const quint32 CacheVersion = 2;
+
+// a tick of the coarsest file system clocks (FAT)
+const qint64 RacyWindow = Q_INT64_C( 2000000000 ); // ns
+
+// entries are marked used at most this often, not rewritten by every scan
+const qint64 UseResolution = Q_INT64_C( 86400000000000 ); // ns
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! NAME MATCHER //!
+// name filters as QDir matches them; "*.ext" filters, nearly all of them,
+// are compared as suffixes instead of running a wildcard expression
+class NameMatcher
+{
+public:
+    explicit NameMatcher( const QStringList &nameFilters )
+    {
+        foreach ( const QString &filter, nameFilters ) {
+            const QString rest = filter.mid( 1 );
+            if ( filter.startsWith( '*' ) && !rest.contains( QRegExp( "[*?\\[]" ) ) ) {
+                m_suffixes.append( rest );
+            } else {
+                m_patterns.append( QRegExp( filter, Qt::CaseInsensitive, QRegExp::Wildcard ) );
+            }
+        }
+    }
+
+    bool matches( const QString &name ) const
+    {
+        if ( m_suffixes.isEmpty() && m_patterns.isEmpty() ) {
+            return true;
+        }
+
+        foreach ( const QString &suffix, m_suffixes ) {
+            if ( name.endsWith( suffix, Qt::CaseInsensitive ) ) {
+                return true;
+            }
+        }
+
+        foreach ( const QRegExp &pattern, m_patterns ) {
+            if ( pattern.exactMatch( name ) ) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    QStringList m_suffixes;
+    QList < QRegExp > m_patterns;
+};
+
+//---------------------------------------------------------------------------
+
+qint64 now()
+{
+    return QDateTime::currentMSecsSinceEpoch() * 1000000;
+}
+
+//---------------------------------------------------------------------------
+
+// "/" + "a" is "/a", not "//a"
+QString childPrefix( const QString &path )
+{
+    return path.endsWith( '/' ) ? path : path + '/';
+}
+
+#ifdef QIW_DIRENT_TYPES
+//---------------------------------------------------------------------------
+
+qint64 modificationTime( const struct stat &status )
+{
+#ifdef Q_OS_DARWIN
+    return qint64( status.st_mtimespec.tv_sec ) * 1000000000 + status.st_mtimespec.tv_nsec;
+#else
+    return qint64( status.st_mtim.tv_sec ) * 1000000000 + status.st_mtim.tv_nsec;
+#endif
+}
+#endif
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! DIRECTORY INDEX //!
+QDirectoryIndex::QDirectoryIndex()
+    : m_cacheFilePath( defaultCacheFilePath() ),
+      m_dirty( false ),
+      m_bytes( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QDirectoryIndex::QDirectoryIndex( const QString &cacheFilePath )
+    : m_cacheFilePath( cacheFilePath ),
+      m_dirty( false ),
+      m_bytes( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+QStringList QDirectoryIndex::scan( const QString &dirPath, const QStringList &nameFilters, const bool &recursive )
+{
+    struct Work {
+        Work()
+            : cached( false ), exists( false ), read( false ) {}
+
+        QString path;
+        Entry previous;
+        bool cached;
+        Entry entry;
+        bool exists;
+        bool read;
+    };
+
+    const QString root = QDir::cleanPath( QFileInfo( dirPath ).absoluteFilePath() );
+
+    // a level at a time, the directories of a level in parallel; each
+    // costs a stat if unchanged, a read if not
+    QHash < QString, Entry > listings;
+    QStringList level = QStringList() << root;
+    const qint64 scanned = now();
+    int readCount = 0;
+    while ( !level.isEmpty() ) {
+        QVector < Work > work( level.size() );
+        {
+            QMutexLocker locker( &m_mutex );
+            for ( int i = 0; i < level.size(); ++i ) {
+                work[ i ].path = level.at( i );
+                QHash < QString, Entry >::const_iterator it = m_entries.constFind( level.at( i ) );
+                if ( it != m_entries.constEnd() ) {
+                    work[ i ].previous = it.value();
+                    work[ i ].cached = true;
+                }
+            }
+        }
+
+        QtConcurrent::blockingMap( work, [] ( Work &item ) {
+            item.exists = list( item.path, item.cached ? &item.previous : 0, &item.entry, &item.read );
+        } );
+
+        level.clear();
+
+        QMutexLocker locker( &m_mutex );
+        foreach ( const Work &item, work ) {
+            if ( !item.exists ) {
+                removeTree( item.path );
+                continue;
+            }
+
+            const QString prefix = childPrefix( item.path );
+            if ( item.read ) {
+                // directories gone since the last read take their cache along
+                foreach ( const QString &directory, item.previous.directories ) {
+                    if ( !item.entry.directories.contains( directory ) ) {
+                        removeTree( prefix + directory );
+                    }
+                }
+
+                Entry entry = item.entry;
+                entry.lastUsed = scanned;
+                m_entries.insert( item.path, entry );
+                m_dirty = true;
+                m_bytes = -1;
+                ++readCount;
+            } else if ( scanned - item.previous.lastUsed > UseResolution ) {
+                QHash < QString, Entry >::iterator it = m_entries.find( item.path );
+                if ( it != m_entries.end() ) {
+                    it.value().lastUsed = scanned;
+                    m_dirty = true;
+                }
+            }
+
+            listings.insert( item.path, item.entry );
+            if ( recursive ) {
+                foreach ( const QString &directory, item.entry.directories ) {
+                    level.append( prefix + directory );
+                }
+            }
+        }
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Scan, directories:", listings.size() );
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Scan, directories read:", readCount );
+    if ( readCount > 0 ) {
+        grown();
+    }
+
+    // files of a directory, then its subdirectories in order
+    const NameMatcher matcher( nameFilters );
+    QStringList paths;
+    QStringList stack = QStringList() << root;
+    while ( !stack.isEmpty() ) {
+        const QString path = stack.takeLast();
+        QHash < QString, Entry >::const_iterator it = listings.constFind( path );
+        if ( it == listings.constEnd() ) {
+            continue;
+        }
+
+        const QString prefix = childPrefix( path );
+        foreach ( const QString &file, it.value().files ) {
+            if ( matcher.matches( file ) ) {
+                paths.append( prefix + file );
+            }
+        }
+
+        if ( recursive ) {
+            const QStringList &directories = it.value().directories;
+            for ( int i = directories.size() - 1; i >= 0; --i ) {
+                stack.append( prefix + directories.at( i ) );
+            }
+        }
+    }
+
+    return paths;
+}
+
+//---------------------------------------------------------------------------
+
+void QDirectoryIndex::invalidate( const QString &dirPath )
+{
+    QMutexLocker locker( &m_mutex );
+    removeTree( QDir::cleanPath( QFileInfo( dirPath ).absoluteFilePath() ) );
+}
+
+//---------------------------------------------------------------------------
+
+void QDirectoryIndex::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    m_dirty = m_dirty || !m_entries.isEmpty();
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+//---------------------------------------------------------------------------
+
+int QDirectoryIndex::directoryCount() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_entries.size();
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QDirectoryIndex::bytes() const
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_bytes < 0 ) {
+        // the names, their QString headers and the entries, roughly
+        m_bytes = 0;
+        for ( QHash < QString, Entry >::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it ) {
+            qint64 characters = it.key().size();
+            int strings = 1;
+            foreach ( const QString &name, it.value().files + it.value().directories ) {
+                characters += name.size();
+                ++strings;
+            }
+            m_bytes += characters * qint64( sizeof( QChar ) ) + strings * 24 + qint64( sizeof( Entry ) );
+        }
+    }
+
+    return m_bytes;
+}
+
+//---------------------------------------------------------------------------
+
+bool QDirectoryIndex::list( const QString &path, const Entry *cached, Entry *entry, bool *read )
+{
+    *read = false;
+
+#ifdef QIW_DIRENT_TYPES
+    const QByteArray name = QFile::encodeName( path );
+
+    // taken before reading: a change while reading shows next time
+    struct stat status;
+    if ( ::stat( name.constData(), &status ) != 0 || !S_ISDIR( status.st_mode ) ) {
+        return false;
+    }
+
+    const qint64 lastModified = modificationTime( status );
+    if ( cached && !cached->racy && cached->lastModified == lastModified ) {
+        *entry = *cached;
+        return true;
+    }
+
+    DIR *directory = ::opendir( name.constData() );
+    if ( !directory ) {
+        return false;
+    }
+
+    // readdir fills its buffer with getdents, many entries a call; the
+    // types come with the entries, only links and file systems without
+    // types need a stat
+    Entry result;
+    while ( const struct dirent *child = ::readdir( directory ) ) {
+        if ( child->d_name[ 0 ] == '.' ) {
+            continue;
+        }
+
+        unsigned char type = child->d_type;
+        bool link = type == DT_LNK;
+        if ( type == DT_UNKNOWN ) {
+            struct stat childStatus;
+            if ( ::fstatat( ::dirfd( directory ), child->d_name, &childStatus, AT_SYMLINK_NOFOLLOW ) != 0 ) {
+                continue;
+            }
+            link = S_ISLNK( childStatus.st_mode );
+            type = S_ISDIR( childStatus.st_mode ) ? DT_DIR : S_ISREG( childStatus.st_mode ) ? DT_REG : DT_UNKNOWN;
+        }
+
+        // links to files are files, links to directories are not followed
+        if ( link ) {
+            struct stat target;
+            type = ::fstatat( ::dirfd( directory ), child->d_name, &target, 0 ) == 0 && S_ISREG( target.st_mode )
+                   ? DT_REG : DT_UNKNOWN;
+        }
+
+        if ( type == DT_REG ) {
+            result.files.append( QFile::decodeName( child->d_name ) );
+        } else if ( type == DT_DIR ) {
+            result.directories.append( QFile::decodeName( child->d_name ) );
+        }
+    }
+    ::closedir( directory );
+#else
+    const QFileInfo info( path );
+    if ( !info.isDir() ) {
+        return false;
+    }
+
+    const qint64 lastModified = info.lastModified().toMSecsSinceEpoch() * 1000000;
+    if ( cached && !cached->racy && cached->lastModified == lastModified ) {
+        *entry = *cached;
+        return true;
+    }
+
+    Entry result;
+    QDirIterator children( path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot );
+    while ( children.hasNext() ) {
+        children.next();
+        const QFileInfo child = children.fileInfo();
+        if ( child.isFile() ) {
+            result.files.append( child.fileName() );
+        } else if ( child.isDir() && !child.isSymLink() ) {
+            result.directories.append( child.fileName() );
+        }
+    }
+#endif
+
+    result.files.sort();
+    result.directories.sort();
+    result.lastModified = lastModified;
+    result.racy = now() - lastModified < RacyWindow;
+
+    *entry = result;
+    *read = true;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+void QDirectoryIndex::removeTree( const QString &path )
+{
+    if ( m_entries.remove( path ) > 0 ) {
+        m_dirty = true;
+        m_bytes = -1;
+    }
+
+    // subdirectories may be cached from scans of their own
+    const QString prefix = childPrefix( path );
+    QHash < QString, Entry >::iterator it = m_entries.begin();
+    while ( it != m_entries.end() ) {
+        if ( it.key().startsWith( prefix ) ) {
+            it = m_entries.erase( it );
+            m_dirty = true;
+            m_bytes = -1;
+        } else {
+            ++it;
+        }
+    }
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+//! [2]
+QString QDirectoryIndex::defaultCacheFilePath()
+{
+    return QStandardPaths::writableLocation( QStandardPaths::CacheLocation )
+            + "/directories.cache";
+}
+
+//---------------------------------------------------------------------------
+
+bool QDirectoryIndex::load()
+{
+    QFile file( m_cacheFilePath );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    QDataStream stream( &file );
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    stream >> magic >> version >> count;
+    if ( magic != CacheMagic || version != CacheVersion || count < 0 ) {
+        qWarning() << Q_FUNC_INFO << "Wrong directory cache" << m_cacheFilePath;
+        return false;
+    }
+
+    QHash < QString, Entry > entries;
+    entries.reserve( count );
+    for ( qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i ) {
+        QString path;
+        Entry entry;
+        stream >> path >> entry.lastModified >> entry.lastUsed >> entry.racy >> entry.files >> entry.directories;
+        entries.insert( path, entry );
+    }
+
+    if ( stream.status() != QDataStream::Ok ) {
+        return false;
+    }
+
+    QMutexLocker locker( &m_mutex );
+    for ( QHash < QString, Entry >::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it ) {
+        if ( !m_entries.contains( it.key() ) ) {
+            m_entries.insert( it.key(), it.value() );
+        }
+    }
+    m_bytes = -1;
+    locker.unlock();
+
+    grown();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+bool QDirectoryIndex::save() const
+{
+    // written from a snapshot, scans go on meanwhile and mark the index
+    // dirty again
+    QMutexLocker saveLocker( &m_saveMutex );
+    QMutexLocker locker( &m_mutex );
+    if ( !m_dirty ) {
+        return true;
+    }
+    const QHash < QString, Entry > entries = m_entries;
+    m_dirty = false;
+    locker.unlock();
+
+    QDir().mkpath( QFileInfo( m_cacheFilePath ).absolutePath() );
+
+    QSaveFile file( m_cacheFilePath );
+    bool written = file.open( QIODevice::WriteOnly );
+    if ( written ) {
+        QDataStream stream( &file );
+        stream << CacheMagic << CacheVersion << qint32( entries.size() );
+        for ( QHash < QString, Entry >::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it ) {
+            stream << it.key() << it.value().lastModified << it.value().lastUsed << it.value().racy
+                   << it.value().files << it.value().directories;
+        }
+        written = file.commit();
+    }
+
+    if ( !written ) {
+        qWarning() << Q_FUNC_INFO << "Cannot write" << m_cacheFilePath;
+        locker.relock();
+        m_dirty = true;
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+int QDirectoryIndex::prune( const int &maxAgeDays )
+{
+    const qint64 oldest = now() - qint64( maxAgeDays ) * UseResolution;
+
+    QStringList paths;
+    {
+        QMutexLocker locker( &m_mutex );
+        paths = m_entries.keys();
+    }
+
+    // stat'ed without the lock, scans go on meanwhile
+    const QStringList gone = QtConcurrent::blockingFiltered( paths, [] ( const QString &path ) {
+        return !QFileInfo( path ).isDir();
+    } );
+
+    QMutexLocker locker( &m_mutex );
+    int count = 0;
+    foreach ( const QString &path, gone ) {
+        count += m_entries.remove( path );
+    }
+
+    QHash < QString, Entry >::iterator it = m_entries.begin();
+    while ( it != m_entries.end() ) {
+        if ( it.value().lastUsed < oldest ) {
+            it = m_entries.erase( it );
+            ++count;
+        } else {
+            ++it;
+        }
+    }
+
+    if ( count > 0 ) {
+        m_dirty = true;
+        m_bytes = -1;
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Directory index, pruned:", count );
+    return count;
+}
+//! [2]
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+#ifndef QDirectoryIndex_H
+#define QDirectoryIndex_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+
+#include "qmemorygovernor.h"
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! DIRECTORY INDEX
+//! Listings of directories, kept per path and validated by the directory
+//! modification time: adding, removing or renaming an entry changes it,
+//! so a directory whose time is unchanged is not read again and rescanning
+//! an unchanged tree costs one stat per directory. Trees are walked a level
+//! at a time, the directories of a level in parallel; file types come from
+//! the directory entries, files are not stat'ed. Persisted to a cache
+//! file, loading and saving are safe beside scans and may run off the
+//! user interface thread; directories gone or unscanned for long are
+//! pruned. Thread safe; counted by a QMemoryGovernor, never evicted.
+class QDirectoryIndex : public QMemoryGovernor::Client
+{
+public:
+    QDirectoryIndex();
+    explicit QDirectoryIndex( const QString &cacheFilePath );
+
+    //! [1] SCANNING
+    // files of dirPath matching nameFilters (case insensitive, like
+    // QDir), each directory's files sorted and before its subdirectories;
+    // hidden entries are skipped and symbolic links to directories not
+    // followed, as QDirIterator does; blocking
+    QStringList scan( const QString &dirPath, const QStringList &nameFilters,
+                      const bool &recursive = true );
+
+    // reads dirPath and what is under it again on the next scan
+    void invalidate( const QString &dirPath );
+    void clear();
+
+    int directoryCount() const;
+    qint64 bytes() const override;
+    //! [1]
+
+    //! [2] PERSISTENCE
+    static QString defaultCacheFilePath();
+
+    bool load();
+    bool save() const;
+
+    // drops directories gone and those not scanned for maxAgeDays, a stat
+    // each; the count dropped
+    int prune( const int &maxAgeDays = MaxAgeDays );
+    //! [2]
+
+    enum { MaxAgeDays = 90 };
+
+private:
+    struct Entry {
+        Entry()
+            : lastModified( -1 ), lastUsed( 0 ), racy( false ) {}
+
+        qint64 lastModified; // ns since epoch
+        qint64 lastUsed;     // ns since epoch of a scan through it, by the day
+        // modified too close to the read, a change in the same clock tick
+        // would go unnoticed; read again next time
+        bool racy;
+        QStringList files;       // names, sorted
+        QStringList directories; // names, sorted
+    };
+
+    // the listing of path, read if stale; false if it is no directory
+    static bool list( const QString &path, const Entry *cached, Entry *entry, bool *read );
+
+    // with m_mutex locked; path and what is under it
+    void removeTree( const QString &path );
+
+    QString m_cacheFilePath;
+
+    mutable QMutex m_mutex;
+    // held through a save, snapshots are written in the order taken
+    mutable QMutex m_saveMutex;
+    QHash < QString, Entry > m_entries; // absolute clean paths
+    mutable bool m_dirty; // entries changed since load() or save()
+    mutable qint64 m_bytes; // of m_entries, -1 until counted again
+};
+
+#endif // QDirectoryIndex_H
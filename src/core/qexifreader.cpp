@@ -0,0 +1,513 @@
+#include "qexifreader.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QtEndian>
+
+namespace {
+
+// APP1 normally follows SOI directly, do not search past this offset
+const qint64 HeaderReadSize = 128 * 1024;
+
+enum Tag {
+    TagOrientation = 0x0112,
+    TagDateTime = 0x0132,
+    TagExifIfd = 0x8769,
+    TagDateTimeOriginal = 0x9003,
+    TagDateTimeDigitized = 0x9004,
+    TagThumbnailOffset = 0x0201,    // JPEGInterchangeFormat, in IFD1
+    TagThumbnailLength = 0x0202
+};
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! TIFF STRUCTURE //!
+class TiffReader
+{
+public:
+    TiffReader( const uchar *data, const int &size )
+        : m_data( data ), m_size( size ), m_bigEndian( false ) {}
+
+    bool readHeader( quint32 *firstIfd ) {
+        if ( m_size < 8 ) {
+            return false;
+        }
+
+        if ( m_data[ 0 ] == 'M' && m_data[ 1 ] == 'M' ) {
+            m_bigEndian = true;
+        } else if ( m_data[ 0 ] != 'I' || m_data[ 1 ] != 'I' ) {
+            return false;
+        }
+
+        if ( u16( 2 ) != 42 ) {
+            return false;
+        }
+
+        *firstIfd = u32( 4 );
+        return true;
+    }
+
+    int entriesCount( const quint32 &ifd ) const {
+        if ( !fits( ifd, 2 ) ) {
+            return 0;
+        }
+
+        const int count = u16( ifd );
+        return fits( ifd + 2, quint32( count ) * 12 ) ? count : 0;
+    }
+
+    // 0 after the last IFD
+    quint32 nextIfd( const quint32 &ifd ) const {
+        const int count = entriesCount( ifd );
+        return count ? u32( ifd + 2 + count * 12 ) : 0;
+    }
+
+    // the 12 bytes of an entry as stored
+    QByteArray entry( const quint32 &ifd, const int &entry ) const {
+        return bytes( ifd + 2 + entry * 12, 12 );
+    }
+
+    quint16 tag( const quint32 &ifd, const int &entry ) const {
+        return u16( ifd + 2 + entry * 12 );
+    }
+
+    // 3 SHORT, 4 LONG...
+    quint16 type( const quint32 &ifd, const int &entry ) const {
+        return u16( ifd + 2 + entry * 12 + 2 );
+    }
+
+    quint32 count( const quint32 &ifd, const int &entry ) const {
+        return u32( ifd + 2 + entry * 12 + 4 );
+    }
+
+    // where an inline value starts, relative to the TIFF header
+    quint32 valueOffset( const quint32 &ifd, const int &entry ) const {
+        return ifd + 2 + entry * 12 + 8;
+    }
+
+    bool isBigEndian() const {
+        return m_bigEndian;
+    }
+
+    // SHORT or LONG value stored inline
+    quint32 value( const quint32 &ifd, const int &entry ) const {
+        const quint32 offset = ifd + 2 + entry * 12;
+        return u16( offset + 2 ) == 3 ? u16( offset + 8 ) : u32( offset + 8 );
+    }
+
+    QString string( const quint32 &ifd, const int &entry ) const {
+        const quint32 offset = ifd + 2 + entry * 12;
+        const quint32 count = u32( offset + 4 );
+        const quint32 position = count <= 4 ? offset + 8 : u32( offset + 8 );
+        if ( u16( offset + 2 ) != 2 || !fits( position, count ) ) {
+            return QString();
+        }
+
+        return QString::fromLatin1( reinterpret_cast < const char * > ( m_data + position ),
+                                    qstrnlen( reinterpret_cast < const char * > ( m_data + position ), count ) );
+    }
+
+    QByteArray bytes( const quint32 &offset, const quint32 &length ) const {
+        if ( !length || !fits( offset, length ) ) {
+            return QByteArray();
+        }
+
+        return QByteArray( reinterpret_cast < const char * > ( m_data + offset ), int( length ) );
+    }
+
+private:
+    bool fits( const quint32 &offset, const quint32 &length ) const {
+        return quint64( offset ) + length <= quint64( m_size );
+    }
+
+    quint16 u16( const quint32 &offset ) const {
+        if ( !fits( offset, 2 ) ) {
+            return 0;
+        }
+
+        const uchar *p = m_data + offset;
+        return m_bigEndian ? quint16( p[ 0 ] << 8 | p[ 1 ] )
+                           : quint16( p[ 1 ] << 8 | p[ 0 ] );
+    }
+
+    quint32 u32( const quint32 &offset ) const {
+        if ( !fits( offset, 4 ) ) {
+            return 0;
+        }
+
+        const uchar *p = m_data + offset;
+        return m_bigEndian ? quint32( p[ 0 ] ) << 24 | quint32( p[ 1 ] ) << 16 | quint32( p[ 2 ] ) << 8 | p[ 3 ]
+                           : quint32( p[ 3 ] ) << 24 | quint32( p[ 2 ] ) << 16 | quint32( p[ 1 ] ) << 8 | p[ 0 ];
+    }
+
+    const uchar *m_data;
+    int m_size;
+    bool m_bigEndian;
+};
+
+//---------------------------------------------------------------------------
+
+QDateTime exifDateTime( const QString &value )
+{
+    return QDateTime::fromString( value.left( 19 ), "yyyy:MM:dd HH:mm:ss" );
+}
+
+//---------------------------------------------------------------------------
+
+void parseTiff( const uchar *data, const int &size, QExifData *exif )
+{
+    TiffReader tiff( data, size );
+
+    quint32 ifd0 = 0;
+    if ( !tiff.readHeader( &ifd0 ) ) {
+        return;
+    }
+
+    quint32 exifIfd = 0;
+    QDateTime dateTime;
+    for ( int i = 0; i < tiff.entriesCount( ifd0 ); ++i ) {
+        switch ( tiff.tag( ifd0, i ) ) {
+        case TagOrientation:
+            exif->orientation = int( tiff.value( ifd0, i ) );
+            if ( exif->orientation < 1 || exif->orientation > 8 ) {
+                exif->orientation = 1;
+            }
+            break;
+        case TagDateTime:
+            dateTime = exifDateTime( tiff.string( ifd0, i ) );
+            break;
+        case TagExifIfd:
+            exifIfd = tiff.value( ifd0, i );
+            break;
+        }
+    }
+
+    QDateTime digitized;
+    for ( int i = 0; exifIfd && i < tiff.entriesCount( exifIfd ); ++i ) {
+        switch ( tiff.tag( exifIfd, i ) ) {
+        case TagDateTimeOriginal:
+            exif->captureTime = exifDateTime( tiff.string( exifIfd, i ) );
+            break;
+        case TagDateTimeDigitized:
+            digitized = exifDateTime( tiff.string( exifIfd, i ) );
+            break;
+        }
+    }
+
+    if ( !exif->captureTime.isValid() ) {
+        exif->captureTime = digitized.isValid() ? digitized : dateTime;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+// IFD1 describes the embedded thumbnail, a complete JPEG inside the TIFF data
+QByteArray parseTiffThumbnail( const uchar *data, const int &size )
+{
+    TiffReader tiff( data, size );
+
+    quint32 ifd0 = 0;
+    if ( !tiff.readHeader( &ifd0 ) ) {
+        return QByteArray();
+    }
+
+    const quint32 ifd1 = tiff.nextIfd( ifd0 );
+    quint32 offset = 0;
+    quint32 length = 0;
+    for ( int i = 0; ifd1 && i < tiff.entriesCount( ifd1 ); ++i ) {
+        switch ( tiff.tag( ifd1, i ) ) {
+        case TagThumbnailOffset:
+            offset = tiff.value( ifd1, i );
+            break;
+        case TagThumbnailLength:
+            length = tiff.value( ifd1, i );
+            break;
+        }
+    }
+
+    const QByteArray thumbnail = tiff.bytes( offset, length );
+    if ( thumbnail.size() < 4 || uchar( thumbnail.at( 0 ) ) != 0xFF || uchar( thumbnail.at( 1 ) ) != 0xD8 ) {
+        return QByteArray();
+    }
+
+    return thumbnail;
+}
+
+//---------------------------------------------------------------------------
+
+// SOI, the EXIF APP1 segment header and its payload, which starts at
+// payloadOffset in the file
+QByteArray readJpegHeader( const QString &path, qint64 *payloadOffset = 0 )
+{
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return QByteArray();
+    }
+
+    // hop over the segment headers, only APP1 itself is read
+    QByteArray header = file.read( 2 );
+    if ( header.size() != 2 || uchar( header.at( 0 ) ) != 0xFF || uchar( header.at( 1 ) ) != 0xD8 ) {
+        return QByteArray();
+    }
+
+    while ( file.pos() < HeaderReadSize ) {
+        const QByteArray segment = file.read( 4 );
+        if ( segment.size() != 4 || uchar( segment.at( 0 ) ) != 0xFF ) {
+            break;
+        }
+
+        const uchar marker = uchar( segment.at( 1 ) );
+        const int length = uchar( segment.at( 2 ) ) << 8 | uchar( segment.at( 3 ) );
+        if ( marker == 0xDA || marker == 0xD9 || length < 2 ) {
+            break;
+        }
+
+        if ( marker == 0xE1 ) {
+            if ( payloadOffset ) {
+                *payloadOffset = file.pos();
+            }
+            const QByteArray payload = file.read( length - 2 );
+            if ( payload.startsWith( QByteArray( "Exif\0\0", 6 ) ) ) {
+                return header + segment + payload;
+            }
+        } else if ( !file.seek( file.pos() + length - 2 ) ) {
+            break;
+        }
+    }
+
+    return QByteArray();
+}
+
+//---------------------------------------------------------------------------
+
+// the TIFF data of the EXIF APP1 segment, false without one
+bool findTiff( const QByteArray &jpegHeader, const uchar **tiff, int *tiffSize )
+{
+    const uchar *data = reinterpret_cast < const uchar * > ( jpegHeader.constData() );
+    const int size = jpegHeader.size();
+    if ( size < 4 || data[ 0 ] != 0xFF || data[ 1 ] != 0xD8 ) {
+        return false;
+    }
+
+    // walk the marker segments up to the start of scan
+    int position = 2;
+    while ( position + 4 <= size ) {
+        if ( data[ position ] != 0xFF ) {
+            break;
+        }
+
+        const uchar marker = data[ position + 1 ];
+        if ( marker == 0xFF ) {         // fill byte
+            position++;
+            continue;
+        }
+        if ( marker == 0xDA || marker == 0xD9 ) {   // SOS, EOI
+            break;
+        }
+
+        const int length = data[ position + 2 ] << 8 | data[ position + 3 ];
+        if ( length < 2 ) {
+            break;
+        }
+
+        if ( marker == 0xE1 && length >= 8 && position + 2 + length <= size
+             && qstrncmp( reinterpret_cast < const char * > ( data + position + 4 ), "Exif", 5 ) == 0 ) {
+            *tiff = data + position + 10;
+            *tiffSize = length - 8;
+            return true;
+        }
+
+        position += 2 + length;
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+
+// IFD0 of tiff with the Orientation entry, written after the TIFF data; the
+// old IFD0 stays where it is, unreferenced, so no other offset changes
+QByteArray relocatedIfd0( const uchar *data, const int &size, const int &orientation )
+{
+    TiffReader tiff( data, size );
+
+    quint32 ifd0 = 0;
+    if ( !tiff.readHeader( &ifd0 ) || !tiff.entriesCount( ifd0 ) ) {
+        return QByteArray();
+    }
+
+    QByteArray result( reinterpret_cast < const char * > ( data ), size );
+
+    // IFDs start on a word boundary
+    if ( result.size() % 2 ) {
+        result.append( char( 0 ) );
+    }
+    const quint32 newIfd0 = quint32( result.size() );
+
+    QDataStream stream( &result, QIODevice::WriteOnly | QIODevice::Append );
+    stream.setByteOrder( tiff.isBigEndian() ? QDataStream::BigEndian : QDataStream::LittleEndian );
+
+    // entries stay sorted by tag
+    const int count = tiff.entriesCount( ifd0 );
+    stream << quint16( count + 1 );
+    bool added = false;
+    for ( int i = 0; i < count; ++i ) {
+        if ( !added && tiff.tag( ifd0, i ) > TagOrientation ) {
+            stream << quint16( TagOrientation ) << quint16( 3 ) << quint32( 1 ) << quint16( orientation ) << quint16( 0 );
+            added = true;
+        }
+        const QByteArray entry = tiff.entry( ifd0, i );
+        stream.writeRawData( entry.constData(), entry.size() );
+    }
+    if ( !added ) {
+        stream << quint16( TagOrientation ) << quint16( 3 ) << quint32( 1 ) << quint16( orientation ) << quint16( 0 );
+    }
+    stream << tiff.nextIfd( ifd0 );
+
+    // the header points to the new IFD0
+    uchar *firstIfd = reinterpret_cast < uchar * > ( result.data() ) + 4;
+    if ( tiff.isBigEndian() ) {
+        qToBigEndian( newIfd0, firstIfd );
+    } else {
+        qToLittleEndian( newIfd0, firstIfd );
+    }
+
+    return result;
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! EXIF READER //!
+QExifData QExifReader::read( const QString &path )
+{
+    const QByteArray header = readJpegHeader( path );
+    return header.isEmpty() ? QExifData() : parse( header );
+}
+
+//---------------------------------------------------------------------------
+
+QExifData QExifReader::parse( const QByteArray &jpegHeader )
+{
+    QExifData exif;
+
+    const uchar *tiff = 0;
+    int tiffSize = 0;
+    if ( findTiff( jpegHeader, &tiff, &tiffSize ) ) {
+        parseTiff( tiff, tiffSize, &exif );
+    }
+
+    return exif;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QExifReader::orientationOffset( const QString &path, bool *bigEndian )
+{
+    qint64 payloadOffset = 0;
+    const QByteArray header = readJpegHeader( path, &payloadOffset );
+
+    const uchar *tiff = 0;
+    int tiffSize = 0;
+    if ( header.isEmpty() || !findTiff( header, &tiff, &tiffSize ) ) {
+        return -1;
+    }
+
+    TiffReader reader( tiff, tiffSize );
+    quint32 ifd0 = 0;
+    if ( !reader.readHeader( &ifd0 ) ) {
+        return -1;
+    }
+
+    for ( int i = 0; i < reader.entriesCount( ifd0 ); ++i ) {
+        if ( reader.tag( ifd0, i ) == TagOrientation && reader.type( ifd0, i ) == 3 && reader.count( ifd0, i ) == 1 ) {
+            // the payload follows SOI and the 4 byte segment header in header
+            const qint64 tiffOffset = payloadOffset + ( tiff - reinterpret_cast < const uchar * > ( header.constData() ) ) - 6;
+            *bigEndian = reader.isBigEndian();
+            return tiffOffset + reader.valueOffset( ifd0, i );
+        }
+    }
+
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+
+QByteArray QExifReader::thumbnail( const QString &path )
+{
+    const QByteArray header = readJpegHeader( path );
+    return header.isEmpty() ? QByteArray() : parseThumbnail( header );
+}
+
+//---------------------------------------------------------------------------
+
+QByteArray QExifReader::parseThumbnail( const QByteArray &jpegHeader )
+{
+    const uchar *tiff = 0;
+    int tiffSize = 0;
+    if ( !findTiff( jpegHeader, &tiff, &tiffSize ) ) {
+        return QByteArray();
+    }
+
+    return parseTiffThumbnail( tiff, tiffSize );
+}
+
+//---------------------------------------------------------------------------
+
+QByteArray QExifReader::withOrientation( const QByteArray &jpeg, const int &orientation )
+{
+    const uchar *data = reinterpret_cast < const uchar * > ( jpeg.constData() );
+    const int size = jpeg.size();
+    if ( size < 4 || data[ 0 ] != 0xFF || data[ 1 ] != 0xD8 || orientation < 1 || orientation > 8 ) {
+        return QByteArray();
+    }
+
+    // APP1 goes after a leading JFIF APP0, as the format requires
+    int insertAt = 2;
+    int position = 2;
+    while ( position + 4 <= size && data[ position ] == 0xFF ) {
+        const uchar marker = data[ position + 1 ];
+        if ( marker == 0xDA || marker == 0xD9 ) {
+            break;
+        }
+
+        const int length = data[ position + 2 ] << 8 | data[ position + 3 ];
+        if ( length < 2 || position + 2 + length > size ) {
+            return QByteArray();
+        }
+
+        if ( marker == 0xE1 && length >= 8
+             && qstrncmp( reinterpret_cast < const char * > ( data + position + 4 ), "Exif", 5 ) == 0 ) {
+            const QByteArray tiff = relocatedIfd0( data + position + 10, length - 8, orientation );
+            const int newLength = tiff.size() + 8;
+            if ( tiff.isEmpty() || newLength > 0xFFFF ) {
+                return QByteArray();
+            }
+
+            QByteArray result = jpeg.left( position + 2 );
+            result.append( char( newLength >> 8 ) ).append( char( newLength & 0xFF ) );
+            result.append( "Exif\0\0", 6 ).append( tiff );
+            result.append( jpeg.mid( position + 2 + length ) );
+            return result;
+        }
+
+        if ( marker == 0xE0 && position == insertAt ) {
+            insertAt = position + 2 + length;
+        }
+        position += 2 + length;
+    }
+
+    // no EXIF: a big endian TIFF with IFD0 holding the one entry
+    QByteArray segment;
+    QDataStream stream( &segment, QIODevice::WriteOnly );
+    stream << quint16( 0xFFE1 ) << quint16( 34 );
+    stream.writeRawData( "Exif\0\0MM", 8 );
+    stream << quint16( 42 ) << quint32( 8 )
+           << quint16( 1 ) << quint16( TagOrientation ) << quint16( 3 ) << quint32( 1 ) << quint16( orientation ) << quint16( 0 )
+           << quint32( 0 );
+
+    return jpeg.left( insertAt ) + segment + jpeg.mid( insertAt );
+}
+
+//---------------------------------------------------------------------------
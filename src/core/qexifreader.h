@@ -0,0 +1,47 @@
+#ifndef QExifReader_H
+#define QExifReader_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! EXIF DATA
+struct QExifData
+{
+    QExifData()
+        : orientation( 1 ) {}
+
+    int orientation;        // 1..8, as in the EXIF Orientation tag
+    QDateTime captureTime;  // DateTimeOriginal, DateTimeDigitized or DateTime
+};
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! EXIF READER
+//! Minimal JPEG APP1/TIFF parser. Reads only the file header, never decodes
+//! pixels, and is safe to call from worker threads.
+class QExifReader
+{
+public:
+    static QExifData read( const QString &path );
+    static QExifData parse( const QByteArray &jpegHeader );
+
+    // file offset of the Orientation value, a SHORT in the byte order
+    // bigEndian is set to; -1 if the file has no such tag
+    static qint64 orientationOffset( const QString &path, bool *bigEndian );
+    // the whole JPEG file with the Orientation tag set, added to IFD0 or in
+    // a new APP1 segment if missing; the scan data is not touched; empty if
+    // it is no JPEG or IFD0 does not fit the segment
+    static QByteArray withOrientation( const QByteArray &jpeg, const int &orientation );
+
+    // the embedded JPEG thumbnail, usually 160x120, empty if there is none
+    static QByteArray thumbnail( const QString &path );
+    static QByteArray parseThumbnail( const QByteArray &jpegHeader );
+
+private:
+    QExifReader() {}
+};
+
+#endif // QExifReader_H
@@ -0,0 +1,207 @@
+#include "qfileremover.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStorageInfo>
+#include <QUrl>
+
+#if defined( Q_OS_UNIX ) && !defined( Q_OS_DARWIN ) && !defined( Q_OS_ANDROID )
+#define QIW_FREEDESKTOP_TRASH
+#endif
+
+#ifdef QIW_FREEDESKTOP_TRASH
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef QIW_FREEDESKTOP_TRASH
+// device of path, of its nearest existing directory if it does not exist
+bool deviceOf( const QString &path, dev_t *device )
+{
+    QString existing = path;
+    forever {
+        struct stat status;
+        if ( ::lstat( QFile::encodeName( existing ).constData(), &status ) == 0 ) {
+            *device = status.st_dev;
+            return true;
+        }
+
+        const QString parent = QFileInfo( existing ).absolutePath();
+        if ( parent == existing ) {
+            return false;
+        }
+        existing = parent;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+// a directory only its owner can use, false if path is something else
+bool makeTrashDirectory( const QString &path )
+{
+    const QByteArray name = QFile::encodeName( path );
+    if ( ::mkdir( name.constData(), 0700 ) == 0 ) {
+        return true;
+    }
+
+    struct stat status;
+    return errno == EEXIST && ::lstat( name.constData(), &status ) == 0 && S_ISDIR( status.st_mode );
+}
+
+//---------------------------------------------------------------------------
+
+// trash directory for path, infoPath is the Path= value of its trashinfo
+QString trashDirectory( const QString &path, QString *infoPath )
+{
+    QString dataHome = QFile::decodeName( qgetenv( "XDG_DATA_HOME" ) );
+    if ( dataHome.isEmpty() ) {
+        dataHome = QDir::homePath() + "/.local/share";
+    }
+
+    dev_t pathDevice;
+    dev_t homeDevice;
+    if ( !deviceOf( path, &pathDevice ) ) {
+        return QString();
+    }
+
+    // home trash, absolute paths
+    if ( deviceOf( dataHome, &homeDevice ) && homeDevice == pathDevice ) {
+        *infoPath = path;
+
+        const QString trash = dataHome + "/Trash";
+        QDir().mkpath( dataHome );
+        return makeTrashDirectory( trash ) ? trash : QString();
+    }
+
+    // top directory trash, paths relative to the mount
+    QString topDir = QStorageInfo( QFileInfo( path ).absolutePath() ).rootPath();
+    if ( topDir.isEmpty() ) {
+        return QString();
+    }
+    if ( topDir.endsWith( '/' ) ) {
+        topDir.chop( 1 );
+    }
+    *infoPath = path.mid( topDir.size() + 1 );
+
+    const QString uid = QString::number( ::getuid() );
+
+    // the shared one is only trusted if an administrator made it sticky
+    const QString shared = topDir + "/.Trash";
+    struct stat status;
+    if ( ::lstat( QFile::encodeName( shared ).constData(), &status ) == 0
+         && S_ISDIR( status.st_mode ) && ( status.st_mode & S_ISVTX ) ) {
+        const QString trash = shared + "/" + uid;
+        if ( makeTrashDirectory( trash ) ) {
+            return trash;
+        }
+    }
+
+    const QString trash = topDir + "/.Trash-" + uid;
+    return makeTrashDirectory( trash ) ? trash : QString();
+}
+
+//---------------------------------------------------------------------------
+
+// "photo.jpg", "photo.2.jpg", "photo.3.jpg"...
+QString trashName( const QFileInfo &info, const int &number )
+{
+    if ( number == 1 ) {
+        return info.fileName();
+    }
+
+    if ( info.completeBaseName().isEmpty() || info.suffix().isEmpty() ) {
+        return QString( "%1.%2" ).arg( info.fileName() ).arg( number );
+    }
+
+    return QString( "%1.%2.%3" ).arg( info.completeBaseName() ).arg( number ).arg( info.suffix() );
+}
+#endif
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! FILE REMOVER //!
+QFileRemover::Result QFileRemover::remove( const QStringList &paths, const bool &toTrash )
+{
+    Result result;
+    foreach ( const QString &path, paths ) {
+        const bool removed = toTrash ? moveToTrash( path ) : QFile::remove( path );
+        if ( removed ) {
+            result.removed.append( path );
+        } else {
+            qWarning() << Q_FUNC_INFO << "Cannot remove" << path;
+            result.failed.append( path );
+        }
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+bool QFileRemover::moveToTrash( const QString &path )
+{
+#ifdef QIW_FREEDESKTOP_TRASH
+    const QFileInfo info( path );
+    const QString absolutePath = info.absoluteFilePath();
+    if ( !info.exists() && !info.isSymLink() ) {
+        return false;
+    }
+
+    QString infoPath;
+    const QString trash = trashDirectory( absolutePath, &infoPath );
+    if ( trash.isEmpty()
+         || !makeTrashDirectory( trash + "/files" )
+         || !makeTrashDirectory( trash + "/info" ) ) {
+        return false;
+    }
+
+    // the trashinfo file reserves the name, another process may be
+    // trashing a file of the same name right now
+    QString name;
+    QString trashInfo;
+    int descriptor = -1;
+    for ( int number = 1; descriptor < 0 && number < 10000; ++number ) {
+        name = trashName( info, number );
+        trashInfo = trash + "/info/" + name + ".trashinfo";
+        descriptor = ::open( QFile::encodeName( trashInfo ).constData(), O_WRONLY | O_CREAT | O_EXCL, 0600 );
+        if ( descriptor < 0 && errno != EEXIST ) {
+            return false;
+        }
+    }
+
+    if ( descriptor < 0 ) {
+        return false;
+    }
+
+    const QByteArray content = "[Trash Info]\nPath=" + QUrl::toPercentEncoding( infoPath, "/" )
+                               + "\nDeletionDate=" + QDateTime::currentDateTime().toString( "yyyy-MM-ddThh:mm:ss" ).toLatin1()
+                               + "\n";
+    const bool written = ::write( descriptor, content.constData(), size_t( content.size() ) ) == content.size();
+    ::close( descriptor );
+
+    // same device, so a rename; an info file without its file is invalid
+    if ( !written || ::rename( QFile::encodeName( absolutePath ).constData(),
+                               QFile::encodeName( trash + "/files/" + name ).constData() ) != 0 ) {
+        ::unlink( QFile::encodeName( trashInfo ).constData() );
+        return false;
+    }
+
+    return true;
+#elif QT_VERSION >= QT_VERSION_CHECK( 5, 15, 0 )
+    return QFile::moveToTrash( path );
+#else
+    Q_UNUSED( path );
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,35 @@
+#ifndef QFileRemover_H
+#define QFileRemover_H
+
+#include <QString>
+#include <QStringList>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! FILE REMOVER
+//! Deletes batches of files, permanently or into the trash. Blocking, meant
+//! for a worker thread. The trash is the freedesktop.org one on Linux and
+//! the other X11 systems: the home trash for files on the device of the
+//! home data directory, the trash at the top of their mount otherwise, so
+//! trashing is a rename and never copies. A file that cannot be trashed is
+//! left in place, it is never deleted for good instead.
+class QFileRemover
+{
+public:
+    struct Result
+    {
+        QStringList removed;
+        QStringList failed;
+    };
+
+    static Result remove( const QStringList &paths, const bool &toTrash );
+
+    // false where there is no trash, QFile::moveToTrash() is used on the
+    // other systems with Qt 5.15
+    static bool moveToTrash( const QString &path );
+
+private:
+    QFileRemover() {}
+};
+
+#endif // QFileRemover_H
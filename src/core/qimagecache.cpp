@@ -0,0 +1,196 @@
+#include "qimagecache.h"
+#include "qimagedecoder.h"
+
+#include <QElapsedTimer>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE CACHE //!
+QImageCache::QImageCache( const qint64 &maxBytes )
+    : m_bytes( 0 ),
+      m_maxBytes( 0 )
+{
+    setMaxBytes( maxBytes );
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+QImage QImageCache::image( const QString &path )
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        QHash < QString, Entry >::const_iterator it = m_entries.constFind( path );
+        if ( it != m_entries.constEnd() ) {
+            it->lastUsed = QMemoryGovernor::now();
+            return it->image;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QImage image = QImageDecoder::decode( path );
+    if ( !image.isNull() ) {
+        insert( path, image, timer.elapsed() );
+    }
+
+    return image;
+}
+
+//---------------------------------------------------------------------------
+
+QImage QImageCache::cachedImage( const QString &path ) const
+{
+    QMutexLocker locker( &m_mutex );
+    QHash < QString, Entry >::const_iterator it = m_entries.constFind( path );
+    if ( it == m_entries.constEnd() ) {
+        return QImage();
+    }
+
+    it->lastUsed = QMemoryGovernor::now();
+    return it->image;
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageCache::contains( const QString &path ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_entries.contains( path );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCache::insert( const QString &path, const QImage &image, const qint64 &cost )
+{
+    {
+        QMutexLocker locker( &m_mutex );
+
+        Entry entry;
+        entry.image = image;
+        entry.bytes = image.byteCount();
+        entry.cost = cost >= 0 ? cost : QMemoryGovernor::estimatedCost( entry.bytes );
+        entry.lastUsed = QMemoryGovernor::now();
+
+        // as QCache did, what alone exceeds the limit is not kept
+        m_bytes -= m_entries.value( path ).bytes;
+        m_entries.remove( path );
+        if ( entry.bytes > m_maxBytes ) {
+            return;
+        }
+
+        m_entries.insert( path, entry );
+        m_bytes += entry.bytes;
+        while ( m_bytes > m_maxBytes ) {
+            evictLeastRecentlyUsed();
+        }
+    }
+
+    grown(); // outside the lock, the governor may call evict()
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCache::remove( const QString &path )
+{
+    QMutexLocker locker( &m_mutex );
+    m_bytes -= m_entries.value( path ).bytes;
+    m_entries.remove( path );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCache::clear()
+{
+    QMutexLocker locker( &m_mutex );
+    m_entries.clear();
+    m_bytes = 0;
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+//! [2]
+void QImageCache::setMaxBytes( const qint64 &maxBytes )
+{
+    QMutexLocker locker( &m_mutex );
+    m_maxBytes = qMax < qint64 > ( 1, maxBytes );
+    while ( m_bytes > m_maxBytes ) {
+        evictLeastRecentlyUsed();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageCache::maxBytes() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_maxBytes;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageCache::bytes() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_bytes;
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+//! [3]
+bool QImageCache::candidate( QMemoryGovernor::Candidate *candidate ) const
+{
+    QMutexLocker locker( &m_mutex );
+    QHash < QString, Entry >::const_iterator it = leastRecentlyUsed();
+    if ( it == m_entries.constEnd() ) {
+        return false;
+    }
+
+    candidate->lastUsed = it->lastUsed;
+    candidate->cost = it->cost;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageCache::evict()
+{
+    QMutexLocker locker( &m_mutex );
+    return evictLeastRecentlyUsed();
+}
+//! [3]
+
+//---------------------------------------------------------------------------
+
+QHash < QString, QImageCache::Entry >::const_iterator QImageCache::leastRecentlyUsed() const
+{
+    // a few dozen full decodes at most, a scan is cheaper than an order
+    QHash < QString, Entry >::const_iterator oldest = m_entries.constEnd();
+    for ( QHash < QString, Entry >::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it ) {
+        if ( oldest == m_entries.constEnd() || it->lastUsed < oldest->lastUsed ) {
+            oldest = it;
+        }
+    }
+
+    return oldest;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageCache::evictLeastRecentlyUsed()
+{
+    QHash < QString, Entry >::const_iterator it = leastRecentlyUsed();
+    if ( it == m_entries.constEnd() ) {
+        return 0;
+    }
+
+    const qint64 bytes = it->bytes;
+    const QString path = it.key();
+    m_entries.remove( path );
+    m_bytes -= bytes;
+    return bytes;
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,69 @@
+#ifndef QImageCache_H
+#define QImageCache_H
+
+#include <QString>
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+
+#include "qmemorygovernor.h"
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE CACHE
+//! Full resolution decodes shared by views showing the same file, bounded
+//! by decoded size and evicted least recently used; under a
+//! QMemoryGovernor the global budget evicts too. Thread safe, decoding
+//! happens outside the lock.
+class QImageCache : public QMemoryGovernor::Client
+{
+public:
+    enum { DefaultMaxBytes = 512 * 1024 * 1024 };
+
+    explicit QImageCache( const qint64 &maxBytes = DefaultMaxBytes );
+
+    //! [1] IMAGES
+    // decodes and inserts on a miss, null image if decoding failed
+    QImage image( const QString &path );
+    QImage cachedImage( const QString &path ) const;
+    bool contains( const QString &path ) const;
+
+    // cost: ms to decode it again, estimated from the size if not known
+    void insert( const QString &path, const QImage &image, const qint64 &cost = -1 );
+    void remove( const QString &path );
+    void clear();
+    //! [1]
+
+    //! [2] SIZE
+    void setMaxBytes( const qint64 &maxBytes );
+    qint64 maxBytes() const;
+    qint64 bytes() const override;
+    //! [2]
+
+    //! [3] GOVERNOR
+    bool candidate( QMemoryGovernor::Candidate *candidate ) const override;
+    qint64 evict() override;
+    //! [3]
+
+private:
+    struct Entry
+    {
+        Entry() : bytes( 0 ), cost( 0 ), lastUsed( 0 ) {}
+
+        QImage image;
+        qint64 bytes;
+        qint64 cost;
+        mutable qint64 lastUsed;
+    };
+
+    // with m_mutex locked
+    QHash < QString, Entry >::const_iterator leastRecentlyUsed() const;
+    qint64 evictLeastRecentlyUsed();
+
+    mutable QMutex m_mutex;
+    QHash < QString, Entry > m_entries;
+    qint64 m_bytes;
+    qint64 m_maxBytes;
+};
+
+#endif // QImageCache_H
@@ -0,0 +1,182 @@
+#include "qimagecollection.h"
+
+#include <QAtomicInteger>
+
+namespace {
+
+QAtomicInteger < quint64 > lastGeneration( 0 );
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE COLLECTION //!
+QImageCollection::QImageCollection()
+    : m_indexedCount( 0 ),
+      m_generation( 0 )
+{
+    touch();
+}
+
+//---------------------------------------------------------------------------
+
+QImageCollection::QImageCollection( const QStringList &paths )
+    : m_indexedCount( 0 ),
+      m_generation( 0 )
+{
+    setPaths( paths );
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+void QImageCollection::setPaths( const QStringList &paths )
+{
+    m_paths = paths.toVector();
+
+    m_index.clear();
+    m_index.reserve( m_paths.size() );
+    m_indexedCount = 0;
+
+    touch();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCollection::clear()
+{
+    m_paths.clear();
+    m_index.clear();
+    m_indexedCount = 0;
+
+    touch();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCollection::append( const QString &path )
+{
+    m_paths.append( path );
+
+    // keep the index exact if it was exact, no rebuild needed
+    if ( m_indexedCount == m_paths.size() - 1 ) {
+        m_index.insert( m_paths.last(), m_indexedCount );
+        m_indexedCount++;
+    }
+
+    touch();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCollection::insert( const int &index, const QString &path )
+{
+    m_paths.insert( index, path );
+    invalidateIndexFrom( index );
+
+    touch();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCollection::removeAt( const int &index )
+{
+    m_index.remove( m_paths.at( index ) );
+    m_paths.remove( index );
+    invalidateIndexFrom( index );
+
+    touch();
+}
+
+//---------------------------------------------------------------------------
+
+int QImageCollection::removeAll( const QSet < QString > &paths )
+{
+    int kept = 0;
+    for ( int i = 0; i < m_paths.size(); ++i ) {
+        if ( paths.contains( m_paths.at( i ) ) ) {
+            m_index.remove( m_paths.at( i ) );
+            continue;
+        }
+
+        if ( kept != i ) {
+            m_paths[ kept ].swap( m_paths[ i ] );
+            invalidateIndexFrom( kept );
+        }
+        ++kept;
+    }
+
+    const int removed = m_paths.size() - kept;
+    if ( removed > 0 ) {
+        m_paths.resize( kept );
+        touch();
+    }
+
+    return removed;
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+//! [2]
+int QImageCollection::indexOf( const QString &path ) const
+{
+    QHash < QString, int >::const_iterator it = m_index.constFind( path );
+    if ( it != m_index.constEnd() && it.value() < m_indexedCount ) {
+        return it.value();
+    }
+
+    if ( m_indexedCount < m_paths.size() ) {
+        updateIndex();
+
+        it = m_index.constFind( path );
+        if ( it != m_index.constEnd() ) {
+            return it.value();
+        }
+    }
+
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+
+QStringList QImageCollection::paths() const
+{
+    return QStringList( m_paths.toList() );
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+void QImageCollection::touch()
+{
+    m_generation = lastGeneration.fetchAndAddRelaxed( 1 ) + 1;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCollection::invalidateIndexFrom( const int &index ) const
+{
+    m_indexedCount = qMin( m_indexedCount, index );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageCollection::updateIndex() const
+{
+    // positions below m_indexedCount did not move, reindex the tail only
+    for ( int i = m_indexedCount; i < m_paths.size(); ++i ) {
+        const QString &path = m_paths.at( i );
+
+        QHash < QString, int >::iterator it = m_index.find( path );
+        if ( it == m_index.end() ) {
+            m_index.insert( path, i );
+        } else if ( it.value() >= i || m_paths.at( it.value() ) != path ) { // stale
+            it.value() = i;
+        }
+    }
+
+    m_indexedCount = m_paths.size();
+}
+
+//---------------------------------------------------------------------------
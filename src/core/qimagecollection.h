@@ -0,0 +1,68 @@
+#ifndef QImageCollection_H
+#define QImageCollection_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE COLLECTION
+//! Ordered list of image paths with a path -> index hash. Every path is
+//! stored once: the vector entry and the hash key share the same QString
+//! data. The hash is repaired lazily after insert/remove, so a removal
+//! only moves pointers and the next lookup reindexes the shifted tail.
+//! generation() changes on every modification and is unique across
+//! collections, comparing it replaces comparing the whole list.
+class QImageCollection
+{
+public:
+    QImageCollection();
+    explicit QImageCollection( const QStringList &paths );
+
+    //! [1] MODIFY
+    void setPaths( const QStringList &paths );
+    void clear();
+
+    void append( const QString &path );
+    void insert( const int &index, const QString &path );
+    void removeAt( const int &index );
+    // one pass for a whole batch, returns the number removed
+    int removeAll( const QSet < QString > &paths );
+    //! [1]
+
+    //! [2] ACCESS
+    const QString &at( const int &index ) const { return m_paths.at( index ); }
+    QString first() const { return m_paths.first(); }
+    QString last() const { return m_paths.last(); }
+
+    int size() const { return m_paths.size(); }
+    bool isEmpty() const { return m_paths.isEmpty(); }
+
+    int indexOf( const QString &path ) const;
+    bool contains( const QString &path ) const { return indexOf( path ) >= 0; }
+
+    QStringList paths() const;
+    //! [2]
+
+    //! [3] CHANGE DETECTION
+    quint64 generation() const { return m_generation; }
+    //! [3]
+
+private:
+    void touch();
+    void invalidateIndexFrom( const int &index ) const;
+    void updateIndex() const;
+
+    QVector < QString > m_paths;
+
+    // m_index is exact for positions below m_indexedCount
+    mutable QHash < QString, int > m_index;
+    mutable int m_indexedCount;
+
+    quint64 m_generation;
+};
+
+#endif // QImageCollection_H
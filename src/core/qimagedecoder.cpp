@@ -0,0 +1,64 @@
+#include "qimagedecoder.h"
+#include "qexifreader.h"
+#include "qimageorientation.h"
+#include "qjpegdecoder.h"
+#include "qmappedfile.h"
+
+#include <QFileInfo>
+#include <QImageReader>
+#include <QDebug>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE DECODER //!
+QImage QImageDecoder::decode( const QString &path, const QSize &scaledSize, const Qt::AspectRatioMode &mode )
+{
+    if ( scaledSize.isValid() && QJpegDecoder::isAvailable() && QJpegDecoder::isJpeg( path ) ) {
+        // reduced inverse DCT, only the last factor of two is scaled here
+        QImage image;
+        if ( QJpegDecoder::decode( path, scaledSize, mode, &image ) ) {
+            const QSize target = image.size().scaled( scaledSize, mode );
+            if ( target.width() < image.width() ) {
+                image = image.scaled( target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+            }
+
+            const int orientation = QExifReader::read( path ).orientation;
+            if ( orientation != QImageOrientation::Normal ) {
+                QImageOrientation::setOf( &image, orientation );
+            }
+
+            return image;
+        }
+    }
+
+    // from the mapping, the format from the suffix first as for a path
+    QMappedFile file( path );
+    if ( !file.isOpen() ) {
+        qWarning() << Q_FUNC_INFO << "Cannot read" << path;
+        return QImage();
+    }
+
+    // orientation is left to the views, pixels stay as stored
+    QImageReader reader( file.device(), QFileInfo( path ).suffix().toLower().toLatin1() );
+    reader.setAutoTransform( false );
+    const int orientation = QImageOrientation::fromTransformation( reader.transformation() );
+
+    if ( scaledSize.isValid() ) {
+        const QSize size = reader.size();
+        const QSize target = size.scaled( scaledSize, mode );
+        if ( size.isValid() && target.width() < size.width() ) { // never upscale
+            reader.setScaledSize( target );
+        }
+    }
+
+    QImage image = reader.read();
+    if ( image.isNull() ) {
+        qWarning() << Q_FUNC_INFO << path << reader.errorString();
+    } else if ( orientation != QImageOrientation::Normal ) {
+        QImageOrientation::setOf( &image, orientation );
+    }
+
+    return image;
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,26 @@
+#ifndef QImageDecoder_H
+#define QImageDecoder_H
+
+#include <QImage>
+#include <QString>
+#include <QSize>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE DECODER
+//! Single entry point for turning a file into pixels. Produces QImage, not
+//! QPixmap, so it can run on any thread.
+class QImageDecoder
+{
+public:
+    // scaledSize: decode to at most this size, keeping aspect ratio; with
+    // Qt::KeepAspectRatioByExpanding the result covers scaledSize instead.
+    // Pixels are as stored, see QImageOrientation::of() for how to show them
+    static QImage decode( const QString &path, const QSize &scaledSize = QSize(),
+                          const Qt::AspectRatioMode &mode = Qt::KeepAspectRatio );
+
+private:
+    QImageDecoder() {}
+};
+
+#endif // QImageDecoder_H
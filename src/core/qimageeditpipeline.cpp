@@ -0,0 +1,168 @@
+#include "qimageeditpipeline.h"
+#include "qimagedecoder.h"
+#include "qimageorientation.h"
+#include "qimagerotation.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+
+namespace {
+
+// encoding these again keeps every pixel, rotateFile() may turn them
+const char *const LosslessFormats[] = { "png", "bmp", "tif", "tiff", "ppm", "pgm", "pbm", "xpm" };
+
+//---------------------------------------------------------------------------
+
+bool isLossless( const QString &path )
+{
+    const QString suffix = QFileInfo( path ).suffix().toLower();
+    for ( const char *format : LosslessFormats ) {
+        if ( suffix == QLatin1String( format ) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE EDIT PIPELINE //!
+QImage QImageEditPipeline::cropped( const QImage &image, const QRect &rect )
+{
+    return image.copy( rect & image.rect() );
+}
+
+//---------------------------------------------------------------------------
+
+QImage QImageEditPipeline::rotated( const QImage &image, const int &degrees )
+{
+    return QImageRotation::rotated( image, degrees );
+}
+
+//---------------------------------------------------------------------------
+
+//! [2]
+void QImageEditPipeline::crop( const QRect &rect )
+{
+    Operation operation;
+    operation.type = Operation::Crop;
+    operation.rect = rect;
+    operation.degrees = 0;
+    m_operations.append( operation );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageEditPipeline::rotate( const int &degrees )
+{
+    Operation operation;
+    operation.type = Operation::Rotate;
+    operation.degrees = degrees;
+    m_operations.append( operation );
+}
+
+//---------------------------------------------------------------------------
+
+QImage QImageEditPipeline::apply( const QImage &image ) const
+{
+    QImage result = image;
+
+    foreach ( const Operation &operation, m_operations ) {
+        switch ( operation.type ) {
+        case Operation::Crop:
+            result = cropped( result, operation.rect );
+            break;
+        case Operation::Rotate:
+            result = rotated( result, operation.degrees );
+            break;
+        }
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageEditPipeline::parse( const QString &spec, QString *error )
+{
+    QImageEditPipeline pipeline;
+
+    foreach ( const QString &step, spec.split( ';', QString::SkipEmptyParts ) ) {
+        const QString name = step.section( '=', 0, 0 ).trimmed();
+        const QStringList values = step.section( '=', 1 ).split( ',' );
+
+        bool ok = true;
+        if ( name == "crop" && values.size() == 4 ) {
+            int numbers[ 4 ];
+            for ( int i = 0; i < 4 && ok; ++i ) {
+                numbers[ i ] = values.at( i ).trimmed().toInt( &ok );
+            }
+            if ( ok ) {
+                pipeline.crop( QRect( numbers[ 0 ], numbers[ 1 ], numbers[ 2 ], numbers[ 3 ] ) );
+            }
+        } else if ( name == "rotate" && values.size() == 1 ) {
+            const int degrees = values.first().trimmed().toInt( &ok );
+            ok = ok && degrees % 90 == 0;
+            if ( ok ) {
+                pipeline.rotate( degrees );
+            }
+        } else {
+            ok = false;
+        }
+
+        if ( !ok ) {
+            if ( error ) {
+                *error = QString( "Wrong edit step \"%1\"." ).arg( step );
+            }
+            return false;
+        }
+    }
+
+    m_operations = pipeline.m_operations;
+    return true;
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+//! [3]
+bool QImageEditPipeline::rotateFile( const QString &path, const int &degrees )
+{
+    // the EXIF tag of a JPEG, the scan data is kept as it is
+    const int orientation = QImageOrientation::read( path );
+    if ( QImageOrientation::write( path, QImageOrientation::rotated( orientation, degrees ) ) ) {
+        return true;
+    }
+
+    // other lossy files would lose quality, and their metadata, each turn
+    if ( !isLossless( path ) ) {
+        qWarning() << Q_FUNC_INFO << "Cannot turn without encoding again" << path;
+        return false;
+    }
+
+    const QImage decoded = QImageDecoder::decode( path );
+    if ( decoded.isNull() ) {
+        return false;
+    }
+
+    const QImage image = rotated( QImageOrientation::applied( decoded, QImageOrientation::of( decoded ) ), degrees );
+
+    // the original stays until the new file is complete
+    QSaveFile file( path );
+    if ( !file.open( QIODevice::WriteOnly )
+         || !image.save( &file, QFileInfo( path ).suffix().toLower().toLatin1().constData() )
+         || !file.commit() ) {
+        qWarning() << Q_FUNC_INFO << "Cannot write" << path;
+        return false;
+    }
+
+    return true;
+}
+//! [3]
+
+//---------------------------------------------------------------------------
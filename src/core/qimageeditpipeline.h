@@ -0,0 +1,56 @@
+#ifndef QImageEditPipeline_H
+#define QImageEditPipeline_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE EDIT PIPELINE
+//! Crop and rotate on QImage, one by one or as a recorded sequence. The
+//! widget undo commands and the command line tool share these, bulk
+//! rotations of the widget use rotateFile().
+class QImageEditPipeline
+{
+public:
+    struct Operation {
+        enum Type { Crop, Rotate };
+
+        Type type;
+        QRect rect;     // Crop
+        int degrees;    // Rotate, multiple of 90, positive is clockwise
+    };
+
+    //! [1] SINGLE OPERATIONS
+    static QImage cropped( const QImage &image, const QRect &rect );
+    static QImage rotated( const QImage &image, const int &degrees );
+    //! [1]
+
+    //! [2] SEQUENCE
+    void crop( const QRect &rect );
+    void rotate( const int &degrees );
+    void clear() { m_operations.clear(); }
+
+    bool isEmpty() const { return m_operations.isEmpty(); }
+    QVector < Operation > operations() const { return m_operations; }
+
+    QImage apply( const QImage &image ) const;
+
+    // "crop=x,y,w,h;rotate=90", replaces the sequence, false on errors
+    bool parse( const QString &spec, QString *error = 0 );
+    //! [2]
+
+    //! [3] FILES
+    // JPEGs get the EXIF Orientation tag set, added if missing, lossless;
+    // lossless formats are decoded, turned and written back upright; false
+    // for other lossy formats
+    static bool rotateFile( const QString &path, const int &degrees );
+    //! [3]
+
+private:
+    QVector < Operation > m_operations;
+};
+
+#endif // QImageEditPipeline_H
@@ -0,0 +1,297 @@
+#include "qimageexporter.h"
+#include "qimagedecoder.h"
+#include "qimageorientation.h"
+#include "qimagewidgetlogging.h"
+#include "qpixelkernels.h"
+#include "qthumbnailer.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// the formats worth converting a collection to, in the order offered
+const char *const KnownFormats[] = { "jpg", "png", "webp", "avif", "jxl" };
+
+//---------------------------------------------------------------------------
+
+void configure( QImageWriter *writer, const QImageExporter::Settings &settings )
+{
+    if ( settings.quality >= 0 ) {
+        writer->setQuality( qBound( 0, settings.quality, 100 ) );
+    }
+
+    if ( settings.format == "jpg" || settings.format == "jpeg" ) {
+        // Huffman tables fitted to the image, a few percent smaller
+        writer->setOptimizedWrite( settings.effort >= 50 );
+        writer->setProgressiveScanWrite( settings.progressive );
+    } else if ( settings.effort >= 0 && writer->supportsOption( QImageIOHandler::CompressionRatio ) ) {
+        const int effort = qBound( 0, settings.effort, 100 );
+        writer->setCompression( settings.format == "png" ? effort * 9 / 100 : effort );
+    }
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! SUMMARY //!
+QImageExporter::Summary::Summary()
+    : m_written( 0 ),
+      m_failed( 0 ),
+      m_inputBytes( 0 ),
+      m_outputBytes( 0 ),
+      m_psnrSum( 0 ),
+      m_lossyCount( 0 ),
+      m_losslessCount( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+void QImageExporter::Summary::add( const Result &result )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( !result.written ) {
+        ++m_failed;
+        return;
+    }
+
+    ++m_written;
+    m_inputBytes += result.inputBytes;
+    m_outputBytes += result.outputBytes;
+
+    if ( std::isinf( result.psnr ) ) {
+        ++m_losslessCount;
+    } else if ( result.psnr >= 0 ) {
+        m_psnrSum += result.psnr;
+        ++m_lossyCount;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+int QImageExporter::Summary::written() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_written;
+}
+
+//---------------------------------------------------------------------------
+
+int QImageExporter::Summary::failed() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_failed;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageExporter::Summary::inputBytes() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_inputBytes;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageExporter::Summary::outputBytes() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_outputBytes;
+}
+
+//---------------------------------------------------------------------------
+
+double QImageExporter::Summary::averagePsnr() const
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_lossyCount > 0 ) {
+        return m_psnrSum / m_lossyCount;
+    }
+
+    return m_losslessCount > 0 ? std::numeric_limits < double >::infinity() : -1;
+}
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE EXPORTER //!
+
+//! [1]
+QList < QByteArray > QImageExporter::formats()
+{
+    QList < QByteArray > formats;
+    for ( const char *format : KnownFormats ) {
+        if ( isSupported( format ) ) {
+            formats.append( format );
+        }
+    }
+
+    return formats;
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageExporter::isSupported( const QByteArray &format )
+{
+    static const QList < QByteArray > supported = QImageWriter::supportedImageFormats();
+    return supported.contains( format.toLower() );
+}
+
+//---------------------------------------------------------------------------
+
+QByteArray QImageExporter::formatOf( const QString &path )
+{
+    return QFileInfo( path ).suffix().toLower().toLatin1();
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+//! [2]
+QImageExporter::Result QImageExporter::write( const QImage &image, const QString &outputPath, const Settings &settings )
+{
+    Result result;
+    if ( image.isNull() ) {
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QSaveFile file( outputPath );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        qWarning() << Q_FUNC_INFO << "Cannot write" << outputPath;
+        return result;
+    }
+
+    QImageWriter writer( &file, settings.format );
+    configure( &writer, settings );
+    if ( !writer.write( image ) || !file.commit() ) {
+        qWarning() << Q_FUNC_INFO << "Cannot write" << outputPath << writer.errorString();
+        return result;
+    }
+
+    result.written = true;
+    result.encodeTime = timer.elapsed();
+    result.outputBytes = QFileInfo( outputPath ).size();
+
+    if ( settings.measure ) {
+        result.psnr = psnr( image, QImageDecoder::decode( outputPath ) );
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+QImageExporter::Result QImageExporter::writeFile( const QString &path, const QString &outputPath,
+                                                  const Settings &settings, const QImageEditPipeline &pipeline )
+{
+    if ( outputPath.isEmpty() || QThumbnailer::isSameFile( path, outputPath ) ) {
+        qWarning() << Q_FUNC_INFO << "Would overwrite the source" << path;
+        return Result();
+    }
+
+    // edits are given for the image as shown, upright
+    const QImage decoded = QImageDecoder::decode( path );
+    const QImage image = pipeline.apply( QImageOrientation::applied( decoded, QImageOrientation::of( decoded ) ) );
+
+    Result result = write( image, outputPath, settings );
+    result.inputBytes = QFileInfo( path ).size();
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+QList < QImageExporter::Result > QImageExporter::writeAll( const QStringList &paths, const QString &outputDirectory,
+                                                           const Settings &settings, const int &threads,
+                                                           const QImageEditPipeline &pipeline )
+{
+    QList < Result > results;
+    const QStringList outputs = QThumbnailer::outputPaths( paths, outputDirectory, settings.format );
+    foreach ( const QString &output, outputs ) {
+        if ( !output.isEmpty() && !QDir().mkpath( QFileInfo( output ).absolutePath() ) ) {
+            qWarning() << Q_FUNC_INFO << "Cannot create" << QFileInfo( output ).absolutePath();
+            for ( int i = 0; i < paths.size(); ++i ) {
+                results.append( Result() );
+            }
+            return results;
+        }
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Export, files:", paths.size() );
+
+    // encoding is the long part and bound by the processor, not the disk:
+    // the per device limits of QIoScheduler would serialize it on a
+    // rotational disk, a pool of its own keeps every core busy
+    QThreadPool pool;
+    pool.setMaxThreadCount( threads > 0 ? threads : QThread::idealThreadCount() );
+
+    // distinct outputs, no two jobs write one file; sources are left out
+    QList < QFuture < Result > > futures;
+    for ( int i = 0; i < paths.size(); ++i ) {
+        const QString path = paths.at( i );
+        const QString outputPath = outputs.at( i );
+        futures.append( QtConcurrent::run( &pool, [ path, outputPath, settings, pipeline ] () {
+            return writeFile( path, outputPath, settings, pipeline );
+        } ) );
+    }
+
+    foreach ( const QFuture < Result > &future, futures ) {
+        results.append( future.result() );
+    }
+
+    return results;
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+double QImageExporter::psnr( const QImage &a, const QImage &b )
+{
+    if ( a.isNull() || a.size() != b.size() ) {
+        return -1;
+    }
+
+    const QImage first = a.convertToFormat( QImage::Format_ARGB32 );
+    const QImage second = b.convertToFormat( QImage::Format_ARGB32 );
+    const int width = first.width();
+
+    // the kernel gives per channel differences a row at a time
+    QVector < QRgb > difference( width );
+    quint64 sum = 0;
+    for ( int y = 0; y < first.height(); ++y ) {
+        QPixelKernels::absDiff( reinterpret_cast < const QRgb * > ( first.constScanLine( y ) ),
+                                reinterpret_cast < const QRgb * > ( second.constScanLine( y ) ),
+                                difference.data(), width );
+
+        quint64 row = 0;
+        for ( int x = 0; x < width; ++x ) {
+            const QRgb pixel = difference.at( x );
+            row += quint64( qRed( pixel ) * qRed( pixel ) + qGreen( pixel ) * qGreen( pixel ) + qBlue( pixel ) * qBlue( pixel ) );
+        }
+        sum += row;
+    }
+
+    if ( sum == 0 ) {
+        return std::numeric_limits < double >::infinity();
+    }
+
+    const double meanSquaredError = double( sum ) / ( 3.0 * double( width ) * first.height() );
+    return 10.0 * std::log10( 255.0 * 255.0 / meanSquaredError );
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,115 @@
+#ifndef QImageExporter_H
+#define QImageExporter_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include "qimageeditpipeline.h"
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE EXPORTER
+//! Writes images in a chosen format with explicit encoder settings, through
+//! the Qt image plugins: JPEG and PNG are built in, WebP comes with
+//! qtimageformats, AVIF and JPEG XL with kimageformats. Every write reports
+//! the bytes written and, when measured, the PSNR of what a decoder gets
+//! back. Files go in parallel, one encode per thread: the plugins take no
+//! thread count of their own. Thread safe.
+class QImageExporter
+{
+public:
+    struct Settings
+    {
+        Settings()
+            : format( "jpg" ), quality( -1 ), effort( -1 ), progressive( false ), measure( false ) {}
+
+        QByteArray format;  // "jpg", "png", "webp", "avif", "jxl"...
+        int quality;        // 0..100, -1 for the encoder default
+        int effort;         // 0..100, -1 for the default; more is smaller and slower:
+                            // optimized JPEG tables from 50 on, the PNG zlib level,
+                            // the compression option of the other plugins
+        bool progressive;   // JPEG
+        bool measure;       // decodes what was written for psnr
+    };
+
+    struct Result
+    {
+        Result()
+            : written( false ), inputBytes( 0 ), outputBytes( 0 ), encodeTime( 0 ), psnr( -1 ) {}
+
+        bool written;
+        qint64 inputBytes;  // the source file, 0 for images given in memory
+        qint64 outputBytes;
+        qint64 encodeTime;  // ms
+        double psnr;        // dB over red, green and blue; -1 if not measured,
+                            // infinity if nothing was lost
+    };
+
+    //!--------------------------------------------------------------------
+    //! SUMMARY
+    //! Results of many files added up, thread safe.
+    class Summary
+    {
+    public:
+        Summary();
+
+        void add( const Result &result );
+
+        int written() const;
+        int failed() const;
+        qint64 inputBytes() const;
+        qint64 outputBytes() const;
+        // mean of the measured lossy writes; infinity if all measured were
+        // lossless, -1 if none was measured
+        double averagePsnr() const;
+
+    private:
+        Q_DISABLE_COPY( Summary )
+
+        mutable QMutex m_mutex;
+        int m_written;
+        int m_failed;
+        qint64 m_inputBytes;
+        qint64 m_outputBytes;
+        double m_psnrSum;
+        int m_lossyCount;
+        int m_losslessCount;
+    };
+
+    //! [1] FORMATS
+    // of "jpg", "png", "webp", "avif" and "jxl", the ones with a plugin
+    static QList < QByteArray > formats();
+    static bool isSupported( const QByteArray &format );
+    static QByteArray formatOf( const QString &path ); // the suffix, lowercase
+    //! [1]
+
+    //! [2] WRITING
+    // through a temporary file, an existing outputPath stays until the new
+    // one is complete
+    static Result write( const QImage &image, const QString &outputPath, const Settings &settings );
+
+    // upright, pipeline applied; not written over path
+    static Result writeFile( const QString &path, const QString &outputPath, const Settings &settings,
+                             const QImageEditPipeline &pipeline = QImageEditPipeline() );
+
+    // named by QThumbnailer::outputPaths(), on threads threads, 0 for one
+    // per core; blocking, results in the order of paths, sources are not
+    // written over
+    static QList < Result > writeAll( const QStringList &paths, const QString &outputDirectory,
+                                      const Settings &settings, const int &threads = 0,
+                                      const QImageEditPipeline &pipeline = QImageEditPipeline() );
+    //! [2]
+
+    // dB over red, green and blue, infinity for equal images, -1 if the
+    // sizes differ
+    static double psnr( const QImage &a, const QImage &b );
+
+private:
+    QImageExporter() {}
+};
+
+#endif // QImageExporter_H
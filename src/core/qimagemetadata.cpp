@@ -0,0 +1,173 @@
+#include "qimagemetadata.h"
+#include "qexifreader.h"
+
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSharedPointer>
+#include <QtConcurrent>
+
+namespace {
+
+// read before, the file changed since; stat holds FileInfo only
+bool isStale( const QImageMetadata &entry, const QImageMetadata &stat )
+{
+    return ( entry.fields & QImageMetadata::FileInfo )
+           && ( entry.fileSize != stat.fileSize || entry.lastModified != stat.lastModified );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE METADATA //!
+QImageMetadata QImageMetadata::read( const QString &path, const Fields &fields )
+{
+    QImageMetadata metadata;
+
+    if ( fields & FileInfo ) {
+        QFileInfo info( path );
+        if ( info.exists() ) {
+            metadata.fileSize = info.size();
+            metadata.created = info.created();
+            metadata.lastModified = info.lastModified();
+        }
+        metadata.fields |= FileInfo;
+    }
+
+    if ( fields & Exif ) {
+        metadata.captureTime = QExifReader::read( path ).captureTime;
+        metadata.fields |= Exif;
+    }
+
+    if ( fields & Dimensions ) {
+        metadata.dimensions = QImageReader( path ).size();
+        metadata.fields |= Dimensions;
+    }
+
+    return metadata;
+}
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! METADATA CACHE //!
+QImageMetadata QImageMetadataCache::value( const QString &path ) const
+{
+    QReadLocker locker( &m_lock );
+    return m_entries.value( path );
+}
+
+//---------------------------------------------------------------------------
+
+QImageMetadata QImageMetadataCache::metadata( const QString &path,
+                                              const QImageMetadata::Fields &fields ) const
+{
+    // the stat refreshes the file info and tells whether what was read
+    // from the file before still holds
+    const QImageMetadata stat = QImageMetadata::read( path, QImageMetadata::FileInfo );
+
+    const QImageMetadata cached = value( path );
+    const bool stale = isStale( cached, stat );
+    if ( !stale && ( cached.fields & QImageMetadata::FileInfo ) && ( cached.fields & fields ) == fields ) {
+        return cached;
+    }
+
+    // read without the lock, files may be slow
+    QImageMetadata::Fields absent = fields & ~QImageMetadata::Fields( QImageMetadata::FileInfo );
+    if ( !stale ) {
+        absent = absent & ~cached.fields;
+    }
+    const QImageMetadata fresh = QImageMetadata::read( path, absent );
+
+    QWriteLocker locker( &m_lock );
+    const bool added = !m_entries.contains( path );
+    if ( added ) {
+        m_bytes += entryBytes( path );
+    }
+
+    QImageMetadata &entry = m_entries[ path ];
+    if ( isStale( entry, stat ) ) { // changed by another program
+        entry = QImageMetadata();
+    }
+
+    entry.fileSize = stat.fileSize;
+    entry.created = stat.created;
+    entry.lastModified = stat.lastModified;
+    entry.fields |= QImageMetadata::FileInfo;
+    if ( absent & QImageMetadata::Exif ) {
+        entry.captureTime = fresh.captureTime;
+    }
+    if ( absent & QImageMetadata::Dimensions ) {
+        entry.dimensions = fresh.dimensions;
+    }
+    entry.fields |= absent;
+    const QImageMetadata result = entry;
+    locker.unlock();
+
+    if ( added ) {
+        grown();
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageMetadataCache::gather( const QStringList &paths, const QImageMetadata::Fields &fields ) const
+{
+    // every path, complete entries are validated too
+    QStringList pending = paths;
+
+    QtConcurrent::blockingMap( pending, [ this, fields ] ( const QString &path ) {
+        metadata( path, fields );
+    } );
+}
+
+//---------------------------------------------------------------------------
+
+QFuture < void > QImageMetadataCache::gatherAsync( const QStringList &paths,
+                                                   const QImageMetadata::Fields &fields ) const
+{
+    // the sequence must outlive the map, it is shared with the functor
+    QSharedPointer < QStringList > pending( new QStringList( paths ) );
+
+    return QtConcurrent::map( *pending, [ this, fields, pending ] ( const QString &path ) {
+        metadata( path, fields );
+    } );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageMetadataCache::remove( const QString &path )
+{
+    QWriteLocker locker( &m_lock );
+    if ( m_entries.remove( path ) > 0 ) {
+        m_bytes -= entryBytes( path );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageMetadataCache::clear()
+{
+    QWriteLocker locker( &m_lock );
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageMetadataCache::bytes() const
+{
+    QReadLocker locker( &m_lock );
+    return m_bytes;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageMetadataCache::entryBytes( const QString &path )
+{
+    // key, value and the private data of the three dates
+    return qint64( path.size() ) * qint64( sizeof( QChar ) ) + qint64( sizeof( QString ) + sizeof( QImageMetadata ) ) + 3 * 32;
+}
+
+//---------------------------------------------------------------------------
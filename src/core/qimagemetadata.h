@@ -0,0 +1,90 @@
+#ifndef QImageMetadata_H
+#define QImageMetadata_H
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QSize>
+#include <QFuture>
+#include <QHash>
+#include <QReadWriteLock>
+
+#include "qmemorygovernor.h"
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE METADATA
+struct QImageMetadata
+{
+    enum Field {
+        NoFields = 0x0,
+        FileInfo = 0x1,     // one stat: size, created, last modified
+        Exif = 0x2,         // JPEG header: capture time
+        Dimensions = 0x4,   // image header, no decode
+        AllFields = FileInfo | Exif | Dimensions
+    };
+    Q_DECLARE_FLAGS( Fields, Field )
+
+    QImageMetadata()
+        : fields( NoFields ), fileSize( -1 ) {}
+
+    Fields fields;  // what has been read so far
+
+    qint64 fileSize;
+    QDateTime created;
+    QDateTime lastModified;
+    QDateTime captureTime;
+    QSize dimensions;
+
+    static QImageMetadata read( const QString &path, const Fields &fields );
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS( QImageMetadata::Fields )
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! METADATA CACHE
+//! Thread-safe path -> metadata map. gather() reads the missing fields of
+//! many files in parallel on the global thread pool, gatherAsync() does the
+//! same without blocking and can be canceled. Entries are validated by the
+//! file size and modification time, a stat per file and call, and read
+//! again when another program changed the file. Readers are const: filling
+//! the cache is not an observable change. Counted by a QMemoryGovernor,
+//! never evicted: sorting needs every entry.
+class QImageMetadataCache : public QMemoryGovernor::Client
+{
+public:
+    QImageMetadataCache()
+        : m_bytes( 0 ) {}
+
+    // cached value as of the last metadata() or gather(), fields may be
+    // incomplete; no stat
+    QImageMetadata value( const QString &path ) const;
+
+    // reads what is missing or stale from the file and caches it; the file
+    // info is always refreshed
+    QImageMetadata metadata( const QString &path, const QImageMetadata::Fields &fields ) const;
+
+    // blocking, parallel
+    void gather( const QStringList &paths, const QImageMetadata::Fields &fields ) const;
+
+    // parallel, returns at once
+    QFuture < void > gatherAsync( const QStringList &paths, const QImageMetadata::Fields &fields ) const;
+
+    void remove( const QString &path );
+    void clear();
+
+    qint64 bytes() const override;
+
+private:
+    Q_DISABLE_COPY( QImageMetadataCache )
+
+    // of an entry, roughly
+    static qint64 entryBytes( const QString &path );
+
+    mutable QReadWriteLock m_lock;
+    mutable QHash < QString, QImageMetadata > m_entries;
+    mutable qint64 m_bytes; // of m_entries
+};
+
+#endif // QImageMetadata_H
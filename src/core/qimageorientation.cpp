@@ -0,0 +1,181 @@
+#include "qimageorientation.h"
+#include "qexifreader.h"
+#include "qimagerotation.h"
+
+#include <QFile>
+#include <QImageReader>
+#include <QSaveFile>
+
+namespace {
+
+// linear part of transform() for orientations 1..8: m11, m12, m21, m22
+const int Matrices[ 8 ][ 4 ] = {
+    {  1,  0,  0,  1 },     // 1 normal
+    { -1,  0,  0,  1 },     // 2 mirrored horizontally
+    { -1,  0,  0, -1 },     // 3 rotated 180
+    {  1,  0,  0, -1 },     // 4 mirrored vertically
+    {  0,  1,  1,  0 },     // 5 transposed
+    {  0,  1, -1,  0 },     // 6 rotated 90 clockwise
+    {  0, -1, -1,  0 },     // 7 transversed
+    {  0, -1,  1,  0 }      // 8 rotated 90 counter clockwise
+};
+
+//---------------------------------------------------------------------------
+
+int checked( const int &orientation )
+{
+    return orientation >= 1 && orientation <= 8 ? orientation : int( QImageOrientation::Normal );
+}
+
+//---------------------------------------------------------------------------
+
+QTransform linear( const int &orientation )
+{
+    const int *m = Matrices[ checked( orientation ) - 1 ];
+    return QTransform( m[ 0 ], m[ 1 ], m[ 2 ], m[ 3 ], 0, 0 );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE ORIENTATION //!
+const char *QImageOrientation::TextKey = "Orientation";
+
+//---------------------------------------------------------------------------
+
+int QImageOrientation::read( const QString &path )
+{
+    // header only, the same tag QImageReader::setAutoTransform() would use
+    return fromTransformation( QImageReader( path ).transformation() );
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageOrientation::write( const QString &path, const int &orientation )
+{
+    if ( orientation < 1 || orientation > 8 ) {
+        return false;
+    }
+
+    bool bigEndian = false;
+    const qint64 offset = QExifReader::orientationOffset( path, &bigEndian );
+    if ( offset >= 0 ) {
+        // two bytes, the rest of the file is not touched
+        QFile file( path );
+        if ( !file.open( QIODevice::ReadWrite ) || !file.seek( offset ) ) {
+            return false;
+        }
+
+        const char value[ 2 ] = { char( bigEndian ? 0 : orientation ), char( bigEndian ? orientation : 0 ) };
+        return file.write( value, 2 ) == 2;
+    }
+
+    // no tag: the header grows, the file is written anew with the same scan
+    QFile source( path );
+    if ( !source.open( QIODevice::ReadOnly ) || source.peek( 2 ) != QByteArray( "\xFF\xD8" ) ) {
+        return false;
+    }
+
+    const QByteArray jpeg = QExifReader::withOrientation( source.readAll(), orientation );
+    source.close();
+    if ( jpeg.isEmpty() ) {
+        return false;
+    }
+
+    QSaveFile file( path );
+    return file.open( QIODevice::WriteOnly ) && file.write( jpeg ) == jpeg.size() && file.commit();
+}
+
+//---------------------------------------------------------------------------
+
+int QImageOrientation::fromTransformation( const QImageIOHandler::Transformations &transformation )
+{
+    switch ( int( transformation ) ) {
+    case QImageIOHandler::TransformationMirror:             return 2;
+    case QImageIOHandler::TransformationRotate180:          return 3;
+    case QImageIOHandler::TransformationFlip:               return 4;
+    case QImageIOHandler::TransformationFlipAndRotate90:    return 5;
+    case QImageIOHandler::TransformationRotate90:           return 6;
+    case QImageIOHandler::TransformationMirrorAndRotate90:  return 7;
+    case QImageIOHandler::TransformationRotate270:          return 8;
+    default:                                                return Normal;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+int QImageOrientation::of( const QImage &image )
+{
+    return checked( image.text( TextKey ).toInt() );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageOrientation::setOf( QImage *image, const int &orientation )
+{
+    image->setText( TextKey, QString::number( checked( orientation ) ) );
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageOrientation::isTransposed( const int &orientation )
+{
+    return checked( orientation ) >= 5;
+}
+
+//---------------------------------------------------------------------------
+
+QSize QImageOrientation::orientedSize( const QSize &size, const int &orientation )
+{
+    return isTransposed( orientation ) ? size.transposed() : size;
+}
+
+//---------------------------------------------------------------------------
+
+QTransform QImageOrientation::transform( const int &orientation, const QSize &size )
+{
+    // move the turned rect back to the origin
+    const QTransform turn = linear( orientation );
+    const QRectF turned = turn.mapRect( QRectF( QPointF( 0, 0 ), QSizeF( size ) ) );
+    return turn * QTransform::fromTranslate( -turned.left(), -turned.top() );
+}
+
+//---------------------------------------------------------------------------
+
+int QImageOrientation::rotated( const int &orientation, const int &degrees )
+{
+    const QTransform result = linear( orientation ) * QTransform().rotate( ( ( degrees % 360 ) + 360 ) % 360 );
+    for ( int i = 0; i < 8; ++i ) {
+        const int *m = Matrices[ i ];
+        if ( qRound( result.m11() ) == m[ 0 ] && qRound( result.m12() ) == m[ 1 ]
+             && qRound( result.m21() ) == m[ 2 ] && qRound( result.m22() ) == m[ 3 ] ) {
+            return i + 1;
+        }
+    }
+
+    return checked( orientation ); // not a multiple of 90
+}
+
+//---------------------------------------------------------------------------
+
+QImage QImageOrientation::applied( const QImage &image, const int &orientation )
+{
+    QImage result;
+    switch ( checked( orientation ) ) {
+    case 2: result = image.mirrored( true, false ); break;
+    case 3: result = QImageRotation::rotated( image, 180 ); break;
+    case 4: result = image.mirrored( false, true ); break;
+    case 5: result = QImageRotation::rotated( image.mirrored( false, true ), 90 ); break;
+    case 6: result = QImageRotation::rotated( image, 90 ); break;
+    case 7: result = QImageRotation::rotated( image.mirrored( true, false ), 90 ); break;
+    case 8: result = QImageRotation::rotated( image, -90 ); break;
+    default: return image;
+    }
+
+    // the pixels are upright now
+    result.setText( TextKey, QString() );
+    return result;
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,49 @@
+#ifndef QImageOrientation_H
+#define QImageOrientation_H
+
+#include <QImage>
+#include <QImageIOHandler>
+#include <QSize>
+#include <QString>
+#include <QTransform>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE ORIENTATION
+//! EXIF orientation, 1..8, kept next to the pixels instead of applied to
+//! them. Views show it with transform(), rotations only change the number
+//! and the pixels are turned once when they are needed upright.
+class QImageOrientation
+{
+public:
+    enum { Normal = 1 };
+
+    // QImage::text() key QImageDecoder stores the orientation of a file in
+    static const char *TextKey;
+
+    static int read( const QString &path );
+    // the EXIF tag of a JPEG, in place or added to the header, the pixels
+    // are not encoded again; false for other formats
+    static bool write( const QString &path, const int &orientation );
+    static int fromTransformation( const QImageIOHandler::Transformations &transformation );
+    static int of( const QImage &image ); // Normal without the text key
+    static void setOf( QImage *image, const int &orientation );
+
+    static bool isTransposed( const int &orientation ); // 5..8 swap width and height
+    static QSize orientedSize( const QSize &size, const int &orientation );
+
+    // stored pixel coordinates of an image of size to shown ones
+    static QTransform transform( const int &orientation, const QSize &size );
+
+    // the orientation after turning the shown image by degrees, a multiple
+    // of 90, positive is clockwise
+    static int rotated( const int &orientation, const int &degrees );
+
+    // the pixels as shown
+    static QImage applied( const QImage &image, const int &orientation );
+
+private:
+    QImageOrientation() {}
+};
+
+#endif // QImageOrientation_H
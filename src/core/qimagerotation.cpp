@@ -0,0 +1,166 @@
+#include "qimagerotation.h"
+#include "qpixelkernels.h"
+
+#include <QTransform>
+#include <QVector>
+#include <QtConcurrent>
+
+namespace {
+
+// not worth the threads below this
+const qint64 MinParallelPixels = 1 << 20;
+
+bool isParallel( const QImage &image )
+{
+    return qint64( image.width() ) * image.height() >= MinParallelPixels;
+}
+
+// runs function( 0 ) ... function( count - 1 ), in parallel on large images
+template < typename Function >
+void forEach( const int &count, const bool &parallel, Function function )
+{
+    if ( !parallel ) {
+        for ( int i = 0; i < count; ++i ) {
+            function( i );
+        }
+        return;
+    }
+
+    QVector < int > indexes( count );
+    for ( int i = 0; i < count; ++i ) {
+        indexes[ i ] = i;
+    }
+    QtConcurrent::blockingMap( indexes, [ &function ] ( const int &i ) {
+        function( i );
+    } );
+}
+
+void copyMetadata( const QImage &from, QImage *to, const bool &swapAxes )
+{
+    to->setDotsPerMeterX( swapAxes ? from.dotsPerMeterY() : from.dotsPerMeterX() );
+    to->setDotsPerMeterY( swapAxes ? from.dotsPerMeterX() : from.dotsPerMeterY() );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE ROTATION //!
+bool QImageRotation::isSupported( const QImage::Format &format )
+{
+    switch ( format ) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+    case QImage::Format_RGB888:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+QImage QImageRotation::rotated( const QImage &image, const int &degrees )
+{
+    const int quarter = ( ( degrees / 90 ) % 4 + 4 ) % 4;
+    if ( quarter == 0 || image.isNull() ) {
+        return image;
+    }
+
+    if ( !isSupported( image.format() ) ) {
+        return image.transformed( QTransform().rotate( quarter * 90 ) );
+    }
+
+    return quarter == 2 ? rotated180( image ) : rotated90( image, quarter == 1 );
+}
+
+//---------------------------------------------------------------------------
+
+QImage QImageRotation::rotated90( const QImage &image, const bool &clockwise )
+{
+    const int width = image.width();
+    const int height = image.height();
+    const int depth = image.depth() / 8;
+
+    QImage result( height, width, image.format() );
+    if ( result.isNull() ) { // out of memory
+        return result;
+    }
+    copyMetadata( image, &result, true );
+
+    const uchar *src = image.constBits();
+    const int srcStride = image.bytesPerLine();
+    uchar *dst = result.bits();
+    const int dstStride = result.bytesPerLine();
+
+    // a column of source tiles fills a band of destination rows, so the
+    // parallel workers never write the same lines
+    const int columns = ( width + TileSize - 1 ) / TileSize;
+    forEach( columns, isParallel( image ), [ = ] ( const int &column ) {
+        const int x = column * TileSize;
+        const int tileWidth = qMin < int > ( TileSize, width - x );
+
+        for ( int y = 0; y < height; y += TileSize ) {
+            const int tileHeight = qMin < int > ( TileSize, height - y );
+
+            // top left of the rotated tile
+            const int targetX = clockwise ? height - y - tileHeight : y;
+            const int targetY = clockwise ? x : width - x - tileWidth;
+
+            const uchar *from = src + qptrdiff( y ) * srcStride + x * depth;
+            uchar *to = dst + qptrdiff( targetY ) * dstStride + targetX * depth;
+
+            if ( depth == 4 ) {
+                QPixelKernels::rotateTile32( from, srcStride, to, dstStride, tileWidth, tileHeight, clockwise );
+            } else {
+                QPixelKernels::rotateTile24( from, srcStride, to, dstStride, tileWidth, tileHeight, clockwise );
+            }
+        }
+    } );
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+QImage QImageRotation::rotated180( const QImage &image )
+{
+    const int width = image.width();
+    const int height = image.height();
+    const int depth = image.depth() / 8;
+
+    QImage result( width, height, image.format() );
+    if ( result.isNull() ) {
+        return result;
+    }
+    copyMetadata( image, &result, false );
+
+    const uchar *src = image.constBits();
+    const int srcStride = image.bytesPerLine();
+    uchar *dst = result.bits();
+    const int dstStride = result.bytesPerLine();
+
+    // 180 degrees is reversed rows in reverse order, already sequential
+    const int bands = ( height + TileSize - 1 ) / TileSize;
+    forEach( bands, isParallel( image ), [ = ] ( const int &band ) {
+        const int last = qMin < int > ( height, ( band + 1 ) * TileSize );
+        for ( int y = band * TileSize; y < last; ++y ) {
+            const uchar *from = src + qptrdiff( y ) * srcStride;
+            uchar *to = dst + qptrdiff( height - 1 - y ) * dstStride;
+
+            if ( depth == 4 ) {
+                QPixelKernels::reverse32( from, to, width );
+            } else {
+                QPixelKernels::reverse24( from, to, width );
+            }
+        }
+    } );
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,31 @@
+#ifndef QImageRotation_H
+#define QImageRotation_H
+
+#include <QImage>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE ROTATION
+//! Lossless rotation by multiples of 90 degrees. 32 bit and RGB888 images
+//! are rotated in cache sized tiles with the pixel kernels, columns of
+//! tiles in parallel on large images; 32 bit tiles are transposed in SSE2
+//! registers where available, RGB888 ones are scalar on every path. Other
+//! formats use QImage::transformed().
+class QImageRotation
+{
+public:
+    enum { TileSize = 64 }; // 16 KB of 32 bit pixels per tile
+
+    static bool isSupported( const QImage::Format &format );
+
+    // positive is clockwise
+    static QImage rotated( const QImage &image, const int &degrees );
+
+private:
+    QImageRotation() {}
+
+    static QImage rotated90( const QImage &image, const bool &clockwise );
+    static QImage rotated180( const QImage &image );
+};
+
+#endif // QImageRotation_H
@@ -0,0 +1,20 @@
+#include "qimagescanner.h"
+#include "qdirectoryindex.h"
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE SCANNER //!
+QStringList QImageScanner::defaultNameFilters()
+{
+    return QStringList() << "*.png" << "*.jpg" << "*.bmp" << "*.ico" << "*.jpeg" << "*.gif";
+}
+
+//---------------------------------------------------------------------------
+
+QStringList QImageScanner::scan( const QString &dirPath, const QStringList &nameFilters, const bool &recursive )
+{
+    QDirectoryIndex index( QString() );
+    return index.scan( dirPath, nameFilters, recursive );
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,25 @@
+#ifndef QImageScanner_H
+#define QImageScanner_H
+
+#include <QString>
+#include <QStringList>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE SCANNER
+//! Finds the image files of a directory by name filters. One walk without
+//! a cache; QDirectoryIndex keeps the listings for the next scan.
+class QImageScanner
+{
+public:
+    static QStringList defaultNameFilters(); // "*.png", "*.jpg"...
+
+    static QStringList scan( const QString &dirPath,
+                             const QStringList &nameFilters = defaultNameFilters(),
+                             const bool &recursive = true );
+
+private:
+    QImageScanner() {}
+};
+
+#endif // QImageScanner_H
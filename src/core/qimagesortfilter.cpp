@@ -0,0 +1,186 @@
+#include "qimagesortfilter.h"
+#include "qimagemetadata.h"
+
+#include <QFileInfo>
+#include <QRegExp>
+#include <QVector>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+qint64 sortValue( const QImageMetadata &metadata, const QImageSortFilter::SortKey &key )
+{
+    switch ( key ) {
+    case QImageSortFilter::Size:
+        return metadata.fileSize;
+    case QImageSortFilter::CaptureTime:
+        if ( metadata.captureTime.isValid() ) {
+            return metadata.captureTime.toMSecsSinceEpoch();
+        }
+        // fall through
+    case QImageSortFilter::LastModified:
+        return metadata.lastModified.isValid() ? metadata.lastModified.toMSecsSinceEpoch()
+                                               : std::numeric_limits < qint64 >::min();
+    default:
+        return 0;
+    }
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! SORT AND FILTER //!
+QStringList QImageSortFilter::sort( const QStringList &paths,
+                                    const SortKey &key,
+                                    const Qt::SortOrder &order,
+                                    QImageMetadataCache *cache )
+{
+    if ( key == Unsorted ) {
+        return paths;
+    }
+
+    // sort positions, not strings, keys are computed once per path
+    std::vector < int > positions( paths.size() );
+    std::iota( positions.begin(), positions.end(), 0 );
+
+    QVector < qint64 > values;
+    if ( key != Name ) {
+        QImageMetadata::Fields fields = QImageMetadata::FileInfo;
+        if ( key == CaptureTime ) {
+            fields |= QImageMetadata::Exif;
+        }
+        cache->gather( paths, fields );
+
+        values.resize( paths.size() );
+        for ( int i = 0; i < paths.size(); ++i ) {
+            values[ i ] = sortValue( cache->value( paths.at( i ) ), key );
+        }
+    }
+
+    const bool descending = order == Qt::DescendingOrder;
+    std::stable_sort( positions.begin(), positions.end(), [ & ] ( const int &a, const int &b ) {
+        const int left = descending ? b : a;
+        const int right = descending ? a : b;
+
+        if ( !values.isEmpty() && values.at( left ) != values.at( right ) ) {
+            return values.at( left ) < values.at( right );
+        }
+
+        return naturalCompare( paths.at( left ), paths.at( right ) ) < 0;
+    } );
+
+    QStringList sorted;
+    sorted.reserve( paths.size() );
+    for ( std::vector < int >::const_iterator it = positions.begin(); it != positions.end(); ++it ) {
+        sorted.append( paths.at( *it ) );
+    }
+
+    return sorted;
+}
+
+//---------------------------------------------------------------------------
+
+QImageSortFilter::Result QImageSortFilter::apply( const QStringList &source,
+                                                  const Settings &settings,
+                                                  QImageMetadataCache *cache,
+                                                  const Result &previous )
+{
+    Result result;
+    result.settings = settings;
+
+    if ( !previous.sorted.isEmpty() && previous.settings.sortKey == settings.sortKey ) {
+        // same key: reuse the previous order, the comparator is fully
+        // reversed for descending order so flipping the list is exact
+        result.sorted = previous.sorted;
+        if ( previous.settings.sortOrder != settings.sortOrder && settings.sortKey != Unsorted ) {
+            std::reverse( result.sorted.begin(), result.sorted.end() );
+        }
+    } else {
+        result.sorted = sort( source, settings.sortKey, settings.sortOrder, cache );
+    }
+
+    result.paths = filter( result.sorted, settings.filter );
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+QStringList QImageSortFilter::filter( const QStringList &paths, const QString &wildcard )
+{
+    if ( wildcard.isEmpty() ) {
+        return paths;
+    }
+
+    const QRegExp matcher( wildcard, Qt::CaseInsensitive, QRegExp::Wildcard );
+
+    QStringList filtered;
+    foreach ( const QString &path, paths ) {
+        if ( matcher.exactMatch( QFileInfo( path ).fileName() ) ) {
+            filtered.append( path );
+        }
+    }
+
+    return filtered;
+}
+
+//---------------------------------------------------------------------------
+
+int QImageSortFilter::naturalCompare( const QString &left, const QString &right )
+{
+    const QChar *l = left.constData();
+    const QChar *r = right.constData();
+    const QChar *lEnd = l + left.size();
+    const QChar *rEnd = r + right.size();
+
+    while ( l != lEnd && r != rEnd ) {
+        if ( l->isDigit() && r->isDigit() ) {
+            // skip leading zeros, then a longer run is a bigger number
+            while ( l != lEnd && *l == QLatin1Char( '0' ) ) { ++l; }
+            while ( r != rEnd && *r == QLatin1Char( '0' ) ) { ++r; }
+
+            const QChar *lDigits = l;
+            const QChar *rDigits = r;
+            while ( l != lEnd && l->isDigit() ) { ++l; }
+            while ( r != rEnd && r->isDigit() ) { ++r; }
+
+            const int lengthDifference = int( l - lDigits ) - int( r - rDigits );
+            if ( lengthDifference != 0 ) {
+                return lengthDifference;
+            }
+
+            for ( ; lDigits != l; ++lDigits, ++rDigits ) {
+                if ( *lDigits != *rDigits ) {
+                    return lDigits->unicode() - rDigits->unicode();
+                }
+            }
+            continue;
+        }
+
+        const QChar lFolded = l->toCaseFolded();
+        const QChar rFolded = r->toCaseFolded();
+        if ( lFolded != rFolded ) {
+            return lFolded.unicode() - rFolded.unicode();
+        }
+
+        ++l;
+        ++r;
+    }
+
+    if ( l != lEnd ) {
+        return 1;
+    }
+    if ( r != rEnd ) {
+        return -1;
+    }
+
+    // equal ignoring case and zeros, keep the order total
+    return QString::compare( left, right );
+}
+
+//---------------------------------------------------------------------------
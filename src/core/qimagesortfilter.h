@@ -0,0 +1,66 @@
+#ifndef QImageSortFilter_H
+#define QImageSortFilter_H
+
+#include <QString>
+#include <QStringList>
+
+class QImageMetadataCache;
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! SORT AND FILTER
+//! Pure functions over path lists, meant to run on a worker thread.
+//! Metadata needed by the sort key is gathered in parallel through the
+//! cache, so sorting the same folder again does not touch the disk.
+class QImageSortFilter
+{
+public:
+    enum SortKey {
+        Unsorted,       // directory iterator order
+        Name,           // natural order: "img2" < "img10"
+        LastModified,
+        Size,
+        CaptureTime     // EXIF, falls back to last modified
+    };
+
+    struct Settings {
+        Settings()
+            : sortKey( Unsorted ), sortOrder( Qt::AscendingOrder ) {}
+
+        SortKey sortKey;
+        Qt::SortOrder sortOrder;
+        QString filter; // wildcard on the file name, empty for all
+
+        bool isIdentity() const {
+            return sortKey == Unsorted && filter.isEmpty();
+        }
+    };
+
+    struct Result {
+        Settings settings;
+        QStringList sorted; // whole source in sort order
+        QStringList paths;  // sorted and filtered
+    };
+
+    // previous must come from the same source, it is reused when only the
+    // order or the filter changed
+    static Result apply( const QStringList &source,
+                         const Settings &settings,
+                         QImageMetadataCache *cache,
+                         const Result &previous = Result() );
+
+    static QStringList sort( const QStringList &paths,
+                             const SortKey &key,
+                             const Qt::SortOrder &order,
+                             QImageMetadataCache *cache );
+
+    static QStringList filter( const QStringList &paths, const QString &wildcard );
+
+    // case insensitive, digit runs compared by value
+    static int naturalCompare( const QString &left, const QString &right );
+
+private:
+    QImageSortFilter() {}
+};
+
+#endif // QImageSortFilter_H
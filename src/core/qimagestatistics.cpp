@@ -0,0 +1,404 @@
+#include "qimagestatistics.h"
+#include "qpixelkernels.h"
+#include "qimagewidgetlogging.h"
+
+#include <QPainter>
+#include <QThread>
+#include <QtConcurrent>
+
+namespace {
+
+// counters of one band must not overflow 32 bits
+const qint64 MaxBandPixels = 1 << 24;
+
+// not worth the threads below this
+const qint64 MinParallelPixels = 1 << 18;
+
+// the histograms of one cache entry
+const qint64 HistogramBytes = QImageStatistics::ChannelCount * QImageStatistics::Levels * qint64( sizeof( quint64 ) );
+
+struct Band
+{
+    QRect rect;
+    QVector < quint64 > histogram;
+};
+
+void histogramOfBand( const QImage &image, const bool &direct, Band *band )
+{
+    QVector < quint32 > histograms( QPixelKernels::HistogramCopies * QPixelKernels::HistogramSize, 0 );
+
+    if ( direct ) {
+        for ( int y = band->rect.top(); y <= band->rect.bottom(); ++y ) {
+            QPixelKernels::histogram( reinterpret_cast < const QRgb * > ( image.constScanLine( y ) ) + band->rect.left(),
+                                      band->rect.width(), histograms.data() );
+        }
+    } else {
+        // conversion per band keeps it parallel and the memory small
+        const QImage converted = image.copy( band->rect ).convertToFormat( QImage::Format_ARGB32 );
+        for ( int y = 0; y < converted.height(); ++y ) {
+            QPixelKernels::histogram( reinterpret_cast < const QRgb * > ( converted.constScanLine( y ) ),
+                                      converted.width(), histograms.data() );
+        }
+    }
+
+    band->histogram.fill( 0, QPixelKernels::HistogramSize );
+    for ( int copy = 0; copy < QPixelKernels::HistogramCopies; ++copy ) {
+        const quint32 *counts = histograms.constData() + copy * QPixelKernels::HistogramSize;
+        for ( int i = 0; i < QPixelKernels::HistogramSize; ++i ) {
+            band->histogram[ i ] += counts[ i ];
+        }
+    }
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE STATISTICS //!
+QImageStatistics::QImageStatistics()
+    : m_histogram( ChannelCount * Levels, 0 ),
+      m_pixelCount( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QImageStatistics QImageStatistics::compute( const QImage &image, const QRect &rect )
+{
+    QImageStatistics statistics;
+
+    const QRect area = ( rect.isNull() ? image.rect() : rect ) & image.rect();
+    if ( area.isEmpty() ) {
+        return statistics;
+    }
+
+    const bool direct = image.format() == QImage::Format_ARGB32 ||
+                        image.format() == QImage::Format_RGB32;
+
+    const qint64 pixels = qint64( area.width() ) * area.height();
+    int bands = 1;
+    if ( pixels >= MinParallelPixels ) {
+        bands = qMax < qint64 > ( QThread::idealThreadCount() * 4, pixels / MaxBandPixels + 1 );
+    }
+    bands = qMin( bands, area.height() );
+
+    QVector < Band > work( bands );
+    for ( int i = 0; i < bands; ++i ) {
+        const int top = area.top() + int( qint64( area.height() ) * i / bands );
+        const int bottom = area.top() + int( qint64( area.height() ) * ( i + 1 ) / bands );
+        work[ i ].rect = QRect( area.left(), top, area.width(), bottom - top );
+    }
+
+    if ( bands == 1 ) {
+        histogramOfBand( image, direct, &work[ 0 ] );
+    } else {
+        QtConcurrent::blockingMap( work, [ &image, direct ] ( Band &band ) {
+            histogramOfBand( image, direct, &band );
+        } );
+    }
+
+    foreach ( const Band &band, work ) {
+        for ( int i = 0; i < QPixelKernels::HistogramSize; ++i ) {
+            statistics.m_histogram[ i ] += band.histogram.at( i );
+        }
+    }
+    statistics.m_pixelCount = quint64( pixels );
+
+    return statistics;
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+quint64 QImageStatistics::count( const Channel &channel, const int &level ) const
+{
+    if ( level < 0 || level >= Levels ) {
+        return 0;
+    }
+
+    return m_histogram.at( channel * Levels + level );
+}
+
+//---------------------------------------------------------------------------
+
+int QImageStatistics::minimum( const Channel &channel ) const
+{
+    for ( int level = 0; level < Levels; ++level ) {
+        if ( count( channel, level ) ) {
+            return level;
+        }
+    }
+
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+
+int QImageStatistics::maximum( const Channel &channel ) const
+{
+    for ( int level = Levels - 1; level >= 0; --level ) {
+        if ( count( channel, level ) ) {
+            return level;
+        }
+    }
+
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+
+double QImageStatistics::mean( const Channel &channel ) const
+{
+    if ( isNull() ) {
+        return 0;
+    }
+
+    quint64 sum = 0;
+    for ( int level = 0; level < Levels; ++level ) {
+        sum += count( channel, level ) * level;
+    }
+
+    return double( sum ) / m_pixelCount;
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+//! [2]
+void QImageStatistics::add( const QImageStatistics &other )
+{
+    for ( int i = 0; i < m_histogram.size(); ++i ) {
+        m_histogram[ i ] += other.m_histogram.at( i );
+    }
+    m_pixelCount += other.m_pixelCount;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageStatistics::subtract( const QImageStatistics &other )
+{
+    for ( int i = 0; i < m_histogram.size(); ++i ) {
+        m_histogram[ i ] -= qMin( m_histogram.at( i ), other.m_histogram.at( i ) );
+    }
+    m_pixelCount -= qMin( m_pixelCount, other.m_pixelCount );
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+QImage QImageStatistics::histogramImage( const QSize &size ) const
+{
+    QImage image( size, QImage::Format_ARGB32_Premultiplied );
+    image.fill( QColor( 32, 32, 32 ) );
+
+    if ( isNull() || size.isEmpty() ) {
+        return image;
+    }
+
+    // clipped levels are usually spikes, they would flatten the rest
+    quint64 highest = 1;
+    for ( int channel = Red; channel <= Blue; ++channel ) {
+        for ( int level = 1; level < Levels - 1; ++level ) {
+            highest = qMax( highest, count( Channel( channel ), level ) );
+        }
+    }
+
+    const QColor colors[] = { Qt::red, Qt::green, Qt::blue };
+
+    QPainter painter( &image );
+    painter.setCompositionMode( QPainter::CompositionMode_Plus );
+    for ( int channel = Red; channel <= Blue; ++channel ) {
+        for ( int level = 0; level < Levels; ++level ) {
+            const double height = qMin( 1.0, double( count( Channel( channel ), level ) ) / highest ) * size.height();
+            const QRectF bar( double( level ) * size.width() / Levels, size.height() - height,
+                              double( size.width() ) / Levels, height );
+            painter.fillRect( bar, colors[ channel ] );
+        }
+    }
+
+    return image;
+}
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE STATISTICS CACHE //!
+QImageStatisticsCache::QImageStatisticsCache()
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QImageStatistics QImageStatisticsCache::statistics( const QPixmap &pixmap, const QRect &rect )
+{
+    const Key entry = key( pixmap, rect );
+    QHash < Key, Entry >::iterator it = m_entries.find( entry );
+    if ( it != m_entries.end() ) {
+        it.value().lastUsed = QMemoryGovernor::now();
+        return it.value().statistics;
+    }
+
+    const QRect area = entry.rect.isNull() ? pixmap.rect() : entry.rect;
+    QIW_TRACE_VALUE( lcImageWidgetEdit, "Compute statistics, pixels:", qint64( area.width() ) * area.height() );
+
+    const QImageStatistics statistics = QImageStatistics::compute( pixmap.toImage(), area );
+    insert( entry, statistics );
+    return statistics;
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageStatisticsCache::contains( const QPixmap &pixmap, const QRect &rect ) const
+{
+    return m_entries.contains( key( pixmap, rect ) );
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+void QImageStatisticsCache::rotated( const QPixmap &source, const QPixmap &result )
+{
+    materialized( source, QRect(), result );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageStatisticsCache::cropped( const QPixmap &source, const QRect &sourceRect, const QRect &rect )
+{
+    if ( !contains( source, sourceRect ) || contains( source, rect ) ) {
+        return;
+    }
+
+    const QImage image = source.toImage(); // shares the pixels
+    const QRect parent = sourceRect.isNull() ? image.rect() : sourceRect & image.rect();
+    const QRect kept = rect & parent;
+    const qint64 keptPixels = qint64( kept.width() ) * kept.height();
+    const qint64 removedPixels = qint64( parent.width() ) * parent.height() - keptPixels;
+
+    if ( kept.isEmpty() || keptPixels <= removedPixels ) {
+        insert( key( source, rect ), QImageStatistics::compute( image, kept ) );
+        return;
+    }
+
+    // parent minus the bands around the kept rect
+    QImageStatistics statistics = m_entries.value( key( source, sourceRect ) ).statistics;
+    const QRect removed[] = {
+        QRect( parent.left(), parent.top(), parent.width(), kept.top() - parent.top() ),
+        QRect( parent.left(), kept.bottom() + 1, parent.width(), parent.bottom() - kept.bottom() ),
+        QRect( parent.left(), kept.top(), kept.left() - parent.left(), kept.height() ),
+        QRect( kept.right() + 1, kept.top(), parent.right() - kept.right(), kept.height() )
+    };
+    for ( int i = 0; i < 4; ++i ) {
+        if ( !removed[ i ].isEmpty() ) {
+            statistics.subtract( QImageStatistics::compute( image, removed[ i ] ) );
+        }
+    }
+
+    insert( key( source, rect ), statistics );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageStatisticsCache::materialized( const QPixmap &source, const QRect &rect, const QPixmap &result )
+{
+    if ( contains( source, rect ) && !contains( result ) ) {
+        insert( key( result, QRect() ), m_entries.value( key( source, rect ) ).statistics );
+    }
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+void QImageStatisticsCache::clear()
+{
+    m_entries.clear();
+    m_order.clear();
+}
+
+//---------------------------------------------------------------------------
+
+QImageStatisticsCache::Key QImageStatisticsCache::key( const QPixmap &pixmap, const QRect &rect )
+{
+    Key key;
+    key.cacheKey = pixmap.cacheKey();
+    key.rect = rect == pixmap.rect() ? QRect() : rect;
+    return key;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageStatisticsCache::insert( const Key &key, const QImageStatistics &statistics )
+{
+    if ( !m_entries.contains( key ) ) {
+        m_order.append( key );
+    }
+
+    Entry entry;
+    entry.statistics = statistics;
+    entry.cost = QMemoryGovernor::estimatedCost( qint64( statistics.pixelCount() ) * 4 );
+    entry.lastUsed = QMemoryGovernor::now();
+    m_entries.insert( key, entry );
+
+    while ( m_order.size() > MaxEntries ) {
+        m_entries.remove( m_order.takeFirst() );
+    }
+
+    grown();
+}
+
+//---------------------------------------------------------------------------
+
+//! [2]
+qint64 QImageStatisticsCache::bytes() const
+{
+    // the histograms, the rest is small
+    return qint64( m_entries.size() ) * ( HistogramBytes + qint64( sizeof( Entry ) ) );
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageStatisticsCache::candidate( QMemoryGovernor::Candidate *candidate ) const
+{
+    const QList < Key >::const_iterator it = leastRecentlyUsed();
+    if ( it == m_order.constEnd() ) {
+        return false;
+    }
+
+    const Entry entry = m_entries.value( *it );
+    candidate->lastUsed = entry.lastUsed;
+    candidate->cost = entry.cost;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QImageStatisticsCache::evict()
+{
+    const QList < Key >::const_iterator it = leastRecentlyUsed();
+    if ( it == m_order.constEnd() ) {
+        return 0;
+    }
+
+    m_entries.remove( *it );
+    m_order.removeAt( int( it - m_order.constBegin() ) );
+    return HistogramBytes + qint64( sizeof( Entry ) );
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+QList < QImageStatisticsCache::Key >::const_iterator QImageStatisticsCache::leastRecentlyUsed() const
+{
+    // a few dozen entries at most
+    QList < Key >::const_iterator oldest = m_order.constEnd();
+    for ( QList < Key >::const_iterator it = m_order.constBegin(); it != m_order.constEnd(); ++it ) {
+        if ( oldest == m_order.constEnd() || m_entries.value( *it ).lastUsed < m_entries.value( *oldest ).lastUsed ) {
+            oldest = it;
+        }
+    }
+
+    return oldest;
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,126 @@
+#ifndef QImageStatistics_H
+#define QImageStatistics_H
+
+#include <QImage>
+#include <QPixmap>
+#include <QRect>
+#include <QVector>
+#include <QHash>
+#include <QList>
+
+#include "qmemorygovernor.h"
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE STATISTICS
+//! Per channel histograms of an image or a part of it. Minimum, maximum,
+//! mean and clipped counts are derived from the histograms, so statistics
+//! of disjoint parts can be added and subtracted. Counted by the scalar
+//! QPixelKernels::histogram, there is no vector version, over row bands on
+//! every core.
+class QImageStatistics
+{
+public:
+    enum Channel { Red, Green, Blue, Alpha };
+    enum { ChannelCount = 4, Levels = 256 };
+
+    QImageStatistics();
+
+    // row bands in parallel, rect defaults to the whole image
+    static QImageStatistics compute( const QImage &image, const QRect &rect = QRect() );
+
+    //! [1] VALUES
+    bool isNull() const { return m_pixelCount == 0; }
+    quint64 pixelCount() const { return m_pixelCount; }
+    quint64 count( const Channel &channel, const int &level ) const;
+
+    int minimum( const Channel &channel ) const;   // -1 if null
+    int maximum( const Channel &channel ) const;   // -1 if null
+    double mean( const Channel &channel ) const;
+
+    quint64 clippedLow( const Channel &channel ) const { return count( channel, 0 ); }
+    quint64 clippedHigh( const Channel &channel ) const { return count( channel, Levels - 1 ); }
+    //! [1]
+
+    //! [2] ARITHMETIC
+    void add( const QImageStatistics &other );
+    void subtract( const QImageStatistics &other ); // other must be a part of this
+    //! [2]
+
+    // red, green and blue histograms drawn over each other
+    QImage histogramImage( const QSize &size ) const;
+
+private:
+    QVector < quint64 > m_histogram; // ChannelCount x Levels
+    quint64 m_pixelCount;
+};
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE STATISTICS CACHE
+//! Statistics of pixmaps, or of a rect of one, by QPixmap::cacheKey() and
+//! the rect; a null rect is the whole pixmap. Edits derive the statistics
+//! of their result from the source instead of computing them again:
+//! rotation keeps the histograms, a crop computes the smaller of the kept
+//! or removed area. Undo and redo reuse cached pixmaps. Under a
+//! QMemoryGovernor the least recently used go first.
+class QImageStatisticsCache : public QMemoryGovernor::Client
+{
+public:
+    enum { MaxEntries = 32 };
+
+    QImageStatisticsCache();
+
+    QImageStatistics statistics( const QPixmap &pixmap, const QRect &rect = QRect() ); // computes on a miss
+    bool contains( const QPixmap &pixmap, const QRect &rect = QRect() ) const;
+
+    //! [1] EDITS
+    void rotated( const QPixmap &source, const QPixmap &result );
+
+    // rect and sourceRect are rects of source, rect inside sourceRect
+    void cropped( const QPixmap &source, const QRect &sourceRect, const QRect &rect );
+
+    // result is the copy of rect of source
+    void materialized( const QPixmap &source, const QRect &rect, const QPixmap &result );
+    //! [1]
+
+    void clear();
+
+    //! [2] GOVERNOR
+    qint64 bytes() const override;
+    bool candidate( QMemoryGovernor::Candidate *candidate ) const override;
+    qint64 evict() override;
+    //! [2]
+
+private:
+    struct Entry {
+        Entry() : cost( 0 ), lastUsed( 0 ) {}
+
+        QImageStatistics statistics;
+        qint64 cost;     // ms to compute it again, estimated
+        qint64 lastUsed; // QMemoryGovernor::now()
+    };
+
+    struct Key {
+        qint64 cacheKey;
+        QRect rect; // null for the whole pixmap
+
+        bool operator ==( const Key &other ) const {
+            return cacheKey == other.cacheKey && rect == other.rect;
+        }
+    };
+
+    friend uint qHash( const Key &key, uint seed ) {
+        return qHash( key.cacheKey, seed ) ^ qHash( qint64( key.rect.x() ) << 32 | uint( key.rect.y() ), seed )
+               ^ qHash( qint64( key.rect.width() ) << 32 | uint( key.rect.height() ), seed );
+    }
+
+    static Key key( const QPixmap &pixmap, const QRect &rect );
+    void insert( const Key &key, const QImageStatistics &statistics );
+    QList < Key >::const_iterator leastRecentlyUsed() const;
+
+    QHash < Key, Entry > m_entries;
+    QList < Key > m_order; // oldest first
+};
+
+#endif // QImageStatistics_H
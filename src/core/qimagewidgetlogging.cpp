@@ -0,0 +1,114 @@
+#include "qimagewidgetlogging.h"
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <atomic>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! LOGGING CATEGORIES //!
+Q_LOGGING_CATEGORY( lcImageWidgetPixmap, "qimagewidget.pixmap", QtWarningMsg )
+Q_LOGGING_CATEGORY( lcImageWidgetView, "qimagewidget.view", QtWarningMsg )
+Q_LOGGING_CATEGORY( lcImageWidgetEdit, "qimagewidget.edit", QtWarningMsg )
+Q_LOGGING_CATEGORY( lcImageWidgetPreview, "qimagewidget.preview", QtWarningMsg )
+Q_LOGGING_CATEGORY( lcImageWidgetKernels, "qimagewidget.kernels", QtWarningMsg )
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! TRACE RING BUFFER //!
+namespace {
+
+struct TraceSlot
+{
+    // 2 * ticket + 1 while writing, 2 * ticket + 2 when complete
+    std::atomic < quint64 > sequence;
+    std::atomic < qint64 > timestamp;
+    std::atomic < const char * > function;
+    std::atomic < const char * > message;
+    std::atomic < qint64 > value;
+};
+
+TraceSlot traceSlots[ QImageWidgetTrace::Capacity ];
+std::atomic < quint64 > traceHead( 0 );
+
+qint64 traceTimestamp()
+{
+    static QElapsedTimer timer = [] () {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    } ();
+
+    return timer.nsecsElapsed();
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+
+void QImageWidgetTrace::record( const char *function, const char *message, const qint64 &value )
+{
+    const quint64 ticket = traceHead.fetch_add( 1, std::memory_order_relaxed );
+    TraceSlot &slot = traceSlots[ ticket % Capacity ];
+
+    slot.sequence.store( 2 * ticket + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    slot.timestamp.store( traceTimestamp(), std::memory_order_relaxed );
+    slot.function.store( function, std::memory_order_relaxed );
+    slot.message.store( message, std::memory_order_relaxed );
+    slot.value.store( value, std::memory_order_relaxed );
+
+    slot.sequence.store( 2 * ticket + 2, std::memory_order_release );
+}
+
+//---------------------------------------------------------------------------
+
+QList < QImageWidgetTraceEvent > QImageWidgetTrace::snapshot()
+{
+    QList < QImageWidgetTraceEvent > events;
+
+    const quint64 head = traceHead.load( std::memory_order_acquire );
+    const quint64 first = head > quint64( Capacity ) ? head - Capacity : 0;
+
+    for ( quint64 ticket = first; ticket < head; ++ticket ) {
+        const TraceSlot &slot = traceSlots[ ticket % Capacity ];
+
+        const quint64 before = slot.sequence.load( std::memory_order_acquire );
+        if ( before != 2 * ticket + 2 ) {   // in progress or already overwritten
+            continue;
+        }
+
+        QImageWidgetTraceEvent event;
+        event.timestamp = slot.timestamp.load( std::memory_order_relaxed );
+        event.function = slot.function.load( std::memory_order_relaxed );
+        event.message = slot.message.load( std::memory_order_relaxed );
+        event.value = slot.value.load( std::memory_order_relaxed );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if ( slot.sequence.load( std::memory_order_relaxed ) == before ) {
+            events.append( event );
+        }
+    }
+
+    return events;
+}
+
+//---------------------------------------------------------------------------
+
+QString QImageWidgetTrace::dump()
+{
+    QStringList lines;
+    foreach ( const QImageWidgetTraceEvent &event, snapshot() ) {
+        lines.append( QString( "[%1 ms] %2: %3 %4" )
+                      .arg( event.timestamp / 1000000.0, 0, 'f', 3 )
+                      .arg( QString::fromLatin1( event.function ) )
+                      .arg( QString::fromUtf8( event.message ) )
+                      .arg( event.value ) );
+    }
+
+    return lines.join( "\n" );
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+#ifndef QImageWidgetLogging_H
+#define QImageWidgetLogging_H
+
+#include <QtGlobal>
+#include <QLoggingCategory>
+#include <QList>
+#include <QString>
+
+//! Debug output is removed at compile time in release builds. Define
+//! QIMAGEWIDGET_DEBUG_OUTPUT to keep it, QIMAGEWIDGET_NO_TRACE to drop the
+//! event ring buffer as well.
+#if defined( QT_NO_DEBUG ) && !defined( QIMAGEWIDGET_DEBUG_OUTPUT )
+#define QIMAGEWIDGET_NO_DEBUG_OUTPUT
+#endif
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! LOGGING CATEGORIES
+Q_DECLARE_LOGGING_CATEGORY( lcImageWidgetPixmap )   // qimagewidget.pixmap
+Q_DECLARE_LOGGING_CATEGORY( lcImageWidgetView )     // qimagewidget.view
+Q_DECLARE_LOGGING_CATEGORY( lcImageWidgetEdit )     // qimagewidget.edit
+Q_DECLARE_LOGGING_CATEGORY( lcImageWidgetPreview )  // qimagewidget.preview
+Q_DECLARE_LOGGING_CATEGORY( lcImageWidgetKernels )  // qimagewidget.kernels
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! TRACE EVENT
+struct QImageWidgetTraceEvent
+{
+    qint64 timestamp;       // ns since the first recorded event
+    const char *function;   // static string, Q_FUNC_INFO
+    const char *message;    // static string literal
+    qint64 value;
+};
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! TRACE RING BUFFER
+//! Fixed size, lock-free ring of the most recent events. Writers never block,
+//! every slot is guarded by a sequence number so snapshot() skips slots that
+//! are being overwritten. Only pointers to static strings are stored, so
+//! recording costs a timestamp and a few stores.
+class QImageWidgetTrace
+{
+public:
+    enum { Capacity = 512 };
+
+    static void record( const char *function, const char *message, const qint64 &value = 0 );
+
+    // oldest first
+    static QList < QImageWidgetTraceEvent > snapshot();
+
+    // "[timestamp] function: message value" lines, for bug reports
+    static QString dump();
+
+private:
+    QImageWidgetTrace() {}
+};
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! MACROS
+#ifdef QIMAGEWIDGET_NO_TRACE
+#define QIW_RECORD( message, value ) do {} while ( false )
+#else
+#define QIW_RECORD( message, value ) QImageWidgetTrace::record( Q_FUNC_INFO, message, value )
+#endif
+
+#ifdef QIMAGEWIDGET_NO_DEBUG_OUTPUT
+#define QIW_DEBUG( category ) while ( false ) QMessageLogger().noDebug()
+#else
+#define QIW_DEBUG( category ) qCDebug( category ) << Q_FUNC_INFO
+#endif
+
+// message must be a string literal
+#define QIW_TRACE( category, message ) \
+    do { \
+        QIW_RECORD( message, 0 ); \
+        QIW_DEBUG( category ) << message; \
+    } while ( false )
+
+#define QIW_TRACE_VALUE( category, message, value ) \
+    do { \
+        QIW_RECORD( message, qint64( value ) ); \
+        QIW_DEBUG( category ) << message << ( value ); \
+    } while ( false )
+
+#endif // QImageWidgetLogging_H
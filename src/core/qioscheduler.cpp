@@ -0,0 +1,399 @@
+#include "qioscheduler.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QStringList>
+#include <QThread>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#else
+#include <QStorageInfo>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/statfs.h>
+#include <sys/sysmacros.h>
+#endif
+
+Q_GLOBAL_STATIC( QIoScheduler, globalScheduler )
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// statfs() f_type of file systems with a network round trip per read
+const quint32 NetworkFileSystems[] = {
+    0x6969,     // NFS
+    0x517B,     // SMB
+    0xFF534D42, // CIFS
+    0xFE534D42  // SMB2
+};
+#endif
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! RUNNER //!
+class QIoScheduler::Runner : public QRunnable
+{
+public:
+    Runner( QIoScheduler *scheduler, const Job &job )
+        : m_scheduler( scheduler ),
+          m_job( job )
+    {
+
+    }
+
+    void run() override
+    {
+        m_job.task();
+        m_scheduler->finished( m_job );
+    }
+
+private:
+    QIoScheduler *m_scheduler;
+    Job m_job;
+};
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! CLAIM //!
+QIoScheduler::Claim::Claim( QIoScheduler *scheduler, const QString &path )
+    : m_scheduler( scheduler ),
+      m_device( deviceOf( path ) )
+{
+    m_scheduler->beginInteractive( m_device );
+}
+
+//---------------------------------------------------------------------------
+
+QIoScheduler::Claim::~Claim()
+{
+    m_scheduler->endInteractive( m_device );
+}
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IO SCHEDULER //!
+QIoScheduler::QIoScheduler()
+    : m_backgroundCount( 0 ),
+      m_maxConcurrency( QThread::idealThreadCount() ),
+      m_nextId( 0 )
+{
+    m_pool.setMaxThreadCount( m_maxConcurrency + 1 );
+}
+
+//---------------------------------------------------------------------------
+
+QIoScheduler::~QIoScheduler()
+{
+    m_mutex.lock();
+    for ( int priority = 0; priority < PriorityCount; ++priority ) {
+        foreach ( const Job &job, m_pending[ priority ] ) {
+            m_active.remove( job.id );
+        }
+        m_pending[ priority ].clear();
+    }
+    m_mutex.unlock();
+
+    m_pool.waitForDone();
+}
+
+//---------------------------------------------------------------------------
+
+QIoScheduler *QIoScheduler::globalInstance()
+{
+    return globalScheduler();
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+quint64 QIoScheduler::submit( const QString &path, const Priority &priority, const Task &task )
+{
+    const quint64 device = deviceOf( path );
+
+    QMutexLocker locker( &m_mutex );
+    detect( device, path );
+
+    Job job;
+    job.id = ++m_nextId;
+    job.device = device;
+    job.priority = priority;
+    job.task = task;
+
+    m_pending[ priority ].append( job );
+    m_active.insert( job.id );
+    dispatch();
+
+    return job.id;
+}
+
+//---------------------------------------------------------------------------
+
+bool QIoScheduler::setPriority( const quint64 &id, const Priority &priority )
+{
+    QMutexLocker locker( &m_mutex );
+    for ( int current = 0; current < PriorityCount; ++current ) {
+        for ( int i = 0; i < m_pending[ current ].size(); ++i ) {
+            if ( m_pending[ current ].at( i ).id != id ) {
+                continue;
+            }
+
+            if ( current != priority ) {
+                Job job = m_pending[ current ].takeAt( i );
+                job.priority = priority;
+                m_pending[ priority ].append( job );
+                dispatch();
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+
+bool QIoScheduler::cancel( const quint64 &id )
+{
+    QMutexLocker locker( &m_mutex );
+    for ( int priority = 0; priority < PriorityCount; ++priority ) {
+        for ( int i = 0; i < m_pending[ priority ].size(); ++i ) {
+            if ( m_pending[ priority ].at( i ).id == id ) {
+                m_pending[ priority ].removeAt( i );
+                m_active.remove( id );
+                m_done.wakeAll();
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::wait( const quint64 &id )
+{
+    QMutexLocker locker( &m_mutex );
+    while ( m_active.contains( id ) ) {
+        m_done.wait( &m_mutex );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::waitForDone()
+{
+    QMutexLocker locker( &m_mutex );
+    while ( !m_active.isEmpty() ) {
+        m_done.wait( &m_mutex );
+    }
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+//! [2]
+void QIoScheduler::setConcurrency( const QString &path, const int &concurrency )
+{
+    const quint64 device = deviceOf( path );
+
+    QMutexLocker locker( &m_mutex );
+    if ( concurrency > 0 ) {
+        m_concurrency.insert( device, concurrency );
+    } else {
+        m_concurrency.remove( device );
+    }
+    dispatch();
+}
+
+//---------------------------------------------------------------------------
+
+int QIoScheduler::concurrency( const QString &path )
+{
+    const quint64 device = deviceOf( path );
+
+    QMutexLocker locker( &m_mutex );
+    detect( device, path );
+    return concurrencyOf( device );
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::setMaxConcurrency( const int &concurrency )
+{
+    QMutexLocker locker( &m_mutex );
+    m_maxConcurrency = qMax( 1, concurrency );
+    m_pool.setMaxThreadCount( m_maxConcurrency + 1 );
+    dispatch();
+}
+
+//---------------------------------------------------------------------------
+
+int QIoScheduler::maxConcurrency() const
+{
+    return m_maxConcurrency;
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+quint64 QIoScheduler::deviceOf( const QString &path )
+{
+#ifdef Q_OS_UNIX
+    struct stat status;
+    if ( ::stat( QFile::encodeName( path ).constData(), &status ) == 0 ) {
+        return quint64( status.st_dev );
+    }
+
+    // not written yet, its directory then
+    if ( ::stat( QFile::encodeName( QFileInfo( path ).absolutePath() ).constData(), &status ) == 0 ) {
+        return quint64( status.st_dev );
+    }
+
+    return 0;
+#else
+    return qHash( QStorageInfo( QFileInfo( path ).absolutePath() ).rootPath() );
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+int QIoScheduler::automaticConcurrency( const QString &path )
+{
+#ifdef Q_OS_LINUX
+    const QByteArray name = QFile::encodeName( QFileInfo( path ).absolutePath() );
+
+    struct statfs fileSystem;
+    if ( ::statfs( name.constData(), &fileSystem ) == 0 ) {
+        for ( const quint32 type : NetworkFileSystems ) {
+            if ( quint32( fileSystem.f_type ) == type ) {
+                return 2; // hides some latency without flooding the link
+            }
+        }
+    }
+
+    struct stat status;
+    if ( ::stat( name.constData(), &status ) == 0 ) {
+        // partitions have the queue of their disk one level up
+        const QString block = QString( "/sys/dev/block/%1:%2/" ).arg( major( status.st_dev ) ).arg( minor( status.st_dev ) );
+        foreach ( const QString &queue, QStringList() << block + "queue/rotational" << block + "../queue/rotational" ) {
+            QFile file( queue );
+            if ( file.open( QIODevice::ReadOnly ) ) {
+                if ( file.readAll().trimmed() == "1" ) {
+                    return 1; // every extra stream is a seek
+                }
+                break;
+            }
+        }
+    }
+#else
+    Q_UNUSED( path );
+#endif
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::detect( const quint64 &device, const QString &path )
+{
+    // once per device, while a path on it is at hand
+    if ( !m_automatic.contains( device ) ) {
+        m_automatic.insert( device, automaticConcurrency( path ) );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+int QIoScheduler::concurrencyOf( const quint64 &device ) const
+{
+    QHash < quint64, int >::const_iterator it = m_concurrency.constFind( device );
+    if ( it != m_concurrency.constEnd() ) {
+        return it.value();
+    }
+
+    const int automatic = m_automatic.value( device );
+    return automatic > 0 ? qMin( automatic, m_maxConcurrency ) : m_maxConcurrency;
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::dispatch()
+{
+    for ( int priority = 0; priority < PriorityCount; ++priority ) {
+        QList < Job > &pending = m_pending[ priority ];
+        for ( int i = 0; i < pending.size(); ) {
+            const Job &job = pending.at( i );
+
+            bool ready = true;
+            if ( priority != Interactive ) {
+                // the user's load owns the device until it is done
+                ready = m_interactive.value( job.device ) == 0
+                        && m_running.value( job.device ) < concurrencyOf( job.device )
+                        && m_backgroundCount < m_maxConcurrency;
+            }
+
+            if ( ready ) {
+                start( pending.takeAt( i ) );
+            } else {
+                ++i;
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::start( const Job &job )
+{
+    if ( job.priority == Interactive ) {
+        ++m_interactive[ job.device ];
+    } else {
+        ++m_running[ job.device ];
+        ++m_backgroundCount;
+    }
+
+    // the spare thread goes to the user first
+    m_pool.start( new Runner( this, job ), job.priority == Interactive ? 1 : 0 );
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::finished( const Job &job )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( job.priority == Interactive ) {
+        --m_interactive[ job.device ];
+    } else {
+        --m_running[ job.device ];
+        --m_backgroundCount;
+    }
+
+    m_active.remove( job.id );
+    dispatch();
+    m_done.wakeAll();
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::beginInteractive( const quint64 &device )
+{
+    QMutexLocker locker( &m_mutex );
+    ++m_interactive[ device ];
+}
+
+//---------------------------------------------------------------------------
+
+void QIoScheduler::endInteractive( const quint64 &device )
+{
+    QMutexLocker locker( &m_mutex );
+    --m_interactive[ device ];
+    dispatch();
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,121 @@
+#ifndef QIoScheduler_H
+#define QIoScheduler_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <functional>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IO SCHEDULER
+//! Runs file bound tasks (decodes, thumbnails) most urgent first, with a
+//! limit of tasks per storage device. Work the user waits for preempts
+//! the rest: interactive tasks start at once whatever the limit, and while
+//! one runs or a Claim is held on a device no other task starts there.
+//! Tasks already running are let finish, a decode cannot be resumed.
+//! Thread safe; tasks run on a pool of the scheduler's own.
+class QIoScheduler
+{
+public:
+    // most urgent first; Batch is work the user started over many files
+    enum Priority { Interactive, VisibleThumbnail, Prefetch, Batch, OffscreenThumbnail, PriorityCount };
+
+    typedef std::function < void () > Task;
+
+    //!--------------------------------------------------------------------
+    //! CLAIM
+    //! Interactive work done in the calling thread, e.g. the synchronous
+    //! load of the shown image; holds back the other tasks on the device of
+    //! path while it lives.
+    class Claim
+    {
+    public:
+        Claim( QIoScheduler *scheduler, const QString &path );
+        ~Claim();
+
+    private:
+        Q_DISABLE_COPY( Claim )
+
+        QIoScheduler *m_scheduler;
+        quint64 m_device;
+    };
+
+    QIoScheduler();
+    ~QIoScheduler(); // pending tasks are dropped, running ones waited for
+
+    static QIoScheduler *globalInstance();
+
+    //! [1] TASKS
+    // task reads path; returns an id for the calls below, never 0
+    quint64 submit( const QString &path, const Priority &priority, const Task &task );
+
+    // pending tasks only, false once started or done
+    bool setPriority( const quint64 &id, const Priority &priority );
+    bool cancel( const quint64 &id );
+
+    void wait( const quint64 &id );
+    void waitForDone();
+    //! [1]
+
+    //! [2] LIMITS
+    // tasks at a time on the device of path, Interactive ones not counted;
+    // 0 goes back to automatic: 1 for rotational disks, 2 for network file
+    // systems, maxConcurrency() otherwise
+    void setConcurrency( const QString &path, const int &concurrency );
+    int concurrency( const QString &path );
+
+    // all devices, the pool is one larger to keep a thread for the user
+    void setMaxConcurrency( const int &concurrency );
+    int maxConcurrency() const;
+    //! [2]
+
+private:
+    Q_DISABLE_COPY( QIoScheduler )
+
+    class Runner;
+
+    struct Job
+    {
+        quint64 id;
+        quint64 device;
+        Priority priority;
+        Task task;
+    };
+
+    static quint64 deviceOf( const QString &path );
+    static int automaticConcurrency( const QString &path );
+
+    // with m_mutex locked
+    void detect( const quint64 &device, const QString &path );
+    int concurrencyOf( const quint64 &device ) const;
+    void dispatch();
+    void start( const Job &job );
+
+    void finished( const Job &job );
+    void beginInteractive( const quint64 &device );
+    void endInteractive( const quint64 &device );
+
+    QMutex m_mutex;
+    QWaitCondition m_done;
+
+    QList < Job > m_pending[ PriorityCount ];
+    QSet < quint64 > m_active; // pending or running ids
+
+    QHash < quint64, int > m_running;     // device, tasks not Interactive
+    QHash < quint64, int > m_interactive; // device, Interactive tasks and claims
+    QHash < quint64, int > m_concurrency; // device, limit set
+    QHash < quint64, int > m_automatic;   // device, detected limit or 0
+    int m_backgroundCount;
+    int m_maxConcurrency;
+    quint64 m_nextId;
+
+    QThreadPool m_pool;
+};
+
+#endif // QIoScheduler_H
@@ -0,0 +1,337 @@
+#include "qjpegdecoder.h"
+#include "qmappedfile.h"
+
+#include <QFile>
+#include <QDebug>
+
+#ifdef QIMAGEWIDGET_HAVE_LIBJPEG
+#include <cstdio>   // jpeglib.h needs FILE
+#include <csetjmp>
+extern "C" {
+#include <jpeglib.h>
+}
+#endif
+
+namespace {
+
+#ifdef QIMAGEWIDGET_HAVE_LIBJPEG
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! LIBJPEG GLUE //!
+struct ErrorManager
+{
+    jpeg_error_mgr manager;
+    jmp_buf jump;
+};
+
+//---------------------------------------------------------------------------
+
+void errorExit( j_common_ptr info )
+{
+    char message[ JMSG_LENGTH_MAX ];
+    ( *info->err->format_message )( info, message );
+    qWarning() << Q_FUNC_INFO << message;
+
+    longjmp( reinterpret_cast < ErrorManager * > ( info->err )->jump, 1 );
+}
+
+//---------------------------------------------------------------------------
+
+void outputMessage( j_common_ptr )
+{
+    // corrupt data warnings, the preview is shown anyway
+}
+
+//---------------------------------------------------------------------------
+
+// RGB32 straight from libjpeg-turbo, RGB888 from plain libjpeg, false for
+// color spaces left to Qt
+bool setOutputColorSpace( jpeg_decompress_struct *info )
+{
+    switch ( info->jpeg_color_space ) {
+    case JCS_GRAYSCALE:
+        info->out_color_space = JCS_GRAYSCALE;
+        return true;
+    case JCS_YCbCr:
+    case JCS_RGB:
+#ifdef JCS_EXTENSIONS
+        info->out_color_space = Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? JCS_EXT_BGRX : JCS_EXT_XRGB;
+#else
+        info->out_color_space = JCS_RGB;
+#endif
+        return true;
+    default:
+        return false; // CMYK and YCCK need Adobe inversion
+    }
+}
+
+//---------------------------------------------------------------------------
+
+// after jpeg_start_decompress()
+QImage outputImage( jpeg_decompress_struct *info )
+{
+    QImage::Format format = QImage::Format_Grayscale8;
+    if ( info->out_color_space != JCS_GRAYSCALE ) {
+        format = info->out_color_components == 4 ? QImage::Format_RGB32 : QImage::Format_RGB888;
+    }
+
+    return QImage( int( info->output_width ), int( info->output_height ), format );
+}
+
+//---------------------------------------------------------------------------
+
+// up to count rows of the current output pass into image, returns the rows
+int readRows( jpeg_decompress_struct *info, QImage *image, const int &count )
+{
+    const int first = int( info->output_scanline );
+    while ( int( info->output_scanline ) < first + count && info->output_scanline < info->output_height ) {
+        JSAMPROW row = image->scanLine( int( info->output_scanline ) );
+        jpeg_read_scanlines( info, &row, 1 );
+    }
+
+    return int( info->output_scanline ) - first;
+}
+
+//---------------------------------------------------------------------------
+
+// no C++ objects with destructors live in this frame, longjmp skips them
+bool readJpeg( jpeg_decompress_struct *info, ErrorManager *error, const uchar *data, const qint64 &size,
+               const QSize &scaledSize, const Qt::AspectRatioMode &mode, QImage *image )
+{
+    if ( setjmp( error->jump ) ) {
+        return false;
+    }
+
+    jpeg_mem_src( info, const_cast < uchar * > ( data ), static_cast < unsigned long > ( size ) );
+    if ( jpeg_read_header( info, TRUE ) != JPEG_HEADER_OK || !setOutputColorSpace( info ) ) {
+        return false;
+    }
+
+    info->scale_num = 1;
+    info->scale_denom = QJpegDecoder::scaleDenominator( QSize( int( info->image_width ), int( info->image_height ) ),
+                                                        scaledSize, mode );
+    info->dct_method = JDCT_IFAST;  // previews, the error is below what scaling hides
+    info->do_fancy_upsampling = FALSE;
+
+    jpeg_start_decompress( info );
+
+    *image = outputImage( info );
+    if ( image->isNull() ) {
+        jpeg_abort_decompress( info );
+        return false;
+    }
+
+    readRows( info, image, int( info->output_height ) );
+
+    jpeg_finish_decompress( info );
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+// as readJpeg(), full size, reporting rows or whole progressive passes
+bool readJpegIncremental( jpeg_decompress_struct *info, ErrorManager *error, const uchar *data, const qint64 &size,
+                          QImage *image, const QJpegDecoder::Progress *progress )
+{
+    if ( setjmp( error->jump ) ) {
+        return false;
+    }
+
+    jpeg_mem_src( info, const_cast < uchar * > ( data ), static_cast < unsigned long > ( size ) );
+    if ( jpeg_read_header( info, TRUE ) != JPEG_HEADER_OK || !setOutputColorSpace( info ) ) {
+        return false;
+    }
+
+    info->buffered_image = jpeg_has_multiple_scans( info );
+    jpeg_start_decompress( info );
+
+    *image = outputImage( info );
+    if ( image->isNull() ) {
+        jpeg_abort_decompress( info );
+        return false;
+    }
+
+    const int width = int( info->output_width );
+    const int height = int( info->output_height );
+
+    if ( !info->buffered_image ) {
+        // sequential, rows arrive top to bottom
+        while ( info->output_scanline < info->output_height ) {
+            const int first = int( info->output_scanline );
+            const int rows = readRows( info, image, QJpegDecoder::RowBatch );
+            if ( !( *progress )( QRect( 0, first, width, rows ), 100 * ( first + rows ) / height ) ) {
+                jpeg_abort_decompress( info );
+                return false;
+            }
+        }
+
+        jpeg_finish_decompress( info );
+        return true;
+    }
+
+    // progressive, each output pass refines the whole image; passes after
+    // scans 1, 2, 4, 8... and the last keep the extra work logarithmic
+    int shownScan = 0;
+    forever {
+        const bool complete = jpeg_input_complete( info );
+        if ( complete || info->input_scan_number >= 2 * shownScan ) {
+            jpeg_start_output( info, info->input_scan_number );
+            shownScan = info->input_scan_number;
+
+            while ( info->output_scanline < info->output_height ) {
+                readRows( info, image, QJpegDecoder::RowBatch );
+
+                const int percent = int( 100 * ( info->src->next_input_byte - data ) / size );
+                if ( !( *progress )( QRect(), percent ) ) {
+                    jpeg_abort_decompress( info );
+                    return false;
+                }
+            }
+
+            jpeg_finish_output( info );
+
+            const int percent = complete ? 100 : int( 100 * ( info->src->next_input_byte - data ) / size );
+            if ( !( *progress )( image->rect(), percent ) ) {
+                jpeg_abort_decompress( info );
+                return false;
+            }
+        }
+
+        if ( complete ) {
+            break;
+        }
+
+        // the next scan, shown with a later pass
+        int status;
+        do {
+            status = jpeg_consume_input( info );
+        } while ( status != JPEG_REACHED_SOS && status != JPEG_REACHED_EOI && status != JPEG_SUSPENDED );
+    }
+
+    jpeg_finish_decompress( info );
+    return true;
+}
+#endif
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! JPEG DECODER //!
+bool QJpegDecoder::isAvailable()
+{
+#ifdef QIMAGEWIDGET_HAVE_LIBJPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+bool QJpegDecoder::isJpeg( const QString &path )
+{
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    const QByteArray magic = file.read( 3 );
+    return magic.size() == 3 && uchar( magic.at( 0 ) ) == 0xFF
+           && uchar( magic.at( 1 ) ) == 0xD8 && uchar( magic.at( 2 ) ) == 0xFF;
+}
+
+//---------------------------------------------------------------------------
+
+int QJpegDecoder::scaleDenominator( const QSize &imageSize, const QSize &scaledSize,
+                                    const Qt::AspectRatioMode &mode )
+{
+    if ( imageSize.isEmpty() || !scaledSize.isValid() ) {
+        return 1;
+    }
+
+    const QSize target = imageSize.scaled( scaledSize, mode );
+    for ( int denominator = 8; denominator > 1; denominator /= 2 ) {
+        // libjpeg rounds the scaled dimensions up
+        const int width = ( imageSize.width() + denominator - 1 ) / denominator;
+        const int height = ( imageSize.height() + denominator - 1 ) / denominator;
+        if ( width >= target.width() && height >= target.height() ) {
+            return denominator;
+        }
+    }
+
+    return 1;
+}
+
+//---------------------------------------------------------------------------
+
+bool QJpegDecoder::decode( const QString &path, const QSize &scaledSize,
+                           const Qt::AspectRatioMode &mode, QImage *image )
+{
+#ifdef QIMAGEWIDGET_HAVE_LIBJPEG
+    QMappedFile file( path );
+    if ( !file.isOpen() ) {
+        return false;
+    }
+
+    jpeg_decompress_struct info;
+    ErrorManager error;
+    info.err = jpeg_std_error( &error.manager );
+    error.manager.error_exit = errorExit;
+    error.manager.output_message = outputMessage;
+    jpeg_create_decompress( &info );
+
+    QImage decoded;
+    const bool ok = readJpeg( &info, &error, file.data(), file.size(), scaledSize, mode, &decoded );
+    jpeg_destroy_decompress( &info );
+
+    if ( !ok ) {
+        return false;
+    }
+
+    *image = decoded.format() == QImage::Format_RGB888 ? decoded.convertToFormat( QImage::Format_RGB32 )
+                                                       : decoded;
+    return true;
+#else
+    Q_UNUSED( path );
+    Q_UNUSED( scaledSize );
+    Q_UNUSED( mode );
+    Q_UNUSED( image );
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+bool QJpegDecoder::decodeIncremental( const QString &path, QImage *image, const Progress &progress )
+{
+#ifdef QIMAGEWIDGET_HAVE_LIBJPEG
+    QMappedFile file( path );
+    if ( !file.isOpen() ) {
+        return false;
+    }
+
+    jpeg_decompress_struct info;
+    ErrorManager error;
+    info.err = jpeg_std_error( &error.manager );
+    error.manager.error_exit = errorExit;
+    error.manager.output_message = outputMessage;
+    jpeg_create_decompress( &info );
+
+    const bool ok = readJpegIncremental( &info, &error, file.data(), file.size(), image, &progress );
+    jpeg_destroy_decompress( &info );
+
+    if ( ok && image->format() == QImage::Format_RGB888 ) {
+        *image = image->convertToFormat( QImage::Format_RGB32 );
+    }
+
+    return ok;
+#else
+    Q_UNUSED( path );
+    Q_UNUSED( image );
+    Q_UNUSED( progress );
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
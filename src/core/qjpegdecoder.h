@@ -0,0 +1,50 @@
+#ifndef QJpegDecoder_H
+#define QJpegDecoder_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QSize>
+
+#include <functional>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! JPEG DECODER
+//! Preview decodes straight from libjpeg at 1/2, 1/4 or 1/8 of the size.
+//! The inverse DCT then only produces the reduced image, which is most of
+//! the work saved for camera sized files. Incremental decodes report the
+//! rows or progressive passes as they are done. Without libjpeg at build
+//! time both always fail and callers take the generic path.
+class QJpegDecoder
+{
+public:
+    enum { RowBatch = 16 }; // rows between progress calls
+
+    // rect of image that changed, empty while a progressive pass is under
+    // way; return false to cancel
+    typedef std::function < bool ( const QRect &rect, const int &percent ) > Progress;
+
+    static bool isAvailable();
+    static bool isJpeg( const QString &path );
+
+    // largest of 1, 2, 4 and 8 that still gives at least the size of
+    // imageSize scaled to scaledSize with mode
+    static int scaleDenominator( const QSize &imageSize, const QSize &scaledSize,
+                                 const Qt::AspectRatioMode &mode );
+
+    // the result is close to the scaled size but never smaller, see
+    // scaleDenominator(); false for files libjpeg should not do here,
+    // e.g. CMYK, then image is untouched
+    static bool decode( const QString &path, const QSize &scaledSize,
+                        const Qt::AspectRatioMode &mode, QImage *image );
+
+    // full size, image fills in while progress is called, top to bottom or
+    // pass by pass for progressive files; false when failed or cancelled
+    static bool decodeIncremental( const QString &path, QImage *image, const Progress &progress );
+
+private:
+    QJpegDecoder() {}
+};
+
+#endif // QJpegDecoder_H
@@ -0,0 +1,68 @@
+#include "qmappedfile.h"
+
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! MAPPED FILE //!
+QMappedFile::QMappedFile( const QString &path )
+    : m_file( path ),
+      m_data( 0 ),
+      m_size( 0 ),
+      m_mapped( false )
+{
+    if ( !m_file.open( QIODevice::ReadOnly ) ) {
+        return;
+    }
+
+    m_size = m_file.size();
+    if ( m_size > std::numeric_limits < int >::max() ) {
+        return; // beyond what QByteArray and QImageReader take
+    }
+
+    if ( m_size >= MinimumMapSize ) {
+        m_data = m_file.map( 0, m_size );
+    }
+
+    if ( m_data ) {
+        m_mapped = true;
+#ifdef Q_OS_UNIX
+        // doubles the kernel readahead and drops pages behind the decoder sooner
+        madvise( const_cast < uchar * > ( m_data ), size_t( m_size ), MADV_SEQUENTIAL );
+#endif
+        m_bytes = QByteArray::fromRawData( reinterpret_cast < const char * > ( m_data ), int( m_size ) );
+    } else {
+        // small, or a file system without mmap
+        m_bytes = m_file.readAll();
+        m_size = m_bytes.size();
+        m_file.close();
+        if ( !m_bytes.isEmpty() ) {
+            m_data = reinterpret_cast < const uchar * > ( m_bytes.constData() );
+        }
+    }
+
+    m_buffer.setBuffer( &m_bytes );
+    m_buffer.open( QIODevice::ReadOnly );
+}
+
+//---------------------------------------------------------------------------
+
+void QMappedFile::readAhead( const QString &path )
+{
+#if defined( Q_OS_LINUX )
+    QFile file( path );
+    if ( file.open( QIODevice::ReadOnly ) ) {
+        // returns at once, the reads are queued; closing keeps them going
+        posix_fadvise( file.handle(), 0, 0, POSIX_FADV_WILLNEED );
+    }
+#else
+    Q_UNUSED( path );
+#endif
+}
+
+//---------------------------------------------------------------------------
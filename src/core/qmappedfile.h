@@ -0,0 +1,52 @@
+#ifndef QMappedFile_H
+#define QMappedFile_H
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! MAPPED FILE
+//! Read only view of a whole file for the decoders. Files from
+//! MinimumMapSize up are memory mapped and hinted as read sequentially, the
+//! decoder then reads the page cache directly instead of a heap copy of
+//! the file; smaller ones are read, a mapping costs more than it saves
+//! there. A file truncated while mapped faults on access, which is the
+//! usual price of mapping files others may write.
+class QMappedFile
+{
+public:
+    enum { MinimumMapSize = 64 * 1024 };
+
+    explicit QMappedFile( const QString &path );
+
+    bool isOpen() const { return m_data != 0; }
+    bool isMapped() const { return m_mapped; }
+
+    // valid while this lives, 0 when the file could not be read
+    const uchar *data() const { return m_data; }
+    qint64 size() const { return m_size; }
+
+    // open, read only device on data() for QImageReader, no copy
+    QIODevice *device() { return &m_buffer; }
+
+    // asks the kernel to read path into the page cache in the background,
+    // so a later decode does not wait for the disk; a no-op where not
+    // supported
+    static void readAhead( const QString &path );
+
+private:
+    Q_DISABLE_COPY( QMappedFile )
+
+    QFile m_file;
+    QByteArray m_bytes; // raw wrapper of the mapping, or the bytes read
+    QBuffer m_buffer;
+
+    const uchar *m_data;
+    qint64 m_size;
+    bool m_mapped;
+};
+
+#endif // QMappedFile_H
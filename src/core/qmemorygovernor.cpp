@@ -0,0 +1,308 @@
+#include "qmemorygovernor.h"
+#include "qimagewidgetlogging.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+#include <QTimer>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! CLIENT //!
+QMemoryGovernor::Client::~Client()
+{
+    m_governorMutex.lock();
+    QMemoryGovernor *governor = m_governor;
+    m_governorMutex.unlock();
+
+    if ( governor ) {
+        governor->removeClient( this );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+bool QMemoryGovernor::Client::candidate( Candidate * ) const
+{
+    return false;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QMemoryGovernor::Client::evict()
+{
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+
+void QMemoryGovernor::Client::grown() const
+{
+    // the governor cannot let go of this client while the lock is held
+    QMutexLocker locker( &m_governorMutex );
+    QMemoryGovernor *governor = m_governor;
+    if ( !governor ) {
+        return;
+    }
+
+    // on its own thread it cannot go away meanwhile; trimming evicts from
+    // the clients, not under this lock
+    if ( QThread::currentThread() == governor->thread() ) {
+        locker.unlock();
+        governor->trim();
+        return;
+    }
+
+    governor->scheduleTrim();
+}
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! MEMORY GOVERNOR //!
+QMemoryGovernor::QMemoryGovernor( QObject *parent )
+    : QObject( parent ),
+      m_budget( 0 ),
+      m_pressureThreshold( DefaultPressureThreshold )
+{
+    m_pollTimer = new QTimer( this );
+    m_pollTimer->setInterval( PollInterval );
+    connect( m_pollTimer, &QTimer::timeout, this, &QMemoryGovernor::poll );
+}
+
+//---------------------------------------------------------------------------
+
+QMemoryGovernor::~QMemoryGovernor()
+{
+    foreach ( const Entry &entry, m_clients ) {
+        setGovernor( entry.second, 0 );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+void QMemoryGovernor::addClient( const QString &name, Client *client )
+{
+    removeClient( client );
+
+    setGovernor( client, this );
+    m_clients.append( Entry( name, client ) );
+
+    updatePolling();
+    trim();
+}
+
+//---------------------------------------------------------------------------
+
+void QMemoryGovernor::removeClient( Client *client )
+{
+    for ( int i = 0; i < m_clients.size(); ++i ) {
+        if ( m_clients.at( i ).second == client ) {
+            m_clients.removeAt( i );
+            setGovernor( client, 0 );
+            break;
+        }
+    }
+
+    updatePolling();
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+//! [2]
+void QMemoryGovernor::setBudget( const qint64 &bytes )
+{
+    m_budget = qMax < qint64 > ( 0, bytes );
+    trim();
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QMemoryGovernor::bytes() const
+{
+    qint64 bytes = 0;
+    foreach ( const Entry &entry, m_clients ) {
+        bytes += entry.second->bytes();
+    }
+
+    return bytes;
+}
+
+//---------------------------------------------------------------------------
+
+QMap < QString, qint64 > QMemoryGovernor::usage() const
+{
+    QMap < QString, qint64 > usage;
+    foreach ( const Entry &entry, m_clients ) {
+        usage[ entry.first ] += entry.second->bytes();
+    }
+
+    return usage;
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+//! [3]
+void QMemoryGovernor::setPressureThreshold( const qint64 &bytes )
+{
+    m_pressureThreshold = qMax < qint64 > ( 0, bytes );
+    updatePolling();
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QMemoryGovernor::availableMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile file( "/proc/meminfo" );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return -1;
+    }
+
+    // "MemAvailable:    1234567 kB", since Linux 3.14
+    forever {
+        const QByteArray line = file.readLine();
+        if ( line.isEmpty() ) {
+            break;
+        }
+
+        if ( line.startsWith( "MemAvailable:" ) ) {
+            const QList < QByteArray > fields = line.simplified().split( ' ' );
+            return fields.size() >= 2 ? fields.at( 1 ).toLongLong() * 1024 : -1;
+        }
+    }
+#endif
+
+    return -1;
+}
+//! [3]
+
+//---------------------------------------------------------------------------
+
+qint64 QMemoryGovernor::now()
+{
+    static const QElapsedTimer clock = [] () {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    } ();
+
+    return clock.elapsed();
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QMemoryGovernor::estimatedCost( const qint64 &bytes )
+{
+    return bytes / ( 256 * 1024 ); // about 1 ms per 64K pixels
+}
+
+//---------------------------------------------------------------------------
+
+void QMemoryGovernor::trim()
+{
+    m_trimScheduled.store( 0 );
+
+    if ( m_budget > 0 ) {
+        trimTo( m_budget );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QMemoryGovernor::poll()
+{
+    const qint64 available = availableMemory();
+    if ( available < 0 || available >= m_pressureThreshold ) {
+        return;
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Memory pressure, available bytes:", available );
+
+    trimTo( qMax < qint64 > ( 0, bytes() - ( m_pressureThreshold - available ) ) );
+    emit memoryPressure( available );
+}
+
+//---------------------------------------------------------------------------
+
+void QMemoryGovernor::scheduleTrim()
+{
+    // clients grow on worker threads, they are only asked on this one
+    if ( m_trimScheduled.testAndSetOrdered( 0, 1 ) ) {
+        QMetaObject::invokeMethod( this, "trim", Qt::QueuedConnection );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QMemoryGovernor::setGovernor( Client *client, QMemoryGovernor *governor )
+{
+    // waits for a grown() running on another thread
+    QMutexLocker locker( &client->m_governorMutex );
+    client->m_governor = governor;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QMemoryGovernor::trimTo( const qint64 &target )
+{
+    qint64 total = bytes();
+    qint64 freed = 0;
+
+    while ( total > target ) {
+        const qint64 time = now();
+
+        // least worth keeping: cost to get it back per ms it went unused
+        Client *victim = 0;
+        double lowest = 0;
+        foreach ( const Entry &entry, m_clients ) {
+            Candidate candidate;
+            if ( !entry.second->candidate( &candidate ) ) {
+                continue;
+            }
+
+            const double worth = double( candidate.cost + 1 ) / double( qMax < qint64 > ( 0, time - candidate.lastUsed ) + 1 );
+            if ( !victim || worth < lowest ) {
+                victim = entry.second;
+                lowest = worth;
+            }
+        }
+
+        if ( !victim ) {
+            break; // only what cannot be evicted is left
+        }
+
+        const qint64 evicted = victim->evict();
+        if ( evicted <= 0 ) {
+            break;
+        }
+
+        total -= evicted;
+        freed += evicted;
+    }
+
+    if ( freed > 0 ) {
+        QIW_TRACE_VALUE( lcImageWidgetPixmap, "Memory governor evicted bytes:", freed );
+    }
+
+    return freed;
+}
+
+//---------------------------------------------------------------------------
+
+void QMemoryGovernor::updatePolling()
+{
+    static const bool supported = availableMemory() >= 0;
+
+    if ( supported && m_pressureThreshold > 0 && !m_clients.isEmpty() ) {
+        if ( !m_pollTimer->isActive() ) {
+            m_pollTimer->start();
+        }
+    } else {
+        m_pollTimer->stop();
+    }
+}
+
+//---------------------------------------------------------------------------
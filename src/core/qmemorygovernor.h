@@ -0,0 +1,128 @@
+#ifndef QMemoryGovernor_H
+#define QMemoryGovernor_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+
+class QTimer;
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! MEMORY GOVERNOR
+//! One byte budget over the caches registered as clients. Beyond it the
+//! governor asks the clients for their next eviction candidate and drops
+//! the one least worth keeping: long unused and cheap to get back goes
+//! first, so an old prefetched image yields before the decode the
+//! comparison panes just did. Polls the available system memory and gives
+//! back what falls short of the pressure threshold. Clients are asked on
+//! the governor's thread.
+class QMemoryGovernor : public QObject
+{
+    Q_OBJECT
+
+signals:
+    // available system memory was below pressureThreshold(), the caches
+    // were trimmed by the difference
+    void memoryPressure( const qint64 &available );
+
+public:
+    enum { PollInterval = 2000 }; // ms
+    enum { DefaultPressureThreshold = 256 * 1024 * 1024 };
+
+    struct Candidate
+    {
+        qint64 lastUsed; // now() of the last access
+        qint64 cost;     // ms to get it back, e.g. the decode time
+    };
+
+    //!--------------------------------------------------------------------
+    //! CLIENT
+    //! A cache under the budget. Clients without candidates are only
+    //! counted, e.g. the undo history.
+    class Client
+    {
+    public:
+        Client() : m_governor( 0 ) {}
+        virtual ~Client();
+
+        virtual qint64 bytes() const = 0;
+
+        // the entry evict() would drop, false if there is none
+        virtual bool candidate( Candidate *candidate ) const;
+        // drops that entry, returns the bytes freed
+        virtual qint64 evict();
+
+    protected:
+        // after growing, from any thread
+        void grown() const;
+
+    private:
+        Q_DISABLE_COPY( Client )
+        friend class QMemoryGovernor;
+
+        // set and cleared on the governor's thread, read by grown() on any
+        mutable QMutex m_governorMutex;
+        QMemoryGovernor *m_governor;
+    };
+
+    explicit QMemoryGovernor( QObject *parent = 0 );
+    ~QMemoryGovernor();
+
+    //! [1] CLIENTS
+    // name is for usage(); client is not owned
+    void addClient( const QString &name, Client *client );
+    void removeClient( Client *client );
+    //! [1]
+
+    //! [2] BUDGET
+    // 0 for none, the default
+    void setBudget( const qint64 &bytes );
+    qint64 budget() const { return m_budget; }
+
+    qint64 bytes() const;
+    QMap < QString, qint64 > usage() const; // client name, bytes
+    //! [2]
+
+    //! [3] PRESSURE
+    // 0 stops polling
+    void setPressureThreshold( const qint64 &bytes );
+    qint64 pressureThreshold() const { return m_pressureThreshold; }
+
+    // MemAvailable of /proc/meminfo, -1 where unknown
+    static qint64 availableMemory();
+    //! [3]
+
+    // ms since an arbitrary start, monotonic, for Candidate::lastUsed
+    static qint64 now();
+    // ms a decode producing this many bytes takes, roughly, for entries
+    // whose decode was not timed
+    static qint64 estimatedCost( const qint64 &bytes );
+
+public slots:
+    // to the budget
+    void trim();
+
+private slots:
+    void poll();
+
+private:
+    typedef QPair < QString, Client * > Entry;
+
+    void scheduleTrim(); // queued, from any thread
+    static void setGovernor( Client *client, QMemoryGovernor *governor );
+    qint64 trimTo( const qint64 &target ); // returns the bytes freed
+    void updatePolling();
+
+    QList < Entry > m_clients;
+    qint64 m_budget;
+    qint64 m_pressureThreshold;
+    QTimer *m_pollTimer;
+    QAtomicInt m_trimScheduled;
+};
+
+#endif // QMemoryGovernor_H
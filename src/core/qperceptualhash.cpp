@@ -0,0 +1,468 @@
+#include "qperceptualhash.h"
+
+#include <QFileInfo>
+#include <QDir>
+#include <QImageReader>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QPair>
+#include <QtConcurrent>
+#include <QDebug>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+const quint32 CacheMagic = 0x51504831; // "QPH1"
+const quint32 CacheVersion = 2;
+
+// entries are marked used at most this often, not rewritten by every update
+const qint64 UseResolution = Q_INT64_C( 86400000 ); // ms
+
+// decoded size, the hash itself only needs 9 x 8
+const int HashDecodeSize = 64;
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! BK-TREE //!
+class BkTree
+{
+public:
+    struct Node {
+        quint64 hash;
+        QVector < int > items;                  // positions with this exact hash
+        QVector < QPair < int, int > > children; // ( distance, node )
+    };
+
+    void insert( const quint64 &hash, const int &item ) {
+        if ( m_nodes.isEmpty() ) {
+            appendNode( hash, item );
+            return;
+        }
+
+        int node = 0;
+        forever {
+            const int d = QPerceptualHashIndex::distance( m_nodes.at( node ).hash, hash );
+            if ( d == 0 ) {
+                m_nodes[ node ].items.append( item );
+                return;
+            }
+
+            int next = -1;
+            foreach ( const QPair < int, int > &child, m_nodes.at( node ).children ) {
+                if ( child.first == d ) {
+                    next = child.second;
+                    break;
+                }
+            }
+
+            if ( next < 0 ) {
+                const int created = appendNode( hash, item );
+                m_nodes[ node ].children.append( qMakePair( d, created ) );
+                return;
+            }
+
+            node = next;
+        }
+    }
+
+    // nodes within radius of hash, triangle inequality prunes the subtrees
+    QVector < int > query( const quint64 &hash, const int &radius ) const {
+        QVector < int > result;
+        if ( m_nodes.isEmpty() ) {
+            return result;
+        }
+
+        QVector < int > stack;
+        stack.append( 0 );
+        while ( !stack.isEmpty() ) {
+            const int index = stack.takeLast();
+            const Node &node = m_nodes.at( index );
+            const int d = QPerceptualHashIndex::distance( node.hash, hash );
+            if ( d <= radius ) {
+                result.append( index );
+            }
+
+            foreach ( const QPair < int, int > &child, node.children ) {
+                if ( child.first >= d - radius && child.first <= d + radius ) {
+                    stack.append( child.second );
+                }
+            }
+        }
+
+        return result;
+    }
+
+    const QVector < Node > &nodes() const { return m_nodes; }
+
+private:
+    int appendNode( const quint64 &hash, const int &item ) {
+        Node node;
+        node.hash = hash;
+        node.items.append( item );
+        m_nodes.append( node );
+        return m_nodes.size() - 1;
+    }
+
+    QVector < Node > m_nodes;
+};
+
+//---------------------------------------------------------------------------
+
+int findRoot( QVector < int > &parents, int node )
+{
+    while ( parents.at( node ) != node ) {
+        parents[ node ] = parents.at( parents.at( node ) );
+        node = parents.at( node );
+    }
+    return node;
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! PERCEPTUAL HASH INDEX //!
+QPerceptualHashIndex::QPerceptualHashIndex()
+    : m_cacheFilePath( defaultCacheFilePath() ),
+      m_dirty( false ),
+      m_bytes( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QPerceptualHashIndex::QPerceptualHashIndex( const QString &cacheFilePath )
+    : m_cacheFilePath( cacheFilePath ),
+      m_dirty( false ),
+      m_bytes( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+quint64 QPerceptualHashIndex::hash( const QImage &image )
+{
+    const QImage small = image.scaled( 9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation )
+                              .convertToFormat( QImage::Format_Grayscale8 );
+
+    // one bit per horizontal gradient
+    quint64 result = 0;
+    for ( int y = 0; y < 8; ++y ) {
+        const uchar *line = small.constScanLine( y );
+        for ( int x = 0; x < 8; ++x ) {
+            result = result << 1 | ( line[ x ] < line[ x + 1 ] ? 1 : 0 );
+        }
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+quint64 QPerceptualHashIndex::hashFile( const QString &path, bool *ok )
+{
+    // scaled decode, JPEG is downscaled in the DCT domain
+    QImageReader reader( path );
+    reader.setScaledSize( QSize( HashDecodeSize, HashDecodeSize ) );
+
+    const QImage image = reader.read();
+    if ( ok ) {
+        *ok = !image.isNull();
+    }
+
+    return image.isNull() ? 0 : hash( image );
+}
+
+//---------------------------------------------------------------------------
+
+int QPerceptualHashIndex::distance( const quint64 &left, const quint64 &right )
+{
+    return qPopulationCount( left ^ right );
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+//! [2]
+void QPerceptualHashIndex::update( const QStringList &paths )
+{
+    struct Work {
+        QString path;
+        Entry entry;
+        bool changed;
+    };
+
+    QVector < Work > work;
+    work.reserve( paths.size() );
+    {
+        QMutexLocker locker( &m_mutex );
+        foreach ( const QString &path, paths ) {
+            Work item;
+            item.path = path;
+            item.entry = m_entries.value( path );
+            item.changed = false;
+            work.append( item );
+        }
+    }
+
+    QtConcurrent::blockingMap( work, [] ( Work &item ) {
+        const QFileInfo info( item.path );
+        const qint64 lastModified = info.lastModified().toMSecsSinceEpoch();
+        if ( item.entry.fileSize == info.size() && item.entry.lastModified == lastModified ) {
+            return;
+        }
+
+        bool ok = false;
+        item.entry.hash = hashFile( item.path, &ok );
+        item.entry.fileSize = ok ? info.size() : -1;
+        item.entry.lastModified = lastModified;
+        item.changed = ok;
+    } );
+
+    const qint64 used = QDateTime::currentMSecsSinceEpoch();
+    QMutexLocker locker( &m_mutex );
+    bool added = false;
+    foreach ( const Work &item, work ) {
+        if ( item.changed ) {
+            added = added || !m_entries.contains( item.path );
+            Entry entry = item.entry;
+            entry.lastUsed = used;
+            m_entries.insert( item.path, entry );
+            m_dirty = true;
+        } else if ( item.entry.fileSize >= 0 && used - item.entry.lastUsed > UseResolution ) {
+            QHash < QString, Entry >::iterator it = m_entries.find( item.path );
+            if ( it != m_entries.end() ) {
+                it.value().lastUsed = used;
+                m_dirty = true;
+            }
+        }
+    }
+
+    if ( added ) {
+        m_bytes = -1;
+        locker.unlock();
+        grown();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+QList < QStringList > QPerceptualHashIndex::groups( const QStringList &paths,
+                                                    const int &maxDistance ) const
+{
+    QStringList hashedPaths;
+    BkTree tree;
+    {
+        QMutexLocker locker( &m_mutex );
+        foreach ( const QString &path, paths ) {
+            QHash < QString, Entry >::const_iterator it = m_entries.constFind( path );
+            if ( it != m_entries.constEnd() && it.value().fileSize >= 0 ) {
+                tree.insert( it.value().hash, hashedPaths.size() );
+                hashedPaths.append( path );
+            }
+        }
+    }
+
+    const QVector < BkTree::Node > &nodes = tree.nodes();
+
+    // queries are read only, run them in parallel, one slot per node
+    QVector < QVector < int > > neighbours( nodes.size() );
+    QVector < int > queries( nodes.size() );
+    std::iota( queries.begin(), queries.end(), 0 );
+
+    QVector < int > *results = neighbours.data();
+    QtConcurrent::blockingMap( queries, [ & ] ( const int &node ) {
+        results[ node ] = tree.query( nodes.at( node ).hash, maxDistance );
+    } );
+
+    QVector < int > parents( nodes.size() );
+    std::iota( parents.begin(), parents.end(), 0 );
+    for ( int node = 0; node < nodes.size(); ++node ) {
+        foreach ( const int &other, neighbours.at( node ) ) {
+            parents[ findRoot( parents, node ) ] = findRoot( parents, other );
+        }
+    }
+
+    QHash < int, QStringList > byRoot;
+    for ( int node = 0; node < nodes.size(); ++node ) {
+        QStringList &group = byRoot[ findRoot( parents, node ) ];
+        foreach ( const int &item, nodes.at( node ).items ) {
+            group.append( hashedPaths.at( item ) );
+        }
+    }
+
+    QList < QStringList > result;
+    foreach ( QStringList group, byRoot ) {
+        if ( group.size() > 1 ) {
+            group.sort();
+            result.append( group );
+        }
+    }
+
+    std::sort( result.begin(), result.end(), [] ( const QStringList &a, const QStringList &b ) {
+        return a.first() < b.first();
+    } );
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+
+qint64 QPerceptualHashIndex::bytes() const
+{
+    QMutexLocker locker( &m_mutex );
+    if ( m_bytes < 0 ) {
+        // the paths, their QString headers and the entries, roughly
+        m_bytes = 0;
+        for ( QHash < QString, Entry >::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it ) {
+            m_bytes += qint64( it.key().size() ) * qint64( sizeof( QChar ) ) + 24 + qint64( sizeof( Entry ) );
+        }
+    }
+
+    return m_bytes;
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+//! [3]
+QString QPerceptualHashIndex::defaultCacheFilePath()
+{
+    return QStandardPaths::writableLocation( QStandardPaths::CacheLocation )
+            + "/thumbnails/perceptual-hashes.cache";
+}
+
+//---------------------------------------------------------------------------
+
+bool QPerceptualHashIndex::load()
+{
+    QFile file( m_cacheFilePath );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    QDataStream stream( &file );
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    stream >> magic >> version >> count;
+    if ( magic != CacheMagic || version != CacheVersion || count < 0 ) {
+        qWarning() << Q_FUNC_INFO << "Wrong perceptual hash cache" << m_cacheFilePath;
+        return false;
+    }
+
+    QHash < QString, Entry > entries;
+    entries.reserve( count );
+    for ( qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i ) {
+        QString path;
+        Entry entry;
+        stream >> path >> entry.fileSize >> entry.lastModified >> entry.lastUsed >> entry.hash;
+        entries.insert( path, entry );
+    }
+
+    if ( stream.status() != QDataStream::Ok ) {
+        return false;
+    }
+
+    QMutexLocker locker( &m_mutex );
+    for ( QHash < QString, Entry >::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it ) {
+        if ( !m_entries.contains( it.key() ) ) {
+            m_entries.insert( it.key(), it.value() );
+        }
+    }
+    m_bytes = -1;
+    locker.unlock();
+
+    grown();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+bool QPerceptualHashIndex::save() const
+{
+    // written from a snapshot, updates go on meanwhile and mark the index
+    // dirty again
+    QMutexLocker saveLocker( &m_saveMutex );
+    QMutexLocker locker( &m_mutex );
+    if ( !m_dirty ) {
+        return true;
+    }
+    const QHash < QString, Entry > entries = m_entries;
+    m_dirty = false;
+    locker.unlock();
+
+    QDir().mkpath( QFileInfo( m_cacheFilePath ).absolutePath() );
+
+    QSaveFile file( m_cacheFilePath );
+    bool written = file.open( QIODevice::WriteOnly );
+    if ( written ) {
+        QDataStream stream( &file );
+        stream << CacheMagic << CacheVersion << qint32( entries.size() );
+        for ( QHash < QString, Entry >::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it ) {
+            stream << it.key() << it.value().fileSize << it.value().lastModified << it.value().lastUsed
+                   << it.value().hash;
+        }
+        written = file.commit();
+    }
+
+    if ( !written ) {
+        qWarning() << Q_FUNC_INFO << "Cannot write" << m_cacheFilePath;
+        locker.relock();
+        m_dirty = true;
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+int QPerceptualHashIndex::prune( const int &maxAgeDays )
+{
+    const qint64 oldest = QDateTime::currentMSecsSinceEpoch() - qint64( maxAgeDays ) * UseResolution;
+
+    QStringList paths;
+    {
+        QMutexLocker locker( &m_mutex );
+        paths = m_entries.keys();
+    }
+
+    // stat'ed without the lock, updates go on meanwhile
+    const QStringList gone = QtConcurrent::blockingFiltered( paths, [] ( const QString &path ) {
+        return !QFileInfo::exists( path );
+    } );
+
+    QMutexLocker locker( &m_mutex );
+    int count = 0;
+    foreach ( const QString &path, gone ) {
+        count += m_entries.remove( path );
+    }
+
+    QHash < QString, Entry >::iterator it = m_entries.begin();
+    while ( it != m_entries.end() ) {
+        if ( it.value().lastUsed < oldest ) {
+            it = m_entries.erase( it );
+            ++count;
+        } else {
+            ++it;
+        }
+    }
+
+    if ( count > 0 ) {
+        m_dirty = true;
+        m_bytes = -1;
+    }
+
+    return count;
+}
+//! [3]
+
+//---------------------------------------------------------------------------
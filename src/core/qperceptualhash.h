@@ -0,0 +1,81 @@
+#ifndef QPerceptualHash_H
+#define QPerceptualHash_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QImage>
+
+#include "qmemorygovernor.h"
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! PERCEPTUAL HASH INDEX
+//! 64 bit difference hashes (dHash) of a small thumbnail decode, kept per
+//! path and validated by file size and modification time. Hashes are
+//! computed in parallel and persisted to a cache file, grouping uses a
+//! BK-tree so only hashes within the distance are compared. Loading and
+//! saving may run off the user interface thread beside updates; files gone
+//! or not hashed again for long are pruned. Counted by a QMemoryGovernor,
+//! never evicted.
+class QPerceptualHashIndex : public QMemoryGovernor::Client
+{
+public:
+    QPerceptualHashIndex();
+    explicit QPerceptualHashIndex( const QString &cacheFilePath );
+
+    //! [1] HASHES
+    static quint64 hash( const QImage &image );
+    static quint64 hashFile( const QString &path, bool *ok = 0 );
+
+    static int distance( const quint64 &left, const quint64 &right );
+    //! [1]
+
+    //! [2] INDEX
+    // hashes new and changed files in parallel, blocking
+    void update( const QStringList &paths );
+
+    // groups of near-duplicates among paths, at least two per group
+    QList < QStringList > groups( const QStringList &paths, const int &maxDistance ) const;
+
+    qint64 bytes() const override;
+    //! [2]
+
+    //! [3] PERSISTENCE
+    static QString defaultCacheFilePath();
+
+    bool load();
+    bool save() const;
+
+    // drops files gone and those not asked for in maxAgeDays, a stat each;
+    // the count dropped
+    int prune( const int &maxAgeDays = MaxAgeDays );
+    //! [3]
+
+    enum { MaxAgeDays = 90 };
+
+private:
+    struct Entry {
+        Entry()
+            : fileSize( -1 ), lastModified( 0 ), lastUsed( 0 ), hash( 0 ) {}
+
+        qint64 fileSize;
+        qint64 lastModified; // ms since epoch
+        qint64 lastUsed;     // ms since epoch of an update with it, by the day
+        quint64 hash;
+    };
+
+    QString m_cacheFilePath;
+
+    mutable QMutex m_mutex;
+    // held through a save, snapshots are written in the order taken
+    mutable QMutex m_saveMutex;
+    QHash < QString, Entry > m_entries;
+    mutable bool m_dirty; // entries changed since load() or save()
+    mutable qint64 m_bytes; // of m_entries, -1 until counted again
+};
+
+#endif // QPerceptualHash_H
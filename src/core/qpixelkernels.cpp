@@ -0,0 +1,211 @@
+#include "qpixelkernels.h"
+#include "qpixelkernels_p.h"
+#include "qimagewidgetlogging.h"
+
+#if defined( QPIXELKERNELS_X86 ) && defined( _MSC_VER )
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+bool isBuiltIn( const QPixelKernels::Path &path )
+{
+    switch ( path ) {
+    case QPixelKernels::Scalar:
+        return true;
+    case QPixelKernels::Sse2:
+#ifdef QPIXELKERNELS_X86
+        return true;
+#else
+        return false;
+#endif
+    case QPixelKernels::Avx2:
+#ifdef QIMAGEWIDGET_HAVE_AVX2
+        return true;
+#else
+        return false;
+#endif
+    case QPixelKernels::Avx512:
+#ifdef QIMAGEWIDGET_HAVE_AVX512
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+
+bool cpuSupports( const QPixelKernels::Path &path )
+{
+    if ( path == QPixelKernels::Scalar ) {
+        return true;
+    }
+
+#if defined( QPIXELKERNELS_X86 ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+    // also checks that the OS saves the wide registers
+    __builtin_cpu_init();
+    switch ( path ) {
+    case QPixelKernels::Sse2:
+        return __builtin_cpu_supports( "sse2" );
+    case QPixelKernels::Avx2:
+        return __builtin_cpu_supports( "avx2" );
+    case QPixelKernels::Avx512:
+        return __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" );
+    default:
+        return false;
+    }
+#elif defined( QPIXELKERNELS_X86 ) && defined( _MSC_VER )
+    int info[ 4 ];
+    __cpuid( info, 0 );
+    const int leaves = info[ 0 ];
+
+    __cpuid( info, 1 );
+    const bool sse2 = info[ 3 ] & ( 1 << 26 );
+    const bool osxsave = info[ 2 ] & ( 1 << 27 );
+    const bool avx = info[ 2 ] & ( 1 << 28 );
+
+    const unsigned long long xcr0 = osxsave ? _xgetbv( 0 ) : 0;
+    const bool ymm = ( xcr0 & 0x06 ) == 0x06;
+    const bool zmm = ( xcr0 & 0xe6 ) == 0xe6;
+
+    int features = 0;
+    if ( leaves >= 7 ) {
+        __cpuidex( info, 7, 0 );
+        features = info[ 1 ];
+    }
+
+    switch ( path ) {
+    case QPixelKernels::Sse2:
+        return sse2;
+    case QPixelKernels::Avx2:
+        return avx && ymm && ( features & ( 1 << 5 ) );
+    case QPixelKernels::Avx512:
+        return zmm && ( features & ( 1 << 16 ) ) && ( features & ( 1 << 30 ) ); // F, BW
+    default:
+        return false;
+    }
+#else
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+QPixelKernels::Table selectTable()
+{
+    // the environment can only lower the choice, never force an unsupported path
+    QPixelKernels::Path limit = QPixelKernels::Avx512;
+    const QByteArray requested = qgetenv( "QIMAGEWIDGET_KERNELS" ).toLower();
+    for ( int path = QPixelKernels::Scalar; path <= QPixelKernels::Avx512; ++path ) {
+        if ( requested == QPixelKernels::pathName( QPixelKernels::Path( path ) ).toLatin1() ) {
+            limit = QPixelKernels::Path( path );
+        }
+    }
+
+    QPixelKernels::Path best = QPixelKernels::Scalar;
+    for ( int path = QPixelKernels::Scalar; path <= limit; ++path ) {
+        if ( QPixelKernels::isSupported( QPixelKernels::Path( path ) ) ) {
+            best = QPixelKernels::Path( path );
+        }
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetKernels, "Pixel kernel path:", best );
+
+    return QPixelKernels::tableFor( best );
+}
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! PIXEL KERNELS //!
+const QPixelKernels::Table &QPixelKernels::table()
+{
+    static const Table active = selectTable();
+    return active;
+}
+
+//---------------------------------------------------------------------------
+
+QPixelKernels::Table QPixelKernels::tableFor( const Path &path )
+{
+    Table table;
+    table.path = Scalar;
+    table.absDiff = QPixelKernelsScalar::absDiff;
+    // a histogram is a scatter: SSE2 and AVX2 have no scatter, AVX-512
+    // would need conflict detection within a vector, slower than the copies
+    table.histogram = QPixelKernelsScalar::histogram;
+    table.rotateTile32 = QPixelKernelsScalar::rotateTile32;
+    table.reverse32 = QPixelKernelsScalar::reverse32;
+    // 3 byte pixels need a byte shuffle to move in registers, SSE2 has none
+    // (pshufb is SSSE3); plain copies within a cache sized tile it is
+    table.rotateTile24 = QPixelKernelsScalar::rotateTile24;
+    table.reverse24 = QPixelKernelsScalar::reverse24;
+
+    if ( !isBuiltIn( path ) ) {
+        return table;
+    }
+
+    table.path = path;
+
+#ifdef QPIXELKERNELS_X86
+    // wider paths gain nothing on 4 x 4 transposes, they keep the SSE2 ones
+    if ( path != Scalar ) {
+        table.rotateTile32 = QPixelKernelsSse2::rotateTile32;
+        table.reverse32 = QPixelKernelsSse2::reverse32;
+    }
+#endif
+
+    switch ( path ) {
+    case Scalar:
+        break;
+    case Sse2:
+#ifdef QPIXELKERNELS_X86
+        table.absDiff = QPixelKernelsSse2::absDiff;
+#endif
+        break;
+    case Avx2:
+#ifdef QIMAGEWIDGET_HAVE_AVX2
+        table.absDiff = QPixelKernelsAvx2::absDiff;
+#endif
+        break;
+    case Avx512:
+#ifdef QIMAGEWIDGET_HAVE_AVX512
+        table.absDiff = QPixelKernelsAvx512::absDiff;
+#endif
+        break;
+    }
+
+    return table;
+}
+
+//---------------------------------------------------------------------------
+
+bool QPixelKernels::isSupported( const Path &path )
+{
+    return isBuiltIn( path ) && cpuSupports( path );
+}
+
+//---------------------------------------------------------------------------
+
+QString QPixelKernels::pathName( const Path &path )
+{
+    switch ( path ) {
+    case Scalar:
+        return "scalar";
+    case Sse2:
+        return "sse2";
+    case Avx2:
+        return "avx2";
+    case Avx512:
+        return "avx512";
+    }
+
+    return QString();
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,89 @@
+#ifndef QPixelKernels_H
+#define QPixelKernels_H
+
+#include <QtGlobal>
+#include <QRgb>
+#include <QString>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! PIXEL KERNELS
+//! Inner loops over rows of 32 bit pixels. Every kernel has a scalar
+//! reference and optional SSE2, AVX2 and AVX-512 versions built in their
+//! own translation units; the best one the CPU supports is picked once on
+//! first use. QIMAGEWIDGET_KERNELS=scalar|sse2|avx2|avx512 in the
+//! environment caps the choice.
+class QPixelKernels
+{
+public:
+    enum Path { Scalar, Sse2, Avx2, Avx512 };
+
+    enum { HistogramCopies = 4, HistogramSize = 4 * 256 };
+
+    typedef void ( *AbsDiffFunction )( const QRgb *a, const QRgb *b, QRgb *out, int count );
+    typedef void ( *HistogramFunction )( const QRgb *pixels, int count, quint32 *histograms );
+    typedef void ( *RotateTileFunction )( const uchar *src, int srcStride, uchar *dst, int dstStride,
+                                          int width, int height, bool clockwise );
+    typedef void ( *ReverseFunction )( const uchar *src, uchar *dst, int count );
+
+    struct Table {
+        Path path;
+        AbsDiffFunction absDiff;
+        HistogramFunction histogram;
+        RotateTileFunction rotateTile32;
+        RotateTileFunction rotateTile24;
+        ReverseFunction reverse32;
+        ReverseFunction reverse24;
+    };
+
+    //! [1] KERNELS
+    // per channel |a - b|, alpha of the result is opaque
+    static void absDiff( const QRgb *a, const QRgb *b, QRgb *out, const int &count ) {
+        table().absDiff( a, b, out, count );
+    }
+
+    // adds red, green, blue and alpha levels of the pixels to four interleaved
+    // copies of a 4 x 256 histogram ( 4096 counters ), consecutive pixels go
+    // to different copies so increments do not wait on each other; scalar
+    // on every path, see tableFor()
+    static void histogram( const QRgb *pixels, const int &count, quint32 *histograms ) {
+        table().histogram( pixels, count, histograms );
+    }
+
+    // rotates a width x height tile of 32 or 24 bit pixels by 90 degrees;
+    // src and dst point to the top left of the tile and of its rotated place;
+    // the 24 bit ones, and reverse24(), are scalar on every path
+    static void rotateTile32( const uchar *src, const int &srcStride, uchar *dst, const int &dstStride,
+                              const int &width, const int &height, const bool &clockwise ) {
+        table().rotateTile32( src, srcStride, dst, dstStride, width, height, clockwise );
+    }
+
+    static void rotateTile24( const uchar *src, const int &srcStride, uchar *dst, const int &dstStride,
+                              const int &width, const int &height, const bool &clockwise ) {
+        table().rotateTile24( src, srcStride, dst, dstStride, width, height, clockwise );
+    }
+
+    // dst[ count - 1 - i ] = src[ i ], in pixels
+    static void reverse32( const uchar *src, uchar *dst, const int &count ) {
+        table().reverse32( src, dst, count );
+    }
+
+    static void reverse24( const uchar *src, uchar *dst, const int &count ) {
+        table().reverse24( src, dst, count );
+    }
+    //! [1]
+
+    //! [2] DISPATCH
+    static const Table &table();            // active kernels
+    static Table tableFor( const Path &path ); // scalar where the path has no kernel
+
+    static bool isSupported( const Path &path ); // built in and supported by the CPU
+    static Path activePath() { return table().path; }
+    static QString pathName( const Path &path );
+    //! [2]
+
+private:
+    QPixelKernels() {}
+};
+
+#endif // QPixelKernels_H
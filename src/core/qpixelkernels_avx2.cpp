@@ -0,0 +1,29 @@
+#include "qpixelkernels_p.h"
+
+#ifdef QIMAGEWIDGET_HAVE_AVX2
+
+#include <immintrin.h>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! AVX2 KERNELS //!
+//! Built with -mavx2, only called after the CPU check.
+void QPixelKernelsAvx2::absDiff( const QRgb *a, const QRgb *b, QRgb *out, int count )
+{
+    const __m256i alpha = _mm256_set1_epi32( int( 0xff000000 ) );
+
+    int i = 0;
+    for ( ; i + 8 <= count; i += 8 ) {
+        const __m256i left = _mm256_loadu_si256( reinterpret_cast < const __m256i * > ( a + i ) );
+        const __m256i right = _mm256_loadu_si256( reinterpret_cast < const __m256i * > ( b + i ) );
+        const __m256i diff = _mm256_or_si256( _mm256_subs_epu8( left, right ),
+                                              _mm256_subs_epu8( right, left ) );
+        _mm256_storeu_si256( reinterpret_cast < __m256i * > ( out + i ), _mm256_or_si256( diff, alpha ) );
+    }
+
+    QPixelKernelsScalar::absDiff( a + i, b + i, out + i, count - i );
+}
+
+//---------------------------------------------------------------------------
+
+#endif // QIMAGEWIDGET_HAVE_AVX2
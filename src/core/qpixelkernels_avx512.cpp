@@ -0,0 +1,37 @@
+#include "qpixelkernels_p.h"
+
+#ifdef QIMAGEWIDGET_HAVE_AVX512
+
+#include <immintrin.h>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! AVX-512 KERNELS //!
+//! Built with -mavx512f -mavx512bw, only called after the CPU check.
+void QPixelKernelsAvx512::absDiff( const QRgb *a, const QRgb *b, QRgb *out, int count )
+{
+    const __m512i alpha = _mm512_set1_epi32( int( 0xff000000 ) );
+
+    int i = 0;
+    for ( ; i + 16 <= count; i += 16 ) {
+        const __m512i left = _mm512_loadu_si512( a + i );
+        const __m512i right = _mm512_loadu_si512( b + i );
+        const __m512i diff = _mm512_or_si512( _mm512_subs_epu8( left, right ),
+                                              _mm512_subs_epu8( right, left ) );
+        _mm512_storeu_si512( out + i, _mm512_or_si512( diff, alpha ) );
+    }
+
+    // the tail in one masked step
+    if ( i < count ) {
+        const __mmask16 mask = __mmask16( ( 1u << ( count - i ) ) - 1 );
+        const __m512i left = _mm512_maskz_loadu_epi32( mask, a + i );
+        const __m512i right = _mm512_maskz_loadu_epi32( mask, b + i );
+        const __m512i diff = _mm512_or_si512( _mm512_subs_epu8( left, right ),
+                                              _mm512_subs_epu8( right, left ) );
+        _mm512_mask_storeu_epi32( out + i, mask, _mm512_or_si512( diff, alpha ) );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+#endif // QIMAGEWIDGET_HAVE_AVX512
@@ -0,0 +1,44 @@
+#ifndef QPixelKernels_P_H
+#define QPixelKernels_P_H
+
+//! Internal: the kernels of every instruction set. Only the translation
+//! unit of an instruction set is built with its compiler flags, the
+//! dispatcher calls into it after checking the CPU.
+
+#include <QtGlobal>
+#include <QRgb>
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#define QPIXELKERNELS_X86
+#endif
+
+namespace QPixelKernelsScalar {
+void absDiff( const QRgb *a, const QRgb *b, QRgb *out, int count );
+void histogram( const QRgb *pixels, int count, quint32 *histograms );
+void rotateTile32( const uchar *src, int srcStride, uchar *dst, int dstStride, int width, int height, bool clockwise );
+void rotateTile24( const uchar *src, int srcStride, uchar *dst, int dstStride, int width, int height, bool clockwise );
+void reverse32( const uchar *src, uchar *dst, int count );
+void reverse24( const uchar *src, uchar *dst, int count );
+}
+
+#ifdef QPIXELKERNELS_X86
+namespace QPixelKernelsSse2 {
+void absDiff( const QRgb *a, const QRgb *b, QRgb *out, int count );
+void rotateTile32( const uchar *src, int srcStride, uchar *dst, int dstStride, int width, int height, bool clockwise );
+void reverse32( const uchar *src, uchar *dst, int count );
+}
+#endif
+
+#ifdef QIMAGEWIDGET_HAVE_AVX2
+namespace QPixelKernelsAvx2 {
+void absDiff( const QRgb *a, const QRgb *b, QRgb *out, int count );
+}
+#endif
+
+#ifdef QIMAGEWIDGET_HAVE_AVX512
+namespace QPixelKernelsAvx512 {
+void absDiff( const QRgb *a, const QRgb *b, QRgb *out, int count );
+}
+#endif
+
+#endif // QPixelKernels_P_H
@@ -0,0 +1,103 @@
+#include "qpixelkernels_p.h"
+#include "qpixelkernels.h"
+
+#include <cstring>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! SCALAR KERNELS //!
+//! Reference for the vector versions, they must match bit for bit.
+void QPixelKernelsScalar::absDiff( const QRgb *a, const QRgb *b, QRgb *out, int count )
+{
+    for ( int i = 0; i < count; ++i ) {
+        out[ i ] = qRgb( qAbs( qRed( a[ i ] ) - qRed( b[ i ] ) ),
+                         qAbs( qGreen( a[ i ] ) - qGreen( b[ i ] ) ),
+                         qAbs( qBlue( a[ i ] ) - qBlue( b[ i ] ) ) );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QPixelKernelsScalar::histogram( const QRgb *pixels, int count, quint32 *histograms )
+{
+    quint32 *copy0 = histograms;
+    quint32 *copy1 = histograms + QPixelKernels::HistogramSize;
+    quint32 *copy2 = histograms + 2 * QPixelKernels::HistogramSize;
+    quint32 *copy3 = histograms + 3 * QPixelKernels::HistogramSize;
+
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        const QRgb p0 = pixels[ i ];
+        const QRgb p1 = pixels[ i + 1 ];
+        const QRgb p2 = pixels[ i + 2 ];
+        const QRgb p3 = pixels[ i + 3 ];
+
+        copy0[ qRed( p0 ) ]++; copy0[ 256 + qGreen( p0 ) ]++; copy0[ 512 + qBlue( p0 ) ]++; copy0[ 768 + qAlpha( p0 ) ]++;
+        copy1[ qRed( p1 ) ]++; copy1[ 256 + qGreen( p1 ) ]++; copy1[ 512 + qBlue( p1 ) ]++; copy1[ 768 + qAlpha( p1 ) ]++;
+        copy2[ qRed( p2 ) ]++; copy2[ 256 + qGreen( p2 ) ]++; copy2[ 512 + qBlue( p2 ) ]++; copy2[ 768 + qAlpha( p2 ) ]++;
+        copy3[ qRed( p3 ) ]++; copy3[ 256 + qGreen( p3 ) ]++; copy3[ 512 + qBlue( p3 ) ]++; copy3[ 768 + qAlpha( p3 ) ]++;
+    }
+
+    for ( ; i < count; ++i ) {
+        const QRgb p = pixels[ i ];
+        copy0[ qRed( p ) ]++; copy0[ 256 + qGreen( p ) ]++; copy0[ 512 + qBlue( p ) ]++; copy0[ 768 + qAlpha( p ) ]++;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QPixelKernelsScalar::rotateTile32( const uchar *src, int srcStride, uchar *dst, int dstStride,
+                                        int width, int height, bool clockwise )
+{
+    for ( int y = 0; y < height; ++y ) {
+        const quint32 *line = reinterpret_cast < const quint32 * > ( src + y * srcStride );
+        if ( clockwise ) { // column y from the right
+            for ( int x = 0; x < width; ++x ) {
+                reinterpret_cast < quint32 * > ( dst + x * dstStride )[ height - 1 - y ] = line[ x ];
+            }
+        } else {            // row x from the bottom
+            for ( int x = 0; x < width; ++x ) {
+                reinterpret_cast < quint32 * > ( dst + ( width - 1 - x ) * dstStride )[ y ] = line[ x ];
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QPixelKernelsScalar::rotateTile24( const uchar *src, int srcStride, uchar *dst, int dstStride,
+                                        int width, int height, bool clockwise )
+{
+    for ( int y = 0; y < height; ++y ) {
+        const uchar *line = src + y * srcStride;
+        for ( int x = 0; x < width; ++x ) {
+            uchar *target = clockwise ? dst + x * dstStride + ( height - 1 - y ) * 3
+                                      : dst + ( width - 1 - x ) * dstStride + y * 3;
+            target[ 0 ] = line[ x * 3 ];
+            target[ 1 ] = line[ x * 3 + 1 ];
+            target[ 2 ] = line[ x * 3 + 2 ];
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QPixelKernelsScalar::reverse32( const uchar *src, uchar *dst, int count )
+{
+    const quint32 *from = reinterpret_cast < const quint32 * > ( src );
+    quint32 *to = reinterpret_cast < quint32 * > ( dst );
+    for ( int i = 0; i < count; ++i ) {
+        to[ count - 1 - i ] = from[ i ];
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QPixelKernelsScalar::reverse24( const uchar *src, uchar *dst, int count )
+{
+    for ( int i = 0; i < count; ++i ) {
+        std::memcpy( dst + ( count - 1 - i ) * 3, src + i * 3, 3 );
+    }
+}
+
+//---------------------------------------------------------------------------
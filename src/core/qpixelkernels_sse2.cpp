@@ -0,0 +1,97 @@
+#include "qpixelkernels_p.h"
+
+#ifdef QPIXELKERNELS_X86
+
+#include <emmintrin.h>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! SSE2 KERNELS //!
+void QPixelKernelsSse2::absDiff( const QRgb *a, const QRgb *b, QRgb *out, int count )
+{
+    // saturating subtraction both ways, one of them is zero
+    const __m128i alpha = _mm_set1_epi32( int( 0xff000000 ) );
+
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        const __m128i left = _mm_loadu_si128( reinterpret_cast < const __m128i * > ( a + i ) );
+        const __m128i right = _mm_loadu_si128( reinterpret_cast < const __m128i * > ( b + i ) );
+        const __m128i diff = _mm_or_si128( _mm_subs_epu8( left, right ),
+                                           _mm_subs_epu8( right, left ) );
+        _mm_storeu_si128( reinterpret_cast < __m128i * > ( out + i ), _mm_or_si128( diff, alpha ) );
+    }
+
+    QPixelKernelsScalar::absDiff( a + i, b + i, out + i, count - i );
+}
+
+//---------------------------------------------------------------------------
+
+void QPixelKernelsSse2::rotateTile32( const uchar *src, int srcStride, uchar *dst, int dstStride,
+                                      int width, int height, bool clockwise )
+{
+    const int width4 = width & ~3;
+    const int height4 = height & ~3;
+
+    // 4 x 4 blocks transposed in registers
+    for ( int y = 0; y < height4; y += 4 ) {
+        for ( int x = 0; x < width4; x += 4 ) {
+            const uchar *block = src + y * srcStride + x * 4;
+            const __m128i r0 = _mm_loadu_si128( reinterpret_cast < const __m128i * > ( block ) );
+            const __m128i r1 = _mm_loadu_si128( reinterpret_cast < const __m128i * > ( block + srcStride ) );
+            const __m128i r2 = _mm_loadu_si128( reinterpret_cast < const __m128i * > ( block + 2 * srcStride ) );
+            const __m128i r3 = _mm_loadu_si128( reinterpret_cast < const __m128i * > ( block + 3 * srcStride ) );
+
+            const __m128i t0 = _mm_unpacklo_epi32( r0, r1 );
+            const __m128i t1 = _mm_unpacklo_epi32( r2, r3 );
+            const __m128i t2 = _mm_unpackhi_epi32( r0, r1 );
+            const __m128i t3 = _mm_unpackhi_epi32( r2, r3 );
+
+            __m128i columns[ 4 ];   // column k: rows y .. y + 3
+            columns[ 0 ] = _mm_unpacklo_epi64( t0, t1 );
+            columns[ 1 ] = _mm_unpackhi_epi64( t0, t1 );
+            columns[ 2 ] = _mm_unpacklo_epi64( t2, t3 );
+            columns[ 3 ] = _mm_unpackhi_epi64( t2, t3 );
+
+            for ( int k = 0; k < 4; ++k ) {
+                if ( clockwise ) {
+                    uchar *target = dst + ( x + k ) * dstStride + ( height - 4 - y ) * 4;
+                    _mm_storeu_si128( reinterpret_cast < __m128i * > ( target ),
+                                      _mm_shuffle_epi32( columns[ k ], _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+                } else {
+                    uchar *target = dst + ( width - 1 - x - k ) * dstStride + y * 4;
+                    _mm_storeu_si128( reinterpret_cast < __m128i * > ( target ), columns[ k ] );
+                }
+            }
+        }
+    }
+
+    // right and bottom edges
+    if ( width4 < width ) {
+        const int offset = clockwise ? width4 * dstStride + ( height - height4 ) * 4 : 0;
+        QPixelKernelsScalar::rotateTile32( src + width4 * 4, srcStride, dst + offset, dstStride,
+                                           width - width4, height4, clockwise );
+    }
+    if ( height4 < height ) {
+        const int offset = clockwise ? 0 : height4 * 4;
+        QPixelKernelsScalar::rotateTile32( src + height4 * srcStride, srcStride, dst + offset, dstStride,
+                                           width, height - height4, clockwise );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QPixelKernelsSse2::reverse32( const uchar *src, uchar *dst, int count )
+{
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        const __m128i pixels = _mm_loadu_si128( reinterpret_cast < const __m128i * > ( src + i * 4 ) );
+        _mm_storeu_si128( reinterpret_cast < __m128i * > ( dst + ( count - 4 - i ) * 4 ),
+                          _mm_shuffle_epi32( pixels, _MM_SHUFFLE( 0, 1, 2, 3 ) ) );
+    }
+
+    QPixelKernelsScalar::reverse32( src + i * 4, dst, count - i );
+}
+
+//---------------------------------------------------------------------------
+
+#endif // QPIXELKERNELS_X86
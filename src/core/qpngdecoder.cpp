@@ -0,0 +1,179 @@
+#include "qpngdecoder.h"
+#include "qmappedfile.h"
+
+#include <QFile>
+#include <QDebug>
+
+#ifdef QIMAGEWIDGET_HAVE_LIBPNG
+#include <cstring>
+#include <png.h>
+#endif
+
+namespace {
+
+#ifdef QIMAGEWIDGET_HAVE_LIBPNG
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! LIBPNG GLUE //!
+struct Source
+{
+    const uchar *data;
+    qint64 size;
+    qint64 position;
+};
+
+//---------------------------------------------------------------------------
+
+void readData( png_structp png, png_bytep data, png_size_t length )
+{
+    // straight from the mapped file, no read calls and no heap copy of it
+    Source *source = static_cast < Source * > ( png_get_io_ptr( png ) );
+    if ( qint64( length ) > source->size - source->position ) {
+        png_error( png, "Truncated file" );
+    }
+
+    memcpy( data, source->data + source->position, length );
+    source->position += qint64( length );
+}
+
+//---------------------------------------------------------------------------
+
+void errorExit( png_structp png, png_const_charp message )
+{
+    qWarning() << Q_FUNC_INFO << message;
+    png_longjmp( png, 1 );
+}
+
+//---------------------------------------------------------------------------
+
+void warning( png_structp, png_const_charp )
+{
+    // bad ancillary chunks, the image is shown anyway
+}
+
+//---------------------------------------------------------------------------
+
+// no C++ objects with destructors live in this frame, longjmp skips them
+bool readPng( png_structp png, png_infop info, QImage *image, const QPngDecoder::Progress *progress )
+{
+    if ( setjmp( png_jmpbuf( png ) ) ) {
+        return false;
+    }
+
+    png_read_info( png, info );
+
+    const int width = int( png_get_image_width( png, info ) );
+    const int height = int( png_get_image_height( png, info ) );
+    const int colorType = png_get_color_type( png, info );
+    const bool alpha = ( colorType & PNG_COLOR_MASK_ALPHA ) || png_get_valid( png, info, PNG_INFO_tRNS );
+
+    // everything to 8 bit B, G, R, A in memory, which is QImage::Format_ARGB32
+    png_set_expand( png );
+    png_set_strip_16( png );
+    png_set_gray_to_rgb( png );
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    png_set_bgr( png );
+    png_set_filler( png, 0xff, PNG_FILLER_AFTER );
+#else
+    png_set_swap_alpha( png );
+    png_set_filler( png, 0xff, PNG_FILLER_BEFORE );
+#endif
+
+    const int passes = png_set_interlace_handling( png );
+    png_read_update_info( png, info );
+
+    *image = QImage( width, height, alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32 );
+    if ( image->isNull() ) {
+        return false;
+    }
+
+    for ( int pass = 0; pass < passes; ++pass ) {
+        for ( int y = 0; y < height; y += QPngDecoder::RowBatch ) {
+            const int rows = qMin( int( QPngDecoder::RowBatch ), height - y );
+            for ( int row = y; row < y + rows; ++row ) {
+                // interlaced passes fill in as rectangles, not sparkles
+                if ( passes > 1 ) {
+                    png_read_row( png, 0, image->scanLine( row ) );
+                } else {
+                    png_read_row( png, image->scanLine( row ), 0 );
+                }
+            }
+
+            const int percent = int( 100 * ( qint64( pass ) * height + y + rows ) / ( qint64( passes ) * height ) );
+            if ( !( *progress )( QRect( 0, y, width, rows ), percent ) ) {
+                return false;
+            }
+        }
+    }
+
+    png_read_end( png, 0 );
+    return true;
+}
+#endif
+
+} // namespace
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! PNG DECODER //!
+bool QPngDecoder::isAvailable()
+{
+#ifdef QIMAGEWIDGET_HAVE_LIBPNG
+    return true;
+#else
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
+
+bool QPngDecoder::isPng( const QString &path )
+{
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    return file.read( 8 ) == QByteArray( "\x89PNG\r\n\x1a\n", 8 );
+}
+
+//---------------------------------------------------------------------------
+
+bool QPngDecoder::decodeIncremental( const QString &path, QImage *image, const Progress &progress )
+{
+#ifdef QIMAGEWIDGET_HAVE_LIBPNG
+    QMappedFile file( path );
+    if ( !file.isOpen() ) {
+        return false;
+    }
+
+    Source source;
+    source.data = file.data();
+    source.size = file.size();
+    source.position = 0;
+
+    png_structp png = png_create_read_struct( PNG_LIBPNG_VER_STRING, 0, errorExit, warning );
+    if ( !png ) {
+        return false;
+    }
+
+    png_infop info = png_create_info_struct( png );
+    if ( !info ) {
+        png_destroy_read_struct( &png, 0, 0 );
+        return false;
+    }
+
+    png_set_read_fn( png, &source, readData );
+    const bool ok = readPng( png, info, image, &progress );
+    png_destroy_read_struct( &png, &info, 0 );
+
+    return ok;
+#else
+    Q_UNUSED( path );
+    Q_UNUSED( image );
+    Q_UNUSED( progress );
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,35 @@
+#ifndef QPngDecoder_H
+#define QPngDecoder_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+
+#include <functional>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! PNG DECODER
+//! Row by row PNG decodes with libpng, for files large enough that the
+//! view should fill in while they are read. Interlaced files show each
+//! Adam7 pass as blocks that sharpen. Without libpng at build time
+//! decodeIncremental() always fails and callers take the generic path.
+class QPngDecoder
+{
+public:
+    enum { RowBatch = 16 }; // rows between progress calls
+
+    // rect of image that changed; return false to cancel
+    typedef std::function < bool ( const QRect &rect, const int &percent ) > Progress;
+
+    static bool isAvailable();
+    static bool isPng( const QString &path );
+
+    // ARGB32, or RGB32 without transparency; false when failed or cancelled
+    static bool decodeIncremental( const QString &path, QImage *image, const Progress &progress );
+
+private:
+    QPngDecoder() {}
+};
+
+#endif // QPngDecoder_H
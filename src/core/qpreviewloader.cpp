@@ -0,0 +1,121 @@
+#include "qpreviewloader.h"
+#include "qimagewidgetlogging.h"
+#include "qioscheduler.h"
+#include "qthumbnailer.h"
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! PREVIEW LOADER //!
+QPreviewLoader::QPreviewLoader( QObject *parent )
+    : QObject( parent ),
+      m_scheduler( QIoScheduler::globalInstance() ),
+      m_generation( 0 ),
+      m_remaining( 0 ),
+      m_firstVisible( 0 ),
+      m_lastVisible( -1 ),
+      m_orphansRunning( 0 )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QPreviewLoader::~QPreviewLoader()
+{
+    // a running task still posts to this, wait for it
+    foreach ( const quint64 &task, m_tasks + m_orphans ) {
+        if ( task && !m_scheduler->cancel( task ) ) {
+            m_scheduler->wait( task );
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QPreviewLoader::start( const QStringList &paths, const QSize &size,
+                            const int &firstVisible, const int &lastVisible )
+{
+    cancel();
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Previews:", paths.size() );
+
+    m_firstVisible = firstVisible;
+    m_lastVisible = lastVisible;
+    m_remaining = paths.size();
+
+    QPreviewLoader *loader = this;
+    const int generation = m_generation;
+    for ( int row = 0; row < paths.size(); ++row ) {
+        const QString path = paths.at( row );
+        const QIoScheduler::Priority priority = isVisible( row ) ? QIoScheduler::VisibleThumbnail
+                                                                 : QIoScheduler::OffscreenThumbnail;
+        m_tasks.append( m_scheduler->submit( path, priority, [ loader, generation, row, path, size ] () {
+            // QPixmap is GUI thread only, the receiver converts
+            const QImage preview = QThumbnailer::thumbnail( path, size );
+            QMetaObject::invokeMethod( loader, "taskFinished", Qt::QueuedConnection,
+                                       Q_ARG( int, generation ), Q_ARG( int, row ),
+                                       Q_ARG( QString, path ), Q_ARG( QImage, preview ) );
+        } ) );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QPreviewLoader::cancel()
+{
+    // running tasks cannot be stopped, what they post is dropped
+    foreach ( const quint64 &task, m_tasks ) {
+        if ( task && !m_scheduler->cancel( task ) ) {
+            m_orphans.append( task );
+            ++m_orphansRunning;
+        }
+    }
+
+    ++m_generation;
+    m_tasks.clear();
+    m_remaining = 0;
+}
+
+//---------------------------------------------------------------------------
+
+void QPreviewLoader::setVisibleRows( const int &first, const int &last )
+{
+    // only the rows scrolled in or out change, not the whole list
+    for ( int row = qMax( 0, m_firstVisible ); row <= m_lastVisible && row < m_tasks.size(); ++row ) {
+        if ( m_tasks.at( row ) && ( row < first || row > last ) ) {
+            m_scheduler->setPriority( m_tasks.at( row ), QIoScheduler::OffscreenThumbnail );
+        }
+    }
+
+    for ( int row = qMax( 0, first ); row <= last && row < m_tasks.size(); ++row ) {
+        if ( m_tasks.at( row ) && !isVisible( row ) ) {
+            m_scheduler->setPriority( m_tasks.at( row ), QIoScheduler::VisibleThumbnail );
+        }
+    }
+
+    m_firstVisible = first;
+    m_lastVisible = last;
+}
+
+//---------------------------------------------------------------------------
+
+void QPreviewLoader::taskFinished( const int &generation, const int &row, const QString &path, const QImage &preview )
+{
+    if ( generation != m_generation ) {
+        if ( --m_orphansRunning == 0 ) {
+            m_orphans.clear();
+        }
+        return;
+    }
+
+    m_tasks[ row ] = 0;
+    --m_remaining;
+
+    emit previewReady( row, path, preview );
+
+    if ( m_remaining == 0 ) {
+        emit finished();
+    }
+}
+
+//---------------------------------------------------------------------------
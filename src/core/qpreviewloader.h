@@ -0,0 +1,60 @@
+#ifndef QPreviewLoader_H
+#define QPreviewLoader_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QStringList>
+
+class QIoScheduler;
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! PREVIEW LOADER
+//! Thumbnails of a list of files, one task of the global QIoScheduler
+//! each: the rows in view as VisibleThumbnail, the others as
+//! OffscreenThumbnail after prefetching and batches. setVisibleRows() moves
+//! the pending ones as the list scrolls. Previews come in any order, each
+//! with its row.
+class QPreviewLoader : public QObject
+{
+    Q_OBJECT
+
+signals:
+    // also when the thumbnail failed, preview is null then
+    void previewReady( const int &row, const QString &path, const QImage &preview );
+    void finished();
+
+public:
+    explicit QPreviewLoader( QObject *parent = 0 );
+    ~QPreviewLoader(); // pending tasks are dropped, running ones waited for
+
+    // previews the last start() has not delivered are dropped
+    void start( const QStringList &paths, const QSize &size, const int &firstVisible, const int &lastVisible );
+    void cancel();
+
+    void setVisibleRows( const int &first, const int &last );
+
+    bool isRunning() const { return m_remaining > 0; }
+
+private slots:
+    void taskFinished( const int &generation, const int &row, const QString &path, const QImage &preview );
+
+private:
+    bool isVisible( const int &row ) const { return row >= m_firstVisible && row <= m_lastVisible; }
+
+    QIoScheduler *m_scheduler;
+
+    int m_generation; // of start(), results of earlier ones are dropped
+    QList < quint64 > m_tasks; // per row, 0 once delivered
+    int m_remaining;
+    int m_firstVisible;
+    int m_lastVisible;
+
+    // cancelled while running, still post to this
+    QList < quint64 > m_orphans;
+    int m_orphansRunning;
+};
+
+#endif // QPreviewLoader_H
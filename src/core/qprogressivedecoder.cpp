@@ -0,0 +1,120 @@
+#include "qprogressivedecoder.h"
+#include "qimagedecoder.h"
+#include "qimageorientation.h"
+#include "qimagewidgetlogging.h"
+#include "qioscheduler.h"
+#include "qjpegdecoder.h"
+#include "qpngdecoder.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! PROGRESSIVE DECODER //!
+QProgressiveDecoder::QProgressiveDecoder( QObject *parent )
+    : QThread( parent )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+QProgressiveDecoder::~QProgressiveDecoder()
+{
+    cancel();
+}
+
+//---------------------------------------------------------------------------
+
+bool QProgressiveDecoder::isSupported( const QString &path )
+{
+    return ( QJpegDecoder::isAvailable() && QJpegDecoder::isJpeg( path ) )
+           || ( QPngDecoder::isAvailable() && QPngDecoder::isPng( path ) );
+}
+
+//---------------------------------------------------------------------------
+
+bool QProgressiveDecoder::isWorthwhile( const QString &path )
+{
+    return QFileInfo( path ).size() >= MinimumFileSize && isSupported( path );
+}
+
+//---------------------------------------------------------------------------
+
+void QProgressiveDecoder::decode( const QString &path )
+{
+    cancel();
+
+    m_path = path;
+    start();
+}
+
+//---------------------------------------------------------------------------
+
+void QProgressiveDecoder::cancel()
+{
+    if ( isRunning() ) {
+        QIW_TRACE( lcImageWidgetPixmap, "Progressive decode cancelled." );
+        requestInterruption();
+        wait();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QProgressiveDecoder::run()
+{
+    const QString path = m_path;
+
+    // the user looks at this one, background reads of its disk wait
+    const QIoScheduler::Claim claim( QIoScheduler::globalInstance(), path );
+    const int orientation = QImageOrientation::read( path );
+
+    QImage image;
+    QRect dirty;
+    QElapsedTimer timer;
+    bool announced = false;
+
+    // called on this thread between batches of rows, image is being filled
+    const QJpegDecoder::Progress report = [ & ] ( const QRect &rect, const int &percent ) {
+        if ( isInterruptionRequested() ) {
+            return false;
+        }
+
+        if ( !announced ) {
+            emit decodingStarted( path, image.size(), orientation );
+            announced = true;
+            timer.start();
+        }
+
+        dirty |= rect;
+        if ( !dirty.isEmpty() && timer.elapsed() >= UpdateInterval ) {
+            emit partDecoded( path, image.copy( dirty ), dirty );
+            emit progress( path, percent );
+            dirty = QRect();
+            timer.restart();
+        }
+
+        return true;
+    };
+
+    QIW_TRACE( lcImageWidgetPixmap, "Progressive decode started." );
+
+    const bool ok = QJpegDecoder::isJpeg( path ) ? QJpegDecoder::decodeIncremental( path, &image, report )
+                                                 : QPngDecoder::decodeIncremental( path, &image, report );
+    if ( isInterruptionRequested() ) {
+        return;
+    }
+
+    if ( !ok ) {
+        image = QImageDecoder::decode( path ); // declined by the library, e.g. CMYK
+    } else if ( orientation != QImageOrientation::Normal ) {
+        QImageOrientation::setOf( &image, orientation );
+    }
+
+    emit progress( path, 100 );
+    emit decoded( path, image );
+}
+
+//---------------------------------------------------------------------------
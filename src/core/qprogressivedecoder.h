@@ -0,0 +1,58 @@
+#ifndef QProgressiveDecoder_H
+#define QProgressiveDecoder_H
+
+#include <QThread>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! PROGRESSIVE DECODER
+//! Decodes one large PNG or JPEG on its own thread and hands out the parts
+//! done so far, at most every UpdateInterval ms, so a view can fill in
+//! instead of waiting for the whole file. Parts are copies, the image being
+//! decoded is never shared with the GUI thread. Signals carry the path, a
+//! receiver drops those of a decode it has since cancelled.
+class QProgressiveDecoder : public QThread
+{
+    Q_OBJECT
+
+signals:
+    // size of the stored pixels, orientation to show them in
+    void decodingStarted( const QString &path, const QSize &size, const int &orientation );
+    // rect of the image that part replaces; a progressive JPEG pass is
+    // the whole image
+    void partDecoded( const QString &path, const QImage &part, const QRect &rect );
+    void progress( const QString &path, const int &percent );
+    // null on failure, never after cancel()
+    void decoded( const QString &path, const QImage &image );
+
+public:
+    enum {
+        UpdateInterval = 100,               // ms
+        MinimumFileSize = 4 * 1024 * 1024   // smaller files decode in one go
+    };
+
+    explicit QProgressiveDecoder( QObject *parent = 0 );
+    ~QProgressiveDecoder();
+
+    static bool isSupported( const QString &path );
+    static bool isWorthwhile( const QString &path ); // supported and large
+
+    // cancels the running decode first
+    void decode( const QString &path );
+    // returns once the thread stopped, within one batch of rows
+    void cancel();
+
+    QString path() const { return m_path; }
+
+protected:
+    void run();
+
+private:
+    QString m_path;
+};
+
+#endif // QProgressiveDecoder_H
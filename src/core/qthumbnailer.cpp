@@ -0,0 +1,212 @@
+#include "qthumbnailer.h"
+#include "qimagedecoder.h"
+#include "qexifreader.h"
+#include "qimageorientation.h"
+#include "qioscheduler.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QSet>
+#include <QDebug>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! THUMBNAILER //!
+QImage QThumbnailer::thumbnail( const QString &path, const QSize &size, const Qt::AspectRatioMode &mode )
+{
+    // size is for the image as shown, decoding works on the stored pixels
+    const int orientation = QImageOrientation::read( path );
+    const QSize storedSize = QImageOrientation::orientedSize( size, orientation );
+
+    // cameras embed a small JPEG, no need to touch the main image at all
+    QImage image = exifThumbnail( path, storedSize, mode );
+    if ( image.isNull() ) {
+        // the reader decodes close to size, scaling the rest is cheap
+        image = QImageDecoder::decode( path, storedSize, mode );
+        if ( image.isNull() ) {
+            return image;
+        }
+    }
+
+    // turning the thumbnail upright costs nothing at this size
+    return QImageOrientation::applied( image.scaled( storedSize, mode, Qt::SmoothTransformation ), orientation );
+}
+
+//---------------------------------------------------------------------------
+
+QImage QThumbnailer::exifThumbnail( const QString &path, const QSize &size, const Qt::AspectRatioMode &mode )
+{
+    const QByteArray data = QExifReader::thumbnail( path ); // empty for anything not JPEG
+    if ( data.isEmpty() ) {
+        return QImage();
+    }
+
+    const QImage image = QImage::fromData( data, "JPEG" );
+    if ( image.isNull() || image.size().scaled( size, mode ).width() > image.width() ) {
+        return QImage(); // would be upscaled
+    }
+
+    // some cameras letterbox the thumbnail to 4:3, the bars would show
+    const QSize imageSize = QImageReader( path ).size();
+    const qreal ratio = qreal( image.width() ) / image.height();
+    const qreal imageRatio = imageSize.isEmpty() ? ratio : qreal( imageSize.width() ) / imageSize.height();
+    if ( qAbs( ratio - imageRatio ) > 0.02 * imageRatio ) {
+        return QImage();
+    }
+
+    return image;
+}
+
+//---------------------------------------------------------------------------
+
+bool QThumbnailer::write( const QString &path, const QSize &size, const QString &outputPath, const int &quality )
+{
+    const QImage image = thumbnail( path, size, Qt::KeepAspectRatio );
+    if ( image.isNull() ) {
+        return false;
+    }
+
+    if ( isSameFile( path, outputPath ) ) {
+        qWarning() << Q_FUNC_INFO << "Would overwrite the source" << path;
+        return false;
+    }
+
+    // through a temporary file, a half written thumbnail never replaces
+    // a complete one
+    QSaveFile file( outputPath );
+    QImageWriter writer( &file, QFileInfo( outputPath ).suffix().toLower().toLatin1() );
+    writer.setQuality( quality );
+    if ( !file.open( QIODevice::WriteOnly ) || !writer.write( image ) || !file.commit() ) {
+        qWarning() << Q_FUNC_INFO << "Cannot write" << outputPath;
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+
+int QThumbnailer::writeAll( const QStringList &paths, const QSize &size,
+                            const QString &outputDirectory, const QString &format, const int &quality )
+{
+    const QStringList outputs = outputPaths( paths, outputDirectory, format );
+    foreach ( const QString &output, outputs ) {
+        if ( !output.isEmpty() && !QDir().mkpath( QFileInfo( output ).absolutePath() ) ) {
+            qWarning() << Q_FUNC_INFO << "Cannot create" << QFileInfo( output ).absolutePath();
+            return 0;
+        }
+    }
+
+    // nobody looks at these, interactive loads and prefetching go first and
+    // a spinning disk is read one file at a time
+    QIoScheduler *scheduler = QIoScheduler::globalInstance();
+    QAtomicInt written;
+    QList < quint64 > tasks;
+    for ( int i = 0; i < paths.size(); ++i ) {
+        const QString path = paths.at( i );
+        const QString output = outputs.at( i );
+        if ( output.isEmpty() ) {
+            qWarning() << Q_FUNC_INFO << "Would overwrite a source" << path;
+            continue;
+        }
+
+        tasks.append( scheduler->submit( path, QIoScheduler::OffscreenThumbnail, [ &, path, output ] () {
+            if ( write( path, size, output, quality ) ) {
+                written.ref();
+            }
+        } ) );
+    }
+
+    foreach ( const quint64 &task, tasks ) {
+        scheduler->wait( task );
+    }
+
+    return written.load();
+}
+
+//---------------------------------------------------------------------------
+
+QString QThumbnailer::outputPath( const QString &path, const QString &outputDirectory, const QString &format )
+{
+    return QDir( outputDirectory ).filePath( QFileInfo( path ).completeBaseName() + "." + format );
+}
+
+//---------------------------------------------------------------------------
+
+QStringList QThumbnailer::outputPaths( const QStringList &paths, const QString &outputDirectory, const QString &format )
+{
+    QStringList outputs;
+    if ( paths.isEmpty() ) {
+        return outputs;
+    }
+
+    // the deepest directory holding all of paths
+    QStringList absolutePaths;
+    foreach ( const QString &path, paths ) {
+        absolutePaths.append( QDir::cleanPath( QFileInfo( path ).absoluteFilePath() ) );
+    }
+
+    QString common = QFileInfo( absolutePaths.first() ).absolutePath();
+    foreach ( const QString &path, absolutePaths ) {
+        while ( !path.startsWith( common.endsWith( '/' ) ? common : common + '/' ) ) {
+            const QString parent = QFileInfo( common ).absolutePath();
+            if ( parent == common ) {
+                break;
+            }
+            common = parent;
+        }
+    }
+
+    QSet < QString > sources;
+    foreach ( const QString &path, absolutePaths ) {
+        const QString canonical = QFileInfo( path ).canonicalFilePath();
+        sources.insert( ( canonical.isEmpty() ? path : canonical ).toLower() );
+    }
+
+    // case folded, "a.jpg" and "A.JPG" are one file on some file systems;
+    // the sources as well, in doubt nothing is written
+    QSet < QString > taken;
+    const QDir root( common );
+    foreach ( const QString &path, absolutePaths ) {
+        // no common directory (other drives), flat
+        QString relativeDirectory = QFileInfo( root.relativeFilePath( path ) ).path();
+        if ( QDir::isAbsolutePath( relativeDirectory ) || relativeDirectory.startsWith( ".." ) ) {
+            relativeDirectory = ".";
+        }
+        const QString directory = QDir::cleanPath( QDir( outputDirectory ).filePath( relativeDirectory ) );
+        const QString baseName = QFileInfo( path ).completeBaseName();
+
+        QString output;
+        for ( int number = 1; output.isEmpty() || taken.contains( output.toLower() ); ++number ) {
+            const QString name = number == 1 ? baseName : QString( "%1.%2" ).arg( baseName ).arg( number );
+            output = QDir::cleanPath( QFileInfo( QDir( directory ).filePath( name + "." + format ) ).absoluteFilePath() );
+        }
+        taken.insert( output.toLower() );
+
+        const QString canonical = QFileInfo( output ).canonicalFilePath();
+        const bool source = sources.contains( output.toLower() )
+                            || ( !canonical.isEmpty() && sources.contains( canonical.toLower() ) );
+        outputs.append( source ? QString() : output );
+    }
+
+    return outputs;
+}
+
+//---------------------------------------------------------------------------
+
+bool QThumbnailer::isSameFile( const QString &path, const QString &other )
+{
+    const QFileInfo info( path );
+    const QFileInfo otherInfo( other );
+    if ( QDir::cleanPath( info.absoluteFilePath() ) == QDir::cleanPath( otherInfo.absoluteFilePath() ) ) {
+        return true;
+    }
+
+    return info.exists() && otherInfo.exists() && info.canonicalFilePath() == otherInfo.canonicalFilePath();
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,55 @@
+#ifndef QThumbnailer_H
+#define QThumbnailer_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QSize>
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! THUMBNAILER
+//! Small decodes for previews and batch thumbnail jobs. Works on QImage
+//! only, so it is safe on any thread and needs no GUI.
+class QThumbnailer
+{
+public:
+    // covers size like Qt::KeepAspectRatioByExpanding, or fits inside it;
+    // upright, EXIF orientation is applied
+    static QImage thumbnail( const QString &path, const QSize &size,
+                             const Qt::AspectRatioMode &mode = Qt::KeepAspectRatioByExpanding );
+
+    static bool write( const QString &path, const QSize &size, const QString &outputPath,
+                       const int &quality = -1 );
+
+    // thumbnails of paths into outputDirectory in parallel, as background
+    // work of QIoScheduler::globalInstance(); named by outputPaths(),
+    // blocking, returns the number written
+    static int writeAll( const QStringList &paths, const QSize &size,
+                         const QString &outputDirectory, const QString &format = "jpg",
+                         const int &quality = -1 );
+
+    // "name.png" -> "outputDirectory/name.<format>"
+    static QString outputPath( const QString &path, const QString &outputDirectory,
+                               const QString &format );
+
+    // outputPath() of each of paths, in their order, keeping the
+    // subdirectories under the directory common to all; names taken twice
+    // become "name.2.<format>"... An output that is one of paths is empty,
+    // nothing is written over a source
+    static QStringList outputPaths( const QStringList &paths, const QString &outputDirectory,
+                                    const QString &format );
+
+    // the same file, through links and relative paths too
+    static bool isSameFile( const QString &path, const QString &other );
+
+    // the EXIF thumbnail of a JPEG if it is large enough for size and
+    // shows the whole image, else a null image; as stored, not upright
+    static QImage exifThumbnail( const QString &path, const QSize &size,
+                                 const Qt::AspectRatioMode &mode = Qt::KeepAspectRatioByExpanding );
+
+private:
+    QThumbnailer() {}
+};
+
+#endif // QThumbnailer_H
@@ -0,0 +1,318 @@
+#include "qimagecomparison.h"
+#include "core/qimagewidgetlogging.h"
+#include "core/qimageorientation.h"
+#include "core/qpixelkernels.h"
+
+#include <QtConcurrent>
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! IMAGE COMPARISON WIDGET //!
+QImageComparisonWidget::QImageComparisonWidget( QImageCache *cache, QWidget *parent )
+    : QWidget( parent ),
+      m_cache( cache ),
+      m_pendingPanes( 0 ),
+      m_synchronized( true ),
+      m_broadcasting( false ),
+      m_overlayMode( NoOverlay ),
+      m_flickerIndex( 0 )
+{
+    m_layout = new QGridLayout( this );
+    m_layout->setContentsMargins( 0, 0, 0, 0 );
+    m_layout->setSpacing( 2 );
+
+    m_differenceTimer = new QTimer( this );
+    m_differenceTimer->setSingleShot( true );
+    m_differenceTimer->setInterval( 30 );
+    connect( m_differenceTimer, &QTimer::timeout,
+             this, &QImageComparisonWidget::updateDifference );
+
+    m_flickerTimer = new QTimer( this );
+    m_flickerTimer->setInterval( 500 );
+    connect( m_flickerTimer, &QTimer::timeout,
+             this, &QImageComparisonWidget::flicker );
+
+    for ( int i = 0; i < MaxPanes; ++i ) {
+        QCustomGraphicsView *view = new QCustomGraphicsView( this );
+        QGraphicsPixmapItem *item = view->scene()->addPixmap( QPixmap() );
+        item->setTransformationMode( Qt::SmoothTransformation );
+
+        connect( view, &QCustomGraphicsView::viewChanged,
+                 this, &QImageComparisonWidget::broadcastView );
+
+        view->hide();
+
+        QFutureWatcher < QImage > *watcher = new QFutureWatcher < QImage > ( this );
+        connect( watcher, &QFutureWatcher < QImage >::finished,
+                 this, &QImageComparisonWidget::paneDecoded );
+
+        m_views.append( view );
+        m_items.append( item );
+        m_decodeWatchers.append( watcher );
+    }
+
+    arrangePanes();
+}
+
+//---------------------------------------------------------------------------
+
+QImageComparisonWidget::~QImageComparisonWidget()
+{
+    for ( int i = 0; i < m_decodes.size(); ++i ) {
+        m_decodes[ i ].waitForFinished();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+//! [1]
+void QImageComparisonWidget::setPaths( const QStringList &paths )
+{
+    clear();
+
+    m_paths = paths.mid( 0, MaxPanes );
+    arrangePanes();
+
+    for ( int i = m_decodes.size() - 1; i >= 0; --i ) {
+        if ( m_decodes.at( i ).isFinished() ) {
+            m_decodes.removeAt( i );
+        }
+    }
+
+    // all panes at once; each task hands its decode over, an eviction from
+    // the cache meanwhile costs nothing
+    QImageCache *cache = m_cache;
+    for ( int i = 0; i < m_paths.size(); ++i ) {
+        const QString path = m_paths.at( i );
+        const QFuture < QImage > decode = QtConcurrent::run( [ cache, path ] () {
+            // panes are compared pixel by pixel, so they are turned upright here
+            const QImage decoded = cache->image( path );
+            return QImageOrientation::applied( decoded, QImageOrientation::of( decoded ) );
+        } );
+
+        m_images.append( QImage() );
+        m_pixmaps.append( QPixmap() );
+        m_decodes.append( decode );
+        m_decodeWatchers.at( i )->setFuture( decode );
+    }
+    m_pendingPanes = m_paths.size();
+
+    QIW_TRACE_VALUE( lcImageWidgetView, "Comparison panes:", m_paths.size() );
+
+    emit pathsChanged( m_paths );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::clear()
+{
+    m_flickerTimer->stop();
+    m_differenceTimer->stop();
+    clearDifference();
+
+    for ( int i = 0; i < MaxPanes; ++i ) {
+        m_items.at( i )->setPixmap( QPixmap() );
+        m_views.at( i )->hide();
+    }
+
+    // decodes still running are dropped by paneDecoded()
+    m_paths.clear();
+    m_images.clear();
+    m_pixmaps.clear();
+    m_pendingPanes = 0;
+    m_flickerIndex = 0;
+}
+//! [1]
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::paneDecoded()
+{
+    // a watcher given a new decode does not deliver the replaced one
+    QFutureWatcher < QImage > *watcher = static_cast < QFutureWatcher < QImage > * > ( sender() );
+    const int pane = m_decodeWatchers.indexOf( watcher );
+    if ( pane < 0 || pane >= m_paths.size() || m_pendingPanes == 0 ) {
+        return;
+    }
+
+    m_images[ pane ] = watcher->result();
+    m_pixmaps[ pane ] = QPixmap::fromImage( m_images.at( pane ) );
+    m_items.at( pane )->setPixmap( m_pixmaps.at( pane ) );
+    m_views.at( pane )->show();
+
+    m_broadcasting = true;
+    m_views.at( pane )->fitInView( m_items.at( pane ), Qt::KeepAspectRatio );
+    m_broadcasting = false;
+
+    // the views are synchronized and overlays started once all are there
+    if ( --m_pendingPanes == 0 ) {
+        fitToWindow();
+        setOverlayMode( m_overlayMode );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+//! [2]
+void QImageComparisonWidget::setSynchronized( const bool &synchronized )
+{
+    m_synchronized = synchronized;
+
+    if ( m_synchronized && !m_views.isEmpty() ) {
+        emit m_views.first()->viewChanged();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::fitToWindow()
+{
+    m_broadcasting = true;
+    for ( int i = 0; i < m_paths.size(); ++i ) {
+        m_views.at( i )->fitInView( m_items.at( i ), Qt::KeepAspectRatio );
+    }
+    m_broadcasting = false;
+
+    if ( m_synchronized && !m_paths.isEmpty() ) {
+        emit m_views.first()->viewChanged();
+    }
+}
+//! [2]
+
+//---------------------------------------------------------------------------
+
+//! [3]
+void QImageComparisonWidget::setOverlayMode( const OverlayMode &mode )
+{
+    m_overlayMode = mode;
+
+    m_flickerTimer->stop();
+    m_flickerIndex = 0;
+    if ( !m_pixmaps.isEmpty() ) {
+        m_items.first()->setPixmap( m_pixmaps.first() );
+    }
+
+    if ( m_overlayMode == Flicker && m_pixmaps.size() > 1 && m_pendingPanes == 0 ) {
+        m_flickerTimer->start();
+    }
+
+    updateDifference();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::setFlickerInterval( const int &msec )
+{
+    m_flickerTimer->setInterval( qMax( 50, msec ) );
+}
+
+//---------------------------------------------------------------------------
+
+int QImageComparisonWidget::flickerInterval() const
+{
+    return m_flickerTimer->interval();
+}
+//! [3]
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::broadcastView()
+{
+    if ( m_broadcasting ) {
+        return;
+    }
+
+    QCustomGraphicsView *source = qobject_cast < QCustomGraphicsView * > ( sender() );
+    if ( m_synchronized && source ) {
+        const QTransform transform = source->transform();
+        const QPointF center = source->viewCenter();
+
+        m_broadcasting = true;
+        for ( int i = 0; i < m_paths.size(); ++i ) {
+            if ( m_views.at( i ) != source ) {
+                m_views.at( i )->setViewState( transform, center );
+            }
+        }
+        m_broadcasting = false;
+    }
+
+    if ( m_overlayMode == Difference ) {
+        m_differenceTimer->start();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::updateDifference()
+{
+    clearDifference();
+
+    if ( m_overlayMode != Difference || m_images.size() < 2 || m_pendingPanes > 0 ) {
+        return;
+    }
+
+    const QImage &reference = m_images.first();
+    for ( int i = 1; i < m_images.size(); ++i ) {
+        const QImage &image = m_images.at( i );
+        const QRect visible = m_views.at( i )->visibleSceneRect().toAlignedRect()
+                              & reference.rect() & image.rect();
+        if ( visible.isEmpty() ) {
+            continue;
+        }
+
+        // only the visible part is converted and compared
+        const QImage left = reference.copy( visible ).convertToFormat( QImage::Format_ARGB32 );
+        const QImage right = image.copy( visible ).convertToFormat( QImage::Format_ARGB32 );
+        QImage difference( visible.size(), QImage::Format_ARGB32 );
+
+        for ( int y = 0; y < visible.height(); ++y ) {
+            QPixelKernels::absDiff( reinterpret_cast < const QRgb * > ( left.constScanLine( y ) ),
+                                    reinterpret_cast < const QRgb * > ( right.constScanLine( y ) ),
+                                    reinterpret_cast < QRgb * > ( difference.scanLine( y ) ),
+                                    visible.width() );
+        }
+
+        QGraphicsPixmapItem *item = m_views.at( i )->scene()->addPixmap( QPixmap::fromImage( difference ) );
+        item->setPos( visible.topLeft() );
+        item->setZValue( 1 );
+        m_differenceItems.append( item );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::flicker()
+{
+    if ( m_pixmaps.size() < 2 ) {
+        m_flickerTimer->stop();
+        return;
+    }
+
+    m_flickerIndex = ( m_flickerIndex + 1 ) % m_pixmaps.size();
+    m_items.first()->setPixmap( m_pixmaps.at( m_flickerIndex ) );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::clearDifference()
+{
+    qDeleteAll( m_differenceItems );
+    m_differenceItems.clear();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageComparisonWidget::arrangePanes()
+{
+    foreach ( QCustomGraphicsView *view, m_views ) {
+        m_layout->removeWidget( view );
+    }
+
+    // 2 side by side, 3 in a row, 4 as 2 x 2
+    const int columns = m_paths.size() == MaxPanes ? 2 : MaxPanes - 1;
+    for ( int i = 0; i < m_views.size(); ++i ) {
+        m_layout->addWidget( m_views.at( i ), i / columns, i % columns );
+    }
+}
+
+//---------------------------------------------------------------------------
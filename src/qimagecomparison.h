@@ -0,0 +1,101 @@
+#ifndef QImageComparison_H
+#define QImageComparison_H
+
+#include <QWidget>
+#include <QGridLayout>
+#include <QGraphicsPixmapItem>
+#include <QStringList>
+#include <QTimer>
+#include <QFuture>
+#include <QFutureWatcher>
+
+#include "qimagewidget.h"
+#include "core/qimagecache.h"
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! IMAGE COMPARISON WIDGET
+//! Two to four panes showing versions of an image. Decodes come from a
+//! shared QImageCache in parallel, off the user interface thread, and each
+//! pane shows once its own is done; pan and zoom of one pane are broadcast
+//! to the others.
+//! The difference overlay compares each pane with the first one and is
+//! computed for the visible part only, again after every view change.
+class QImageComparisonWidget : public QWidget
+{
+    Q_OBJECT
+
+signals:
+    void pathsChanged( const QStringList &paths );
+
+public:
+    enum OverlayMode {
+        NoOverlay,
+        Difference, // |pane - first pane| per channel
+        Flicker     // the first pane cycles through all images
+    };
+
+    enum { MaxPanes = 4 };
+
+    explicit QImageComparisonWidget( QImageCache *cache, QWidget *parent = 0 );
+    ~QImageComparisonWidget();
+
+    //! [1] IMAGES
+    void setPaths( const QStringList &paths ); // the first MaxPanes are shown, not blocking
+    QStringList paths() const { return m_paths; }
+    void clear();
+
+    QCustomGraphicsView *view( const int &pane ) const { return m_views.value( pane ); }
+    //! [1]
+
+    //! [2] VIEW
+    void setSynchronized( const bool &synchronized );
+    bool isSynchronized() const { return m_synchronized; }
+
+    void fitToWindow();
+    //! [2]
+
+    //! [3] OVERLAY
+    void setOverlayMode( const OverlayMode &mode );
+    OverlayMode overlayMode() const { return m_overlayMode; }
+
+    void setFlickerInterval( const int &msec );
+    int flickerInterval() const;
+    //! [3]
+
+private slots:
+    void paneDecoded();
+    void broadcastView();
+    void updateDifference();
+    void flicker();
+
+private:
+    void clearDifference();
+    void arrangePanes();
+
+    QImageCache *m_cache;
+    QStringList m_paths;
+    QList < QImage > m_images;   // decodes, compared by the overlay; null until done
+    QList < QPixmap > m_pixmaps; // shown, also swapped by flicker
+
+    QList < QFutureWatcher < QImage > * > m_decodeWatchers; // one per pane
+    // decodes not finished, replaced ones too: they use m_cache, the
+    // destructor waits for all of them
+    QList < QFuture < QImage > > m_decodes;
+    int m_pendingPanes; // of m_paths, decodes not delivered yet
+
+    QGridLayout *m_layout;
+    QList < QCustomGraphicsView * > m_views;
+    QList < QGraphicsPixmapItem * > m_items;
+    QList < QGraphicsPixmapItem * > m_differenceItems;
+
+    bool m_synchronized;
+    bool m_broadcasting; // views changed by broadcastView() itself
+
+    OverlayMode m_overlayMode;
+    QTimer *m_differenceTimer; // coalesces view changes
+    QTimer *m_flickerTimer;
+    int m_flickerIndex;
+};
+
+#endif // QImageComparison_H
@@ -1,4 +1,16 @@
 #include "qimagewidget.h"
+#include "core/qimagewidgetlogging.h"
+#include "core/qimagedecoder.h"
+#include "core/qioscheduler.h"
+#include "core/qimageorientation.h"
+#include "core/qpixelkernels.h"
+#include "qimagecomparison.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
 
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
@@ -105,6 +117,11 @@ QCustomGraphicsView::QCustomGraphicsView( QWidget *parent )
 
     //! [3]
     m_scaled = false;
+
+    connect( horizontalScrollBar(), &QScrollBar::valueChanged,
+             this, &QCustomGraphicsView::viewChanged );
+    connect( verticalScrollBar(), &QScrollBar::valueChanged,
+             this, &QCustomGraphicsView::viewChanged );
     //! [3]
 }
 
@@ -197,6 +214,7 @@ void QCustomGraphicsView::getRect() // get selected rect
 void QCustomGraphicsView::zoomIn()
 {
     scale( 1.15, 1.15 );
+    emit viewChanged();
 }
 
 //---------------------------------------------------------------------------
@@ -204,6 +222,29 @@ void QCustomGraphicsView::zoomIn()
 void QCustomGraphicsView::zoomOut()
 {
     scale( 1 / 1.15, 1 / 1.15 );
+    emit viewChanged();
+}
+
+//---------------------------------------------------------------------------
+
+QPointF QCustomGraphicsView::viewCenter() const
+{
+    return mapToScene( viewport()->rect().center() );
+}
+
+//---------------------------------------------------------------------------
+
+QRectF QCustomGraphicsView::visibleSceneRect() const
+{
+    return mapToScene( viewport()->rect() ).boundingRect();
+}
+
+//---------------------------------------------------------------------------
+
+void QCustomGraphicsView::setViewState( const QTransform &transform, const QPointF &center )
+{
+    setTransform( transform );
+    centerOn( center );
 }
 
 //---------------------------------------------------------------------------
@@ -224,6 +265,141 @@ void QCustomGraphicsView::wheelEvent( QWheelEvent *event )
 }
 //! [3]
 
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! PIXMAP VIEW ITEM //!
+QPixmapViewItem::QPixmapViewItem( const QPixmap &pixmap, const QRect &sourceRect, QGraphicsItem *parent )
+    : QGraphicsPixmapItem( pixmap, parent ),
+      m_sourceRect( sourceRect )
+{
+
+}
+
+//---------------------------------------------------------------------------
+
+void QPixmapViewItem::setSourceRect( const QRect &rect )
+{
+    prepareGeometryChange();
+    m_sourceRect = rect;
+    update();
+}
+
+//---------------------------------------------------------------------------
+
+QRect QPixmapViewItem::sourceRect() const
+{
+    return m_sourceRect.isNull() ? pixmap().rect() : m_sourceRect;
+}
+
+//---------------------------------------------------------------------------
+
+QRectF QPixmapViewItem::boundingRect() const
+{
+    return QRectF( offset(), sourceRect().size() );
+}
+
+//---------------------------------------------------------------------------
+
+QPainterPath QPixmapViewItem::shape() const
+{
+    QPainterPath path;
+    path.addRect( boundingRect() );
+    return path;
+}
+
+//---------------------------------------------------------------------------
+
+bool QPixmapViewItem::contains( const QPointF &point ) const
+{
+    return boundingRect().contains( point );
+}
+
+//---------------------------------------------------------------------------
+
+void QPixmapViewItem::paint( QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget )
+{
+    Q_UNUSED( option );
+    Q_UNUSED( widget );
+
+    // draws straight from the source, no sub-pixmap is made
+    painter->setRenderHint( QPainter::SmoothPixmapTransform,
+                            transformationMode() == Qt::SmoothTransformation );
+    painter->drawPixmap( boundingRect(), pixmap(), QRectF( sourceRect() ) );
+}
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! UNDO MEMORY //!
+qint64 QUndoMemory::bytes() const
+{
+    // commands share pixmaps with each other and with the shown image
+    QSet < qint64 > counted;
+    counted.insert( m_currentPixmap->cacheKey() );
+
+    qint64 bytes = 0;
+    for ( int i = 0; i < m_undoStack->count(); ++i ) {
+        QList < QPixmap > pixmaps;
+        const QUndoCommand *command = m_undoStack->command( i );
+        if ( const QCropCommand *crop = dynamic_cast < const QCropCommand * > ( command ) ) {
+            pixmaps = crop->pixmaps();
+        } else if ( const QPasteCommand *paste = dynamic_cast < const QPasteCommand * > ( command ) ) {
+            pixmaps = paste->pixmaps();
+        } else if ( const QRotateCommand *rotate = dynamic_cast < const QRotateCommand * > ( command ) ) {
+            pixmaps = rotate->pixmaps();
+        }
+
+        foreach ( const QPixmap &pixmap, pixmaps ) {
+            if ( !pixmap.isNull() && !counted.contains( pixmap.cacheKey() ) ) {
+                counted.insert( pixmap.cacheKey() );
+                bytes += qint64( pixmap.width() ) * pixmap.height() * pixmap.depth() / 8;
+            }
+        }
+    }
+
+    return bytes;
+}
+
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+//! BULK ROTATE COMMAND //!
+void QBulkRotateCommand::undo()
+{
+    QImageWidget *imageWidget = m_imageWidget;
+    const QSharedPointer < QStringList > turned = m_turned;
+    const int degrees = m_degrees;
+
+    // the files are known once the redo before has finished
+    m_imageWidget->afterBulk( [ imageWidget, turned, degrees ] () {
+        imageWidget->rotateFiles( *turned, -degrees, [ turned ] ( const QStringList &succeeded ) {
+            foreach ( const QString &path, succeeded ) {
+                turned->removeAll( path );
+            }
+        } );
+    } );
+}
+
+//---------------------------------------------------------------------------
+
+void QBulkRotateCommand::redo()
+{
+    QImageWidget *imageWidget = m_imageWidget;
+    const QSharedPointer < QStringList > turned = m_turned;
+    const QStringList paths = m_paths;
+    const int degrees = m_degrees;
+
+    // files an undo could not turn back are turned already
+    m_imageWidget->afterBulk( [ imageWidget, turned, paths, degrees ] () {
+        QStringList left = paths;
+        foreach ( const QString &path, *turned ) {
+            left.removeAll( path );
+        }
+
+        imageWidget->rotateFiles( left, degrees, [ turned ] ( const QStringList &succeeded ) {
+            turned->append( succeeded );
+        } );
+    } );
+}
+
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 //! QIMAGE WIDGET //!
@@ -235,6 +411,8 @@ QImageWidget::QImageWidget( QWidget *parent )
     m_customGraphicsView = new QCustomGraphicsView( this );
     m_graphicsScene = new QGraphicsScene( this );
     m_customGraphicsView->setScene( m_graphicsScene );
+    m_graphicsPixmapItem = 0;
+    m_currentPixmapOrientation = QImageOrientation::Normal;
 
     // preview widget
     m_previewWidget = new QListWidget( this );
@@ -244,6 +422,11 @@ QImageWidget::QImageWidget( QWidget *parent )
     m_splitter->addWidget( m_customGraphicsView );
     m_splitter->addWidget( m_previewWidget );
 
+    // comparison panes, shown instead of the view
+    m_comparisonWidget = new QImageComparisonWidget( &m_imageCache, this );
+    m_comparisonWidget->setVisible( false );
+    m_splitter->insertWidget( 1, m_comparisonWidget );
+
     QHBoxLayout *m_layout = new QHBoxLayout( this );
     m_layout->addWidget( m_splitter );
     setLayout( m_layout );
@@ -251,8 +434,21 @@ QImageWidget::QImageWidget( QWidget *parent )
 
     //! [2]
     // filters
-    m_filters = "*.png ; *.jpg ; *.bmp ; *.ico ; *.jpeg ; *.gif";
+    m_filters = QImageScanner::defaultNameFilters().join( " ; " );
     m_subDirectorySearching = true;
+    // read and pruned off the user interface thread, a scan meanwhile
+    // reads the directories itself
+    QDirectoryIndex *directoryIndex = &m_directoryIndex;
+    keepCacheWorker( QtConcurrent::run( [ directoryIndex ] () {
+        directoryIndex->load();
+        if ( directoryIndex->prune() > 0 ) {
+            directoryIndex->save();
+        }
+    } ) );
+
+    m_sortFilterWatcher = new QFutureWatcher < QImageSortFilter::Result > ( this );
+    connect( m_sortFilterWatcher, &QFutureWatcher < QImageSortFilter::Result >::finished,
+             this, &QImageWidget::sortFilterFinished );
 
     setCurrentPixmapModified( false );
     //! [2]
@@ -283,6 +479,10 @@ QImageWidget::QImageWidget( QWidget *parent )
     m_showRemoveDialog = true;
     m_moveToTrash = true;
 
+    m_removeWatcher = new QFutureWatcher < QFileRemover::Result > ( this );
+    connect( m_removeWatcher, &QFutureWatcher < QFileRemover::Result >::finished,
+             this, &QImageWidget::removeFinished );
+
     connect( m_customGraphicsView, &QCustomGraphicsView::selectedRect,
              this, &QImageWidget::getSelection );
     //! [7]
@@ -290,7 +490,8 @@ QImageWidget::QImageWidget( QWidget *parent )
     //! [8]
     m_previewVisible = false;
     m_previewWidget->setVisible( false );
-    m_pixmapsPathsBefore = QStringList();
+    m_previewWidget->setSelectionMode( QAbstractItemView::ExtendedSelection );
+    m_previewsGeneration = 0;
     setPreviewPixmapSize( QSize( 100, 100 ) );
 
     connect( m_previewWidget, &QListWidget::currentRowChanged,
@@ -302,19 +503,151 @@ QImageWidget::QImageWidget( QWidget *parent )
     m_infoBox = new QMessageBox( static_cast < QWidget * > ( this->parent() ) );
     //! [9]
 
+    //! [17]
+    m_analysisBox = new QMessageBox( static_cast < QWidget * > ( this->parent() ) );
+    //! [17]
+
     //! [11]
-    m_previewThread = new QPreviewThread( this );
-    connect( m_previewThread, &QPreviewThread::appendNewPreview,
-             this, &QImageWidget::appendNewPreview );
+    m_previewLoader = new QPreviewLoader( this );
+    connect( m_previewLoader, &QPreviewLoader::previewReady,
+             this, &QImageWidget::previewReady );
+    connect( m_previewWidget->verticalScrollBar(), &QScrollBar::valueChanged,
+             this, &QImageWidget::updateVisiblePreviews );
     //! [11]
 
+    //! [13]
+    // like the directory index, off the user interface thread
+    QPerceptualHashIndex *perceptualHashIndex = &m_perceptualHashIndex;
+    keepCacheWorker( QtConcurrent::run( [ perceptualHashIndex ] () {
+        perceptualHashIndex->load();
+        if ( perceptualHashIndex->prune() > 0 ) {
+            perceptualHashIndex->save();
+        }
+    } ) );
+    m_duplicatesWatcher = new QFutureWatcher < QList < QStringList > > ( this );
+    connect( m_duplicatesWatcher, &QFutureWatcher < QList < QStringList > >::finished,
+             this, &QImageWidget::duplicatesFinished );
+    //! [13]
+
+    //! [14]
+    m_decodeQueue = new QDecodeQueue( this );
+    connect( m_decodeQueue, &QDecodeQueue::decoded,
+             this, &QImageWidget::slideshowDecoded );
+    connect( m_decodeQueue, &QDecodeQueue::dropped,
+             this, &QImageWidget::slideshowDecoded, Qt::QueuedConnection );
+
+    m_slideshowRunning = false;
+    m_slideshowIndex = 0;
+    m_slideshowWaitingIndex = -1;
+    m_slideshowDeadline = 0;
+    m_slideshowInterval = 5000;
+    m_slideshowPolicy = WaitForDecode;
+
+    m_slideshowTimer = new QTimer( this );
+    m_slideshowTimer->setSingleShot( true );
+    m_slideshowTimer->setTimerType( Qt::PreciseTimer );
+    connect( m_slideshowTimer, &QTimer::timeout,
+             this, &QImageWidget::slideshowTick );
+
+    m_slideshowCrossfade = 0;
+    m_crossfadeItem = 0;
+    m_crossfadeAnimation = new QVariantAnimation( this );
+    m_crossfadeAnimation->setStartValue( 1.0 );
+    m_crossfadeAnimation->setEndValue( 0.0 );
+    connect( m_crossfadeAnimation, &QVariantAnimation::valueChanged,
+             [ this ] ( const QVariant &value ) {
+        if ( m_crossfadeItem ) {
+            m_crossfadeItem->setOpacity( value.toReal() );
+        }
+    } );
+    connect( m_crossfadeAnimation, &QVariantAnimation::finished,
+             this, &QImageWidget::crossfadeFinished );
+    //! [14]
+
+    //! [15]
+    m_animationPlayer = new QAnimationPlayer( this );
+    connect( m_animationPlayer, &QAnimationPlayer::frameChanged,
+             this, &QImageWidget::showAnimationFrame );
+    //! [15]
+
+    //! [18]
+    m_progressiveItem = 0;
+    m_progressiveDecoder = new QProgressiveDecoder( this );
+    connect( m_progressiveDecoder, &QProgressiveDecoder::decodingStarted,
+             this, &QImageWidget::progressiveDecodingStarted );
+    connect( m_progressiveDecoder, &QProgressiveDecoder::partDecoded,
+             this, &QImageWidget::progressivePartDecoded );
+    connect( m_progressiveDecoder, &QProgressiveDecoder::progress,
+             this, &QImageWidget::progressiveDecodingProgress );
+    connect( m_progressiveDecoder, &QProgressiveDecoder::decoded,
+             this, &QImageWidget::progressiveDecoded );
+    //! [18]
+
+    //! [19]
+    m_undoMemory = new QUndoMemory( m_undoStack, &m_currentPixmap );
+    m_memoryGovernor = new QMemoryGovernor( this );
+    m_memoryGovernor->addClient( "images", &m_imageCache );
+    m_memoryGovernor->addClient( "prefetch", m_decodeQueue );
+    m_memoryGovernor->addClient( "undo", m_undoMemory );
+
+    // statistics are evicted too, the rest is only counted
+    m_previewMemory = new QPreviewMemory;
+    m_memoryGovernor->addClient( "previews", m_previewMemory );
+    m_memoryGovernor->addClient( "statistics", &m_statisticsCache );
+    m_memoryGovernor->addClient( "metadata", &m_metadataCache );
+    m_memoryGovernor->addClient( "hashes", &m_perceptualHashIndex );
+    m_memoryGovernor->addClient( "directories", &m_directoryIndex );
+    //! [19]
+
+    //! [20]
+    m_bulkRotation = 0;
+    m_fileUndoStack = new QUndoStack( this );
+    m_bulkOperation = new QBatchOperation( this );
+    connect( m_bulkOperation, &QBatchOperation::progress,
+             this, &QImageWidget::bulkProgress );
+    connect( m_bulkOperation, &QBatchOperation::finished,
+             this, &QImageWidget::bulkOperationFinished );
+    connect( m_previewWidget, &QListWidget::itemSelectionChanged, [ this ] () {
+        emit previewSelectionChanged( m_previewWidget->selectedItems().size() );
+    } );
+    //! [20]
+
+    //! [21]
+    m_navigationDelay = 80;
+    m_navigationSettling = false;
+    m_navigationTimer = new QTimer( this );
+    m_navigationTimer->setSingleShot( true );
+    connect( m_navigationTimer, &QTimer::timeout,
+             this, &QImageWidget::navigationSettle );
+    //! [21]
+
 }
 
 //---------------------------------------------------------------------------
 
 QImageWidget::~QImageWidget()
 {
+    // the workers use m_metadataCache and the indexes, replaced ones still run
+    for ( int i = 0; i < m_cacheWorkers.size(); ++i ) {
+        m_cacheWorkers[ i ].cancel();
+    }
+    for ( int i = 0; i < m_cacheWorkers.size(); ++i ) {
+        m_cacheWorkers[ i ].waitForFinished();
+    }
+    m_sortFilterWatcher->waitForFinished();
+    m_duplicatesWatcher->waitForFinished();
+
+    // its decodes use m_imageCache, gone before the children are deleted
+    delete m_comparisonWidget;
+
+    // files already gone from the list are removed before leaving
+    m_removeWatcher->waitForFinished();
+    if ( !m_removeQueue.isEmpty() ) {
+        QFileRemover::remove( m_removeQueue, m_moveToTrash );
+    }
 
+    delete m_undoMemory;
+    delete m_previewMemory;
 }
 
 //---------------------------------------------------------------------------
@@ -330,9 +663,10 @@ void QImageWidget::setPixmapsPaths( const QStringList &paths )
 
     m_startedDirectoryPath = QFileInfo( paths.first() ).absolutePath();
 
-    m_pixmapsPaths = paths;
+    setSourcePaths( paths );
     m_currentPixmapIndex = 0;
 
+    applySortFilter();
     updatePixmapByIndex();
 }
 
@@ -348,8 +682,7 @@ void QImageWidget::setPixmapsDirectory( const QString &dirPath )
         return;
     }
 
-    m_pixmapsPaths.clear();
-    m_pixmapsPaths = searchDirectory( dirPath );
+    setSourcePaths( searchDirectory( dirPath ) );
 
     if ( m_pixmapsPaths.size() <= 0  ) {
         qWarning() << Q_FUNC_INFO << trUtf8( "No files!" );
@@ -362,6 +695,8 @@ void QImageWidget::setPixmapsDirectory( const QString &dirPath )
     // for previews update
     m_startedDirectoryPath = dirPath;
 
+    applySortFilter();
+
     m_currentPixmapIndex = 0;
     if ( m_previewVisible && m_previewWidget->count() > 0 ) {
         m_previewWidget->currentRowChanged( m_currentPixmapIndex );
@@ -381,19 +716,14 @@ void QImageWidget::setPixmapsDirectory( const QString &dirPath )
 
 QStringList QImageWidget::searchDirectory( const QString &dirPath )
 {
-    QDirIterator::IteratorFlag searcherFlag;
-    if ( m_subDirectorySearching ) {
-        searcherFlag = QDirIterator::Subdirectories;
-    } else {
-        searcherFlag = QDirIterator::NoIteratorFlags;
-    }
+    // unchanged directories are not read again, a rescan costs a stat each
+    const QStringList paths = m_directoryIndex.scan( dirPath, m_filters.split( " ; " ), m_subDirectorySearching );
 
-    QStringList paths;
-
-    QDirIterator searcher( dirPath, m_filters.split( " ; " ), QDir::Files, searcherFlag  );
-    while ( searcher.hasNext() ) {
-        paths.append( searcher.next() );
-    }
+    // written off the user interface thread, nothing if nothing was read
+    QDirectoryIndex *directoryIndex = &m_directoryIndex;
+    keepCacheWorker( QtConcurrent::run( [ directoryIndex ] () {
+        directoryIndex->save();
+    } ) );
 
     return paths;
 }
@@ -408,8 +738,7 @@ void QImageWidget::setPixmapPathWithDirectorySearching( const QString &path )
     }
 
     // scan dir
-    m_pixmapsPaths.clear();
-    m_pixmapsPaths = searchDirectory( QFileInfo( path ).absolutePath() );
+    setSourcePaths( searchDirectory( QFileInfo( path ).absolutePath() ) );
     if ( m_pixmapsPaths.size() <= 0  ) {
         qWarning() << Q_FUNC_INFO << trUtf8( "No files!" );
         QMessageBox::critical( this,
@@ -419,16 +748,16 @@ void QImageWidget::setPixmapPathWithDirectorySearching( const QString &path )
     }
 
     // find current image and index
-    for ( int i = 0; i < m_pixmapsPaths.size(); ++i ) {
-        if ( path == m_pixmapsPaths.at( i ) ) {
-            m_currentPixmapIndex = i;
-            break;
-        }
+    const int index = m_pixmapsPaths.indexOf( path );
+    if ( index >= 0 ) {
+        m_currentPixmapIndex = index;
     }
 
     // for update previews
     m_startedDirectoryPath = QFileInfo( path ).absolutePath();
 
+    applySortFilter();
+
     // update pixmap by index
     updatePixmapByIndex();
 }
@@ -449,9 +778,182 @@ bool QImageWidget::subDirectorySearching() const
 
 //---------------------------------------------------------------------------
 
+void QImageWidget::setNameFilters( const QStringList &filters )
+{
+    m_filters = filters.join( " ; " );
+}
+
+//---------------------------------------------------------------------------
+
+QStringList QImageWidget::nameFilters() const
+{
+    return m_filters.split( " ; " );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setSortKey( const QImageSortFilter::SortKey &key )
+{
+    m_sortFilterSettings.sortKey = key;
+    applySortFilter();
+}
+
+//---------------------------------------------------------------------------
+
+QImageSortFilter::SortKey QImageWidget::sortKey() const
+{
+    return m_sortFilterSettings.sortKey;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setSortOrder( const Qt::SortOrder &order )
+{
+    m_sortFilterSettings.sortOrder = order;
+    applySortFilter();
+}
+
+//---------------------------------------------------------------------------
+
+Qt::SortOrder QImageWidget::sortOrder() const
+{
+    return m_sortFilterSettings.sortOrder;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setFilter( const QString &wildcard )
+{
+    m_sortFilterSettings.filter = wildcard;
+    applySortFilter();
+}
+
+//---------------------------------------------------------------------------
+
+QString QImageWidget::filter() const
+{
+    return m_sortFilterSettings.filter;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setSourcePaths( const QStringList &paths )
+{
+    m_sourcePaths = paths;
+    m_sortFilterResult = QImageSortFilter::Result();
+
+    // warm the metadata cache for the info panel and sorting
+    m_metadataFuture.cancel();
+    m_metadataFuture = m_metadataCache.gatherAsync( paths, QImageMetadata::AllFields );
+    keepCacheWorker( m_metadataFuture );
+
+    // shown in source order until the sorted list is ready
+    m_pixmapsPaths.setPaths( paths );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::applySortFilter()
+{
+    if ( m_sourcePaths.isEmpty() ) {
+        return;
+    }
+
+    const QImageSortFilter::Settings settings = m_sortFilterSettings;
+
+    // nothing to sort, the collection already holds the source
+    if ( settings.isIdentity() && m_sortFilterResult.sorted.isEmpty() ) {
+        m_sortFilterWatcher->cancel();
+        m_sortFilterResult.settings = settings;
+        m_sortFilterResult.sorted = m_sourcePaths;
+        m_sortFilterResult.paths = m_sourcePaths;
+        return;
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Sort and filter, key:", settings.sortKey );
+
+    const QStringList source = m_sourcePaths;
+    const QImageSortFilter::Result previous = m_sortFilterResult;
+    QImageMetadataCache *cache = &m_metadataCache;
+
+    // a new future replaces the pending one, its result is never delivered
+    const QFuture < QImageSortFilter::Result > future = QtConcurrent::run( [ source, settings, cache, previous ] () {
+        return QImageSortFilter::apply( source, settings, cache, previous );
+    } );
+    keepCacheWorker( future );
+    m_sortFilterWatcher->setFuture( future );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::keepCacheWorker( const QFuture < void > &future )
+{
+    for ( int i = m_cacheWorkers.size() - 1; i >= 0; --i ) {
+        if ( m_cacheWorkers.at( i ).isFinished() ) {
+            m_cacheWorkers.removeAt( i );
+        }
+    }
+
+    m_cacheWorkers.append( future );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::sortFilterFinished()
+{
+    if ( m_sortFilterWatcher->isCanceled() ) {
+        updatePreviews();
+        return;
+    }
+
+    m_sortFilterResult = m_sortFilterWatcher->result();
+    const QStringList &paths = m_sortFilterResult.paths;
+
+    if ( paths.isEmpty() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No files match the filter." );
+        m_pixmapsPaths.clear();
+        clearPixmap();
+        updatePreviews();
+        emit pixmapsOrderChanged();
+        return;
+    }
+
+    if ( paths != m_pixmapsPaths.paths() ) {
+        m_pixmapsPaths.setPaths( paths );
+    }
+
+    // stay on the same image if it is still there
+    const int index = m_pixmapsPaths.indexOf( m_currentPixmapPath );
+    if ( index >= 0 ) {
+        m_currentPixmapIndex = index;
+        m_slideshowIndex = index;
+        updateNavigationAvailable();
+        updatePreviews();
+    } else {
+        m_currentPixmapIndex = 0;
+        updatePixmapByIndex();
+    }
+
+    emit pixmapsOrderChanged();
+}
+
+//---------------------------------------------------------------------------
+
 void QImageWidget::setPixmap( const QPixmap &pixmap )
 {
+    setPixmapView( pixmap, QRect() );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setPixmapView( const QPixmap &pixmap, const QRect &rect, const int &orientation )
+{
+    // edited pixmaps are still images
+    m_animationPlayer->stop();
+
     m_currentPixmap = pixmap;
+    m_currentPixmapRect = rect == pixmap.rect() ? QRect() : rect;
+    m_currentPixmapOrientation = orientation;
     updatePixmap();
 }
 
@@ -460,7 +962,32 @@ void QImageWidget::setPixmap( const QPixmap &pixmap )
 // getters
 QPixmap QImageWidget::currentPixmap() const
 {
-    return m_currentPixmap;
+    if ( m_currentPixmapOrientation != QImageOrientation::Normal ) {
+        // the one pass that turns the pixels upright, on demand only
+        return QPixmap::fromImage( QImageOrientation::applied( m_currentPixmap.copy( currentPixmapRect() ).toImage(),
+                                                               m_currentPixmapOrientation ) );
+    }
+
+    if ( m_currentPixmapRect.isNull() ) {
+        return m_currentPixmap;
+    }
+
+    // compact copy of the view, on demand only
+    return m_currentPixmap.copy( m_currentPixmapRect );
+}
+
+//---------------------------------------------------------------------------
+
+QRect QImageWidget::currentPixmapRect() const
+{
+    return m_currentPixmapRect.isNull() ? m_currentPixmap.rect() : m_currentPixmapRect;
+}
+
+//---------------------------------------------------------------------------
+
+int QImageWidget::currentPixmapOrientation() const
+{
+    return m_currentPixmapOrientation;
 }
 
 //---------------------------------------------------------------------------
@@ -489,33 +1016,85 @@ int QImageWidget::pixmapsCount() const
 void QImageWidget::updatePixmapByIndex()
 {
     m_currentPixmapPath = m_pixmapsPaths.at( m_currentPixmapIndex );
-    m_currentPixmap = QPixmap( m_currentPixmapPath );
+    m_currentPixmapRect = QRect();
+
+    // a running slideshow continues from here
+    m_slideshowIndex = m_currentPixmapIndex;
+
+    cancelDecoding();
+    if ( !m_decodeQueue->isReady( m_currentPixmapPath ) && QProgressiveDecoder::isWorthwhile( m_currentPixmapPath ) ) {
+        startProgressiveDecoding();
+        prefetchNext(); // starts once the progressive decode lets the disk go
+        return;
+    }
+
+    QImage image;
+    if ( m_decodeQueue->isReady( m_currentPixmapPath ) ) {
+        image = m_decodeQueue->image( m_currentPixmapPath );
+    } else {
+        // prefetching and thumbnails on the same disk wait for this
+        const QIoScheduler::Claim claim( QIoScheduler::globalInstance(), m_currentPixmapPath );
+        image = QImageDecoder::decode( m_currentPixmapPath );
+    }
+
+    m_currentPixmap = QPixmap::fromImage( image );
+    m_currentPixmapOrientation = QImageOrientation::of( image );
 
     updatePixmap();
+    updateAnimation();
+    prefetchNext();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::prefetchNext()
+{
+    // a running slideshow keeps its own window
+    if ( m_slideshowRunning ) {
+        return;
+    }
+
+    // going on or deleting while culling shows it without a decode
+    QStringList paths;
+    const int next = slideshowNextIndex( m_currentPixmapIndex );
+    if ( next >= 0 && next != m_currentPixmapIndex ) {
+        paths.append( m_pixmapsPaths.at( next ) );
+    }
+
+    m_decodeQueue->prefetch( paths );
 }
 
 //---------------------------------------------------------------------------
 
 void QImageWidget::updatePixmap()
 {
-    qDebug() << Q_FUNC_INFO  << trUtf8( "Update pixmap." );
+    QIW_TRACE( lcImageWidgetPixmap, "Update pixmap." );
 
     if ( m_currentPixmap.isNull() ) {
         qWarning() << Q_FUNC_INFO << trUtf8( "Null pixmap." );
         return;
     }
 
+    stopCrossfade();
     m_customGraphicsView->scene()->clear();
+    m_progressiveItem = 0;
 
-    m_graphicsPixmapItem = m_customGraphicsView->scene()->addPixmap( m_currentPixmap );
+    m_graphicsPixmapItem = new QPixmapViewItem( m_currentPixmap, m_currentPixmapRect );
     m_graphicsPixmapItem->setTransformationMode( Qt::SmoothTransformation );
+    m_graphicsPixmapItem->setTransform( QImageOrientation::transform( m_currentPixmapOrientation,
+                                                                      currentPixmapRect().size() ) );
+    m_customGraphicsView->scene()->addItem( m_graphicsPixmapItem );
 
-    m_customGraphicsView->scene()->setSceneRect( m_currentPixmap.rect() );
+    // the scene is the image as shown, upright
+    m_customGraphicsView->scene()->setSceneRect( QRectF( QPointF( 0, 0 ), currentPixmapSize() ) );
 
     fillSize();
 
-    // pixmaps signals
-    emit currentPixmapChanged( m_currentPixmap );
+    // pixmaps signals, a cropped view is only copied for receivers
+    static const QMetaMethod changedSignal = QMetaMethod::fromSignal( &QImageWidget::currentPixmapChanged );
+    if ( isSignalConnected( changedSignal ) ) {
+        emit currentPixmapChanged( currentPixmap() );
+    }
     emit currentPixmapChangedBool( true );
     emit currentPixmapPathChanged( m_currentPixmapPath );
     emit pixmapAvailable( true );
@@ -524,6 +1103,14 @@ void QImageWidget::updatePixmap()
     // false pixmap changed
     setCurrentPixmapModified( false );
 
+    updateNavigationAvailable();
+    updatePreviews();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::updateNavigationAvailable()
+{
     // check go operations enabled
     if ( m_currentPixmapIndex == 0  ) {       // if 1-st item
         if ( m_pixmapsPaths.size() > 1 ) {  // and if not the only one
@@ -550,15 +1137,6 @@ void QImageWidget::updatePixmap()
     } else {
         qWarning() << Q_FUNC_INFO << trUtf8( "The Thing That Should Not Be..." );
     }
-
-    // previews
-    if ( m_pixmapsPathsBefore != m_pixmapsPaths ) {
-        m_pixmapsPathsBefore = m_pixmapsPaths;
-
-        //        createPreviews();
-        m_previewThread->setPreviewsList( m_pixmapsPaths );
-        m_previewThread->start();
-    }
 }
 
 //---------------------------------------------------------------------------
@@ -604,7 +1182,7 @@ void QImageWidget::goFirst()
     if ( m_previewVisible ) {
         m_previewWidget->setCurrentRow( m_currentPixmapIndex );
     } else {
-        updatePixmapByIndex();
+        navigateToIndex();
     }
 }
 
@@ -636,7 +1214,7 @@ void QImageWidget::goPrevious()
     if ( m_previewVisible ) {
         m_previewWidget->setCurrentRow( m_currentPixmapIndex );
     } else {
-        updatePixmapByIndex();
+        navigateToIndex();
     }
 }
 
@@ -668,7 +1246,7 @@ void QImageWidget::goNext()
     if ( m_previewVisible ) {
         m_previewWidget->setCurrentRow( m_currentPixmapIndex );
     } else {
-        updatePixmapByIndex();
+        navigateToIndex();
     }
 }
 
@@ -685,7 +1263,7 @@ void QImageWidget::goLast()
     if ( m_previewVisible ) {
         m_previewWidget->setCurrentRow( m_currentPixmapIndex );
     } else {
-        updatePixmapByIndex();
+        navigateToIndex();
     }
 }
 //! [3]
@@ -765,7 +1343,7 @@ void QImageWidget::resizeEvent( QResizeEvent *event )
 
 void QImageWidget::timerEvent( QTimerEvent *event )
 {
-    qDebug() << Q_FUNC_INFO <<  trUtf8( "Fill size." );
+    QIW_TRACE( lcImageWidgetView, "Fill size." );
     fillSize();
 
     killTimer( m_timerId );
@@ -804,7 +1382,7 @@ void QImageWidget::mouseDoubleClickEvent( QMouseEvent *event )
 //! [5]
 void QImageWidget::copy()
 {
-    QApplication::clipboard()->setPixmap( m_currentPixmap );
+    QApplication::clipboard()->setPixmap( currentPixmap() );
 }
 
 //---------------------------------------------------------------------------
@@ -824,6 +1402,8 @@ void QImageWidget::paste()
 {
     QUndoCommand *pasteCommand = new QPasteCommand( this,
                                                     m_currentPixmap,
+                                                    m_currentPixmapRect,
+                                                    m_currentPixmapOrientation,
                                                     QApplication::clipboard()->pixmap() );
     m_undoStack->push( pasteCommand );
 
@@ -878,6 +1458,7 @@ void QImageWidget::setUndoRedoAvailable()
 {
     emit undoAvailable( m_undoStack->canUndo() );
     emit redoAvailable( m_undoStack->canRedo() );
+    m_undoMemory->changed();
 
     setCurrentPixmapModified( m_undoStack->canUndo() );
 }
@@ -890,6 +1471,8 @@ void QImageWidget::rotateLeft()
 {
     QUndoCommand *rotateCommand = new QRotateCommand( this,
                                                       m_currentPixmap,
+                                                      m_currentPixmapRect,
+                                                      m_currentPixmapOrientation,
                                                       QRotateCommand::Left );
     m_undoStack->push( rotateCommand );
 
@@ -902,6 +1485,8 @@ void QImageWidget::rotateRight()
 {
     QUndoCommand *rotateCommand = new QRotateCommand( this,
                                                       m_currentPixmap,
+                                                      m_currentPixmapRect,
+                                                      m_currentPixmapOrientation,
                                                       QRotateCommand::Right );
     m_undoStack->push( rotateCommand );
 
@@ -910,7 +1495,7 @@ void QImageWidget::rotateRight()
 
 void QImageWidget::setCurrentPixmapModified( const bool &changed )
 {
-    qDebug() << Q_FUNC_INFO  << trUtf8( "Pixmap changed: " ) << changed;
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Pixmap changed:", changed );
     m_isCurrentPixmapModified = changed;
     emit currentPixmapModified( m_isCurrentPixmapModified );
 }
@@ -924,7 +1509,7 @@ void QImageWidget::crop()
         return;
     }
 
-    qDebug() << Q_FUNC_INFO  << trUtf8( "Start cropping.");
+    QIW_TRACE( lcImageWidgetEdit, "Start cropping." );
 
     m_customGraphicsView->startSelection();
 }
@@ -933,13 +1518,18 @@ void QImageWidget::crop()
 
 void QImageWidget::getSelection( const QRect &rect )
 {
-    qDebug() << Q_FUNC_INFO  << trUtf8( "Cropped." );
+    QIW_TRACE( lcImageWidgetEdit, "Cropped." );
 
     emit cropped( true );
 
+    // the selection is in the upright scene, the crop in stored pixels
+    const QRect pixmapRect = m_graphicsPixmapItem->mapFromScene( QRectF( rect ) ).boundingRect().toAlignedRect();
+
     QUndoCommand *cropCommand = new QCropCommand( this,
                                                   m_currentPixmap,
-                                                  m_currentPixmap.copy( rect ) );
+                                                  m_currentPixmapRect,
+                                                  m_currentPixmapOrientation,
+                                                  pixmapRect );
     m_undoStack->push( cropCommand );
 
     setUndoRedoAvailable();
@@ -949,58 +1539,164 @@ void QImageWidget::getSelection( const QRect &rect )
 
 void QImageWidget::remove()
 {
-    if ( m_currentPixmapPath.isEmpty() ) {
+    const QStringList paths = selectedPaths();
+    if ( paths.isEmpty() ) {
         qWarning() << Q_FUNC_INFO << trUtf8( "No image or wrong path." );
         return;
     }
 
+    // one question for the whole selection
     if ( m_showRemoveDialog ) {
+        const QString question = paths.size() == 1
+                                 ? trUtf8( "Do you realy wanna delete this file?" )
+                                 : trUtf8( "Do you realy wanna delete %1 files?" ).arg( paths.size() );
         QMessageBox::StandardButtons button =  QMessageBox::question(this,
                                                                      trUtf8( "Delete" ),
-                                                                     trUtf8( "Do you realy wanna delete this file?" ),
+                                                                     question,
                                                                      QMessageBox::Cancel | QMessageBox::Apply );
-        if ( button == QMessageBox::Cancel ) {
+        if ( button != QMessageBox::Apply ) {
             return;
-        } else if ( button == QMessageBox::Apply ) {
-            deleteImage( m_currentPixmapPath );
         }
-    } else {
-        deleteImage( m_currentPixmapPath );
     }
 
-    if ( m_pixmapsPaths.size() == 0 ) {
-        m_currentPixmap = QPixmap();
-        m_currentPixmapPath = QString();
-
-        m_currentPixmapIndex = 0;
-        m_customGraphicsView->scene()->clear();
-
-        emit currentPixmapChanged( QPixmap() );
-        emit currentPixmapChangedBool( true );
-        emit currentPixmapPathChanged( QString() );
-        emit pixmapAvailable( false );
-    }
+    removePaths( paths );
 }
 
 //---------------------------------------------------------------------------
 
-void QImageWidget::deleteImage( const QString &path )
+void QImageWidget::removePaths( const QStringList &paths )
 {
-    QFile::remove( path );
-    m_pixmapsPaths.removeAt( m_currentPixmapIndex );
-    // make this for do not update previews
-    m_pixmapsPathsBefore = m_pixmapsPaths;
-
-    // remove item from preview widget
-    m_previewWidget->takeItem( m_currentPixmapIndex );
-    if ( m_currentPixmapIndex >= 1 ) {
-        goPrevious();
-        m_previewWidget->currentRowChanged( m_currentPixmapIndex );
+    QSet < QString > removed;
+    QList < int > rows;
+    foreach ( const QString &path, paths ) {
+        const int index = m_pixmapsPaths.indexOf( path );
+        if ( index >= 0 && !removed.contains( path ) ) {
+            removed.insert( path );
+            rows.append( index );
+        }
+    }
+
+    if ( removed.isEmpty() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No image or wrong path." );
+        return;
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Remove, files:", removed.size() );
+
+    // the image shown after: the first one left after the current, else before
+    QString next;
+    if ( !removed.contains( m_currentPixmapPath ) ) {
+        next = m_currentPixmapPath;
+    } else {
+        for ( int i = m_currentPixmapIndex + 1; i < m_pixmapsPaths.size() && next.isEmpty(); ++i ) {
+            if ( !removed.contains( m_pixmapsPaths.at( i ) ) ) {
+                next = m_pixmapsPaths.at( i );
+            }
+        }
+        for ( int i = qMin( m_currentPixmapIndex, m_pixmapsPaths.size() ) - 1; i >= 0 && next.isEmpty(); --i ) {
+            if ( !removed.contains( m_pixmapsPaths.at( i ) ) ) {
+                next = m_pixmapsPaths.at( i );
+            }
+        }
+    }
+
+    // the list in one pass, not one shift per file
+    const auto kept = [ &removed ] ( const QStringList &list ) {
+        QStringList result;
+        result.reserve( list.size() );
+        foreach ( const QString &path, list ) {
+            if ( !removed.contains( path ) ) {
+                result.append( path );
+            }
+        }
+        return result;
+    };
+
+    m_pixmapsPaths.removeAll( removed );
+    m_sourcePaths = kept( m_sourcePaths );
+    m_sortFilterResult.sorted = kept( m_sortFilterResult.sorted );
+    m_sortFilterResult.paths = kept( m_sortFilterResult.paths );
+    foreach ( const QString &path, removed ) {
+        m_metadataCache.remove( path );
+        m_imageCache.remove( path );
+    }
+
+    // a sort still running would bring them back
+    if ( m_sortFilterWatcher->isRunning() ) {
+        applySortFilter();
+    }
+
+    // previews of the others stay, unless they are still being built
+    if ( m_previewLoader->isRunning() ) {
+        m_previewsGeneration = 0;
+    } else {
+        std::sort( rows.begin(), rows.end(), std::greater < int > () );
+
+        m_previewWidget->setUpdatesEnabled( false );
+        m_previewWidget->blockSignals( true );
+        foreach ( const int &row, rows ) {
+            m_previewMemory->removed( previewPixmap( row ) );
+            delete m_previewWidget->takeItem( row );
+        }
+        m_previewWidget->blockSignals( false );
+        m_previewWidget->setUpdatesEnabled( true );
+
+        m_previewsGeneration = m_pixmapsPaths.generation();
+    }
+
+    m_removeQueue.append( removed.toList() );
+    startRemoving();
+
+    if ( next.isEmpty() ) {
+        clearPixmap();
+        updateNavigationAvailable();
+        return;
+    }
+
+    m_currentPixmapIndex = m_pixmapsPaths.indexOf( next );
+    if ( m_previewVisible ) {
+        m_previewWidget->blockSignals( true );
+        m_previewWidget->setCurrentRow( m_currentPixmapIndex );
+        m_previewWidget->blockSignals( false );
+    }
+
+    if ( next == m_currentPixmapPath ) {
+        m_slideshowIndex = m_currentPixmapIndex;
+        updateNavigationAvailable();
+        updatePreviews();
+        prefetchNext();
+    } else {
+        updatePixmapByIndex(); // prefetched if culling went forward
     }
 }
 
 //---------------------------------------------------------------------------
 
+void QImageWidget::clearPixmap()
+{
+    m_animationPlayer->stop();
+    cancelDecoding();
+
+    m_currentPixmap = QPixmap();
+    m_currentPixmapRect = QRect();
+    m_currentPixmapOrientation = QImageOrientation::Normal;
+    m_currentPixmapPath = QString();
+
+    m_currentPixmapIndex = 0;
+    m_navigationSettling = false;
+    stopCrossfade();
+    m_customGraphicsView->scene()->clear();
+    m_graphicsPixmapItem = 0;
+    m_progressiveItem = 0;
+
+    emit currentPixmapChanged( QPixmap() );
+    emit currentPixmapChangedBool( true );
+    emit currentPixmapPathChanged( QString() );
+    emit pixmapAvailable( false );
+}
+
+//---------------------------------------------------------------------------
+
 void QImageWidget::setShowRemoveDialog( const bool &show )
 {
     m_showRemoveDialog = show;
@@ -1015,6 +1711,86 @@ bool QImageWidget::showRemoveDialog() const
 
 //---------------------------------------------------------------------------
 
+void QImageWidget::setMoveToTrash( const bool &toTrash )
+{
+    m_moveToTrash = toTrash;
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageWidget::moveToTrash() const
+{
+    return m_moveToTrash;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setExportSettings( const QImageExporter::Settings &settings )
+{
+    m_exportSettings = settings;
+}
+
+//---------------------------------------------------------------------------
+
+QImageExporter::Settings QImageWidget::exportSettings() const
+{
+    return m_exportSettings;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::startRemoving()
+{
+    // batches asked for meanwhile go together after this one
+    if ( m_removeWatcher->isRunning() || m_removeQueue.isEmpty() ) {
+        return;
+    }
+
+    const QStringList paths = m_removeQueue;
+    const bool toTrash = m_moveToTrash;
+    m_removeQueue.clear();
+
+    m_removeWatcher->setFuture( QtConcurrent::run( [ paths, toTrash ] () {
+        return QFileRemover::remove( paths, toTrash );
+    } ) );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::removeFinished()
+{
+    const QFileRemover::Result result = m_removeWatcher->result();
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Removed files:", result.removed.size() );
+
+    // still there, show them again
+    if ( !result.failed.isEmpty() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "Cannot remove" ) << result.failed;
+
+        const bool wasEmpty = m_pixmapsPaths.isEmpty();
+        foreach ( const QString &path, result.failed ) {
+            m_sourcePaths.append( path );
+            m_pixmapsPaths.append( path );
+        }
+        m_sortFilterResult = QImageSortFilter::Result();
+        applySortFilter();
+
+        if ( wasEmpty ) {
+            m_currentPixmapIndex = 0;
+            updatePixmapByIndex();
+        } else {
+            updateNavigationAvailable();
+            updatePreviews();
+        }
+    }
+
+    emit filesRemoved( result.removed, result.failed );
+
+    startRemoving();
+}
+
+//---------------------------------------------------------------------------
+
 bool QImageWidget::setAsWallpaper()
 {
     if ( m_currentPixmapPath.isNull() ) {
@@ -1051,7 +1827,11 @@ bool QImageWidget::save()
         return false;
     }
 
-    if ( m_currentPixmap.save( m_currentPixmapPath ) ) {
+    QImageExporter::Settings settings = m_exportSettings;
+    settings.format = QImageExporter::formatOf( m_currentPixmapPath );
+    if ( QImageExporter::write( currentPixmap().toImage(), m_currentPixmapPath, settings ).written ) {
+        m_metadataCache.remove( m_currentPixmapPath );
+        m_imageCache.remove( m_currentPixmapPath );
         setCurrentPixmapModified( false );
         m_undoStack->clear();
         setUndoRedoAvailable();
@@ -1075,11 +1855,15 @@ bool QImageWidget::saveAs()
     }
 
     m_currentPixmapPath = m_newPath;
-    if ( m_currentPixmap.save( m_newPath ) ) {
+    QImageExporter::Settings settings = m_exportSettings;
+    settings.format = QImageExporter::formatOf( m_newPath );
+    if ( QImageExporter::write( currentPixmap().toImage(), m_newPath, settings ).written ) {
         setCurrentPixmapModified( false );
         m_undoStack->clear();
         setUndoRedoAvailable();
         m_currentPixmap = QPixmap( m_newPath );
+        m_currentPixmapRect = QRect();
+        m_currentPixmapOrientation = QImageOrientation::Normal; // written upright
         updatePixmap();
         return true;
     }
@@ -1112,9 +1896,62 @@ bool QImageWidget::previewVisible() const
 
 //---------------------------------------------------------------------------
 
+QStringList QImageWidget::selectedPaths() const
+{
+    QList < int > rows;
+    if ( m_previewVisible ) {
+        foreach ( const QModelIndex &index, m_previewWidget->selectionModel()->selectedRows() ) {
+            if ( index.row() < m_pixmapsPaths.size() ) {
+                rows.append( index.row() );
+            }
+        }
+        std::sort( rows.begin(), rows.end() );
+    }
+
+    QStringList paths;
+    foreach ( const int &row, rows ) {
+        paths.append( m_pixmapsPaths.at( row ) );
+    }
+
+    if ( paths.isEmpty() && gotPath() ) {
+        paths.append( m_currentPixmapPath );
+    }
+
+    return paths;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setSelectedPaths( const QStringList &paths )
+{
+    m_previewWidget->clearSelection();
+    foreach ( const QString &path, paths ) {
+        QListWidgetItem *item = m_previewWidget->item( m_pixmapsPaths.indexOf( path ) );
+        if ( item ) {
+            item->setSelected( true );
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::selectAllPreviews()
+{
+    m_previewWidget->selectAll();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::clearPreviewSelection()
+{
+    m_previewWidget->clearSelection();
+}
+
+//---------------------------------------------------------------------------
+
 void QImageWidget::updatePreviewsForCurrentDirectory()
 {
-    m_pixmapsPathsBefore.clear();
+    m_previewsGeneration = 0;
     setPixmapsDirectory( QFileInfo( m_currentPixmapPath ).absolutePath() );
 }
 
@@ -1122,7 +1959,7 @@ void QImageWidget::updatePreviewsForCurrentDirectory()
 
 void QImageWidget::updatePreviewForStartingDirectory()
 {
-    m_pixmapsPathsBefore.clear();
+    m_previewsGeneration = 0;
     setPixmapsDirectory( m_startedDirectoryPath );
 }
 
@@ -1143,6 +1980,36 @@ QSize QImageWidget::previewPixmapSize() const
 
 //---------------------------------------------------------------------------
 
+void QImageWidget::updatePreviews()
+{
+    // previews follow the sorted order, wait for it
+    if ( m_sortFilterWatcher->isRunning() && !m_sortFilterWatcher->isCanceled() ) {
+        return;
+    }
+
+    if ( m_previewsGeneration != m_pixmapsPaths.generation() ) {
+        m_previewsGeneration = m_pixmapsPaths.generation();
+
+        // every row at once, the previews fill in as they are made
+        const QStringList paths = m_pixmapsPaths.paths();
+        m_previewLoader->cancel();
+        m_previewWidget->setUpdatesEnabled( false );
+        m_previewWidget->clear();
+        m_previewMemory->clear();
+        foreach ( const QString &path, paths ) {
+            appendPreviewItem( path );
+        }
+        m_previewWidget->setUpdatesEnabled( true );
+
+        // the rows in view go first
+        const int first = qMax( 0, m_previewWidget->indexAt( m_previewWidget->viewport()->rect().topLeft() ).row() );
+        const int last = m_previewWidget->indexAt( m_previewWidget->viewport()->rect().bottomLeft() ).row();
+        m_previewLoader->start( paths, m_previewPixmapSize, first, last < 0 ? paths.size() - 1 : last );
+    }
+}
+
+//---------------------------------------------------------------------------
+
 void QImageWidget::currentPreviewChanged( const int &index )
 {
     if ( index < 0 ) {
@@ -1154,7 +2021,7 @@ void QImageWidget::currentPreviewChanged( const int &index )
         m_currentPixmapIndex = index;
     }
 
-    updatePixmapByIndex();
+    navigateToIndex();
 }
 
 //! [8]
@@ -1169,15 +2036,19 @@ void QImageWidget::showInfomarion()
         return;
     }
 
+    // one cache lookup for all the fields
+    const QImageMetadata metadata = m_metadataCache.metadata( m_currentPixmapPath,
+                                                              QImageMetadata::FileInfo );
+
     QString f_color = "green";
     QString styled = trUtf8( "<font color=%1><b>%2</b></font>%3<br>");
     m_infoBox->setWindowTitle( currentPixmapFileName() );
     m_infoBox->setText( styled.arg( f_color, trUtf8( "Path: " ), currentPixmapPath() ) +
                         styled.arg( f_color, trUtf8( "File name: " ), currentPixmapFileName() ) +
-                        styled.arg( f_color, trUtf8( "Created: " ), currentPixmapCreated() ) +
-                        styled.arg( f_color, trUtf8( "<b>Last modified: </b>"), currentPixmapLastModified() ) +
+                        styled.arg( f_color, trUtf8( "Created: " ), metadata.created.toString( "dd MMMM yyyy" ) ) +
+                        styled.arg( f_color, trUtf8( "<b>Last modified: </b>"), metadata.lastModified.toString( "dd MMMM yyyy" ) ) +
                         styled.arg( f_color, trUtf8( "<b>Type: </b>" ), currentPixmapType() ) +
-                        styled.arg( f_color, trUtf8( "<b>Size: </b>" ), QString::number( currentPixmapSizeMB() ) + trUtf8( " MB" ) ) +
+                        styled.arg( f_color, trUtf8( "<b>Size: </b>" ), QString::number( metadata.fileSize / ( 1024 * 1024 ) ) + trUtf8( " MB" ) ) +
                         styled.arg( f_color, trUtf8( "<b>Resolution: </b>" ), QString::number( currentPixmapWidth() ) +
                                     " : " + QString::number( currentPixmapHeight() ) ) );
     m_infoBox->show();
@@ -1212,14 +2083,25 @@ void QImageWidget::contextMenuEvent( QContextMenuEvent *event )
 
 //---------------------------------------------------------------------------
 
-//! [11]
-void QImageWidget::appendNewPreview( const QString &path, QPixmap pixmap, const int &index )
+//! [12]
+QString QImageWidget::recentEvents()
 {
-    // check if update previews
-    if ( index == 0 ) {
-        m_previewWidget->clear();
-    }
+    return QImageWidgetTrace::dump();
+}
+
+//---------------------------------------------------------------------------
+
+QString QImageWidget::pixelKernelPath()
+{
+    return QPixelKernels::pathName( QPixelKernels::activePath() );
+}
+//! [12]
+
+//---------------------------------------------------------------------------
 
+//! [11]
+void QImageWidget::appendPreviewItem( const QString &path )
+{
     // create new list item widget and widgets with name and preview
     QListWidgetItem *m_listWidgetItem = new QListWidgetItem( m_previewWidget  );
     QWidget *m_listWidgetItemWidget = new QWidget( this ); // crazy name?
@@ -1227,14 +2109,13 @@ void QImageWidget::appendNewPreview( const QString &path, QPixmap pixmap, const
     m_listWidgetItemWidget->setLayout( m_listWidgetItemLayout );
     QLabel *m_previewName = new QLabel( QFileInfo( path ).fileName(), this );
     QLabel *m_previewIcon = new QLabel( this );
+    m_previewIcon->setObjectName( "preview" );
+    m_previewIcon->setFixedSize( m_previewPixmapSize );
 
     QFont m_previewNameFont = m_previewName->font();
     m_previewNameFont.setPointSize( 7 );
     m_previewName->setFont( m_previewNameFont );
 
-    m_previewIcon->setPixmap( pixmap.scaled( m_previewPixmapSize,
-                                             Qt::KeepAspectRatioByExpanding,
-                                             Qt::SmoothTransformation ) );
     m_listWidgetItem->setSizeHint( QSize ( m_previewPixmapSize.width() + 10,
                                            m_previewPixmapSize.height() + 20 ) );
 
@@ -1243,12 +2124,1087 @@ void QImageWidget::appendNewPreview( const QString &path, QPixmap pixmap, const
 
     m_previewWidget->addItem( m_listWidgetItem );
     m_previewWidget->setItemWidget( m_listWidgetItem, m_listWidgetItemWidget );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::previewReady( const int &row, const QString &path, const QImage &preview )
+{
+    Q_UNUSED( path ); // the loader keeps rows and paths in step
 
-    // check if last preview. we have to stop
-    if ( m_pixmapsPaths.size() - 1 == index ) {
-        m_previewThread->exit();
+    QListWidgetItem *item = m_previewWidget->item( row );
+    QWidget *widget = item ? m_previewWidget->itemWidget( item ) : 0;
+    QLabel *icon = widget ? widget->findChild < QLabel * > ( "preview" ) : 0;
+    if ( !icon ) {
+        QIW_TRACE_VALUE( lcImageWidgetView, "Preview without a row:", row );
+        return;
+    }
+
+    const QPixmap pixmap = QPixmap::fromImage( preview );
+    icon->setPixmap( pixmap );
+    m_previewMemory->added( pixmap );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::updateVisiblePreviews()
+{
+    if ( !m_previewLoader->isRunning() ) {
+        return;
     }
+
+    // pending previews scrolled into view go before the others
+    const QRect rect = m_previewWidget->viewport()->rect();
+    const int first = qMax( 0, m_previewWidget->indexAt( rect.topLeft() ).row() );
+    const int last = m_previewWidget->indexAt( rect.bottomLeft() ).row();
+    m_previewLoader->setVisibleRows( first, last < 0 ? m_previewWidget->count() - 1 : last );
 }
 //! [11]
 
 //---------------------------------------------------------------------------
+
+//! [13]
+void QImageWidget::findDuplicates( const int &maxDistance )
+{
+    if ( !gotPaths() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No files." );
+        return;
+    }
+
+    if ( m_duplicatesWatcher->isRunning() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "Already searching." );
+        return;
+    }
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Find duplicates, images:", m_pixmapsPaths.size() );
+
+    const QStringList paths = m_pixmapsPaths.paths();
+    QPerceptualHashIndex *index = &m_perceptualHashIndex;
+
+    m_duplicatesWatcher->setFuture( QtConcurrent::run( [ paths, index, maxDistance ] () {
+        index->update( paths );
+        index->save();
+        return index->groups( paths, maxDistance );
+    } ) );
+}
+
+//---------------------------------------------------------------------------
+
+QList < QStringList > QImageWidget::duplicateGroups() const
+{
+    return m_duplicateGroups;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::showDuplicates()
+{
+    QStringList paths;
+    foreach ( const QStringList &group, m_duplicateGroups ) {
+        paths.append( group );
+    }
+
+    if ( paths.isEmpty() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No duplicates." );
+        return;
+    }
+
+    // keep the group order, it is what makes neighbours duplicates
+    setSourcePaths( paths );
+    m_sortFilterWatcher->cancel();
+    m_sortFilterResult.settings = m_sortFilterSettings;
+    m_sortFilterResult.sorted = paths;
+    m_sortFilterResult.paths = paths;
+
+    m_currentPixmapIndex = 0;
+    updatePixmapByIndex();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::duplicatesFinished()
+{
+    m_duplicateGroups = m_duplicatesWatcher->result();
+
+    QIW_TRACE_VALUE( lcImageWidgetPixmap, "Duplicate groups:", m_duplicateGroups.size() );
+    emit duplicatesFound( m_duplicateGroups );
+}
+//! [13]
+
+//---------------------------------------------------------------------------
+
+//! [14]
+void QImageWidget::startSlideshow()
+{
+    if ( !gotPaths() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No files." );
+        return;
+    }
+
+    if ( m_slideshowRunning ) {
+        return;
+    }
+
+    m_slideshowRunning = true;
+    m_slideshowIndex = m_currentPixmapIndex;
+    m_slideshowWaitingIndex = -1;
+
+    // deadlines are absolute, timer jitter does not accumulate
+    m_slideshowClock.start();
+    m_slideshowDeadline = m_slideshowInterval;
+
+    slideshowPrefetch();
+    scheduleSlideshowTick();
+
+    emit slideshowRunningChanged( true );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::stopSlideshow()
+{
+    if ( !m_slideshowRunning ) {
+        return;
+    }
+
+    m_slideshowRunning = false;
+    m_slideshowWaitingIndex = -1;
+    m_slideshowTimer->stop();
+    m_decodeQueue->clear();
+
+    emit slideshowRunningChanged( false );
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageWidget::isSlideshowRunning() const
+{
+    return m_slideshowRunning;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setSlideshowInterval( const int &msec )
+{
+    m_slideshowInterval = qMax( 1, msec );
+}
+
+//---------------------------------------------------------------------------
+
+int QImageWidget::slideshowInterval() const
+{
+    return m_slideshowInterval;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setSlideshowPolicy( const SlideshowPolicy &policy )
+{
+    m_slideshowPolicy = policy;
+}
+
+//---------------------------------------------------------------------------
+
+QImageWidget::SlideshowPolicy QImageWidget::slideshowPolicy() const
+{
+    return m_slideshowPolicy;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::setSlideshowCrossfade( const int &msec )
+{
+    m_slideshowCrossfade = qMax( 0, msec );
+}
+
+//---------------------------------------------------------------------------
+
+int QImageWidget::slideshowCrossfade() const
+{
+    return m_slideshowCrossfade;
+}
+
+//---------------------------------------------------------------------------
+
+int QImageWidget::slideshowNextIndex( const int &index ) const
+{
+    if ( index + 1 < m_pixmapsPaths.size() ) {
+        return index + 1;
+    }
+
+    return m_endlessScrollEnabled ? 0 : -1;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::slideshowPrefetch()
+{
+    // enough images in flight to cover one decode, plus a spare
+    const int depth = qBound( 2,
+                              int( std::ceil( m_decodeQueue->averageDecodeTime() / m_slideshowInterval ) ) + 2,
+                              16 );
+
+    QStringList paths;
+    int index = m_slideshowIndex;
+    for ( int i = 0; i < depth; ++i ) {
+        index = slideshowNextIndex( index );
+        if ( index < 0 || index == m_slideshowIndex ) {
+            break;
+        }
+        paths.append( m_pixmapsPaths.at( index ) );
+    }
+
+    m_decodeQueue->prefetch( paths );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::scheduleSlideshowTick()
+{
+    m_slideshowTimer->start( int( qMax < qint64 > ( 0, m_slideshowDeadline - m_slideshowClock.elapsed() ) ) );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::slideshowTick()
+{
+    const qint64 now = m_slideshowClock.elapsed();
+
+    // a decode hanging on a slow disk or share, go on without it
+    if ( m_slideshowWaitingIndex >= 0 ) {
+        QIW_TRACE_VALUE( lcImageWidgetView, "Slideshow gave up on image:", m_slideshowWaitingIndex );
+        emit slideshowDeadlineMissed( m_slideshowWaitingIndex, now - m_slideshowDeadline );
+
+        m_slideshowIndex = m_slideshowWaitingIndex;
+        m_slideshowWaitingIndex = -1;
+        m_slideshowDeadline = now;
+    }
+
+    const int next = slideshowNextIndex( m_slideshowIndex );
+    if ( next < 0 ) {
+        stopSlideshow();
+        return;
+    }
+
+    const QString path = m_pixmapsPaths.at( next );
+
+    if ( m_decodeQueue->isReady( path ) ) {
+        showDecodedPixmap( next, m_decodeQueue->image( path ) );
+
+        m_slideshowDeadline += m_slideshowInterval;
+        if ( m_slideshowDeadline < now ) { // stalled, do not burst to catch up
+            m_slideshowDeadline = now + m_slideshowInterval;
+        }
+    } else if ( m_slideshowPolicy == SkipLate ) {
+        QIW_TRACE_VALUE( lcImageWidgetView, "Slideshow dropped late image:", next );
+        emit slideshowDeadlineMissed( next, now - m_slideshowDeadline );
+
+        m_slideshowIndex = next;
+        m_slideshowDeadline += m_slideshowInterval;
+    } else {
+        // slideshowDecoded() shows it, or skips it when the decode failed
+        // or was dropped; the timer gives up on one that never ends
+        m_slideshowWaitingIndex = next;
+        slideshowPrefetch();
+        m_decodeQueue->prioritize( path );
+        m_slideshowTimer->start( qMax( int( SlideshowWaitLimit ), m_slideshowInterval ) );
+        return;
+    }
+
+    slideshowPrefetch();
+    scheduleSlideshowTick();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::slideshowDecoded( const QString &path )
+{
+    if ( !m_slideshowRunning || m_slideshowWaitingIndex < 0
+         || m_slideshowWaitingIndex >= m_pixmapsPaths.size()
+         || m_pixmapsPaths.at( m_slideshowWaitingIndex ) != path ) {
+        return;
+    }
+
+    // dropped, then asked for again before this was delivered
+    if ( m_decodeQueue->isPending( path ) ) {
+        return;
+    }
+
+    const int index = m_slideshowWaitingIndex;
+    const qint64 now = m_slideshowClock.elapsed();
+    m_slideshowWaitingIndex = -1;
+
+    if ( m_decodeQueue->isReady( path ) ) {
+        QIW_TRACE_VALUE( lcImageWidgetView, "Slideshow late by ms:", now - m_slideshowDeadline );
+        emit slideshowDeadlineMissed( index, now - m_slideshowDeadline );
+        showDecodedPixmap( index, m_decodeQueue->image( path ) );
+    } else {
+        m_slideshowIndex = index; // cannot be decoded, skip it
+    }
+
+    // restart the schedule from the late image
+    m_slideshowDeadline = now + m_slideshowInterval;
+    slideshowPrefetch();
+    scheduleSlideshowTick();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::showDecodedPixmap( const int &index, const QImage &image )
+{
+    cancelDecoding();
+
+    // the view of the previous image, so fading it out copies nothing
+    const QPixmap previous = m_currentPixmap;
+    const QRect previousRect = currentPixmapRect();
+    const int previousOrientation = m_currentPixmapOrientation;
+
+    m_currentPixmapIndex = index;
+    m_slideshowIndex = index;
+    m_currentPixmapPath = m_pixmapsPaths.at( index );
+    m_currentPixmap = QPixmap::fromImage( image );
+    m_currentPixmapRect = QRect();
+    m_currentPixmapOrientation = QImageOrientation::of( image );
+
+    updatePixmap();
+    updateAnimation();
+
+    // the preview row would decode the image again
+    if ( m_previewVisible ) {
+        m_previewWidget->blockSignals( true );
+        m_previewWidget->setCurrentRow( index );
+        m_previewWidget->blockSignals( false );
+    }
+
+    if ( m_slideshowCrossfade > 0 && !previous.isNull() ) {
+        startCrossfade( previous, previousRect, previousOrientation );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::startCrossfade( const QPixmap &previous, const QRect &rect, const int &orientation )
+{
+    // previous image on top, fitted into the new scene rect, fading out
+    const QRectF target = m_customGraphicsView->scene()->sceneRect();
+    const QSize size = QImageOrientation::orientedSize( rect.size(), orientation );
+    const qreal scale = qMin( target.width() / size.width(),
+                              target.height() / size.height() );
+
+    m_crossfadeItem = new QPixmapViewItem( previous, rect );
+    m_crossfadeItem->setTransformationMode( Qt::SmoothTransformation );
+    m_crossfadeItem->setTransform( QImageOrientation::transform( orientation, rect.size() ) );
+    m_crossfadeItem->setScale( scale );
+    m_crossfadeItem->setPos( target.center() - QPointF( size.width(), size.height() ) * scale / 2 );
+    m_customGraphicsView->scene()->addItem( m_crossfadeItem );
+
+    m_crossfadeAnimation->setDuration( qMin( m_slideshowCrossfade, m_slideshowInterval ) );
+    m_crossfadeAnimation->start();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::stopCrossfade()
+{
+    m_crossfadeAnimation->stop();
+    crossfadeFinished();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::crossfadeFinished()
+{
+    if ( m_crossfadeItem ) {
+        m_customGraphicsView->scene()->removeItem( m_crossfadeItem );
+        delete m_crossfadeItem;
+        m_crossfadeItem = 0;
+    }
+}
+//! [14]
+
+//---------------------------------------------------------------------------
+
+//! [15]
+bool QImageWidget::isCurrentPixmapAnimated() const
+{
+    return m_animationPlayer->isRunning();
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageWidget::isAnimationPaused() const
+{
+    return m_animationPlayer->isPaused();
+}
+
+//---------------------------------------------------------------------------
+
+int QImageWidget::animationFrameCount() const
+{
+    return m_animationPlayer->frameCount();
+}
+
+//---------------------------------------------------------------------------
+
+int QImageWidget::animationCurrentFrame() const
+{
+    return m_animationPlayer->currentFrame();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::pauseAnimation()
+{
+    m_animationPlayer->pause();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::resumeAnimation()
+{
+    m_animationPlayer->resume();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::seekAnimation( const int &frame )
+{
+    m_animationPlayer->seek( frame );
+}
+
+//---------------------------------------------------------------------------
+
+//! [16]
+void QImageWidget::compare( const QStringList &paths )
+{
+    if ( paths.size() < 2 ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "Need at least two images to compare." );
+        return;
+    }
+
+    stopSlideshow();
+    m_animationPlayer->pause();
+
+    m_comparisonWidget->setPaths( paths );
+
+    if ( !isComparing() ) {
+        m_customGraphicsView->setVisible( false );
+        m_comparisonWidget->setVisible( true );
+        emit comparingChanged( true );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::compareWithCurrent( const QString &path )
+{
+    if ( !gotPath() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No current image." );
+        return;
+    }
+
+    compare( QStringList() << m_currentPixmapPath << path );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::stopComparison()
+{
+    if ( !isComparing() ) {
+        return;
+    }
+
+    m_comparisonWidget->clear();
+    m_comparisonWidget->setVisible( false );
+    m_customGraphicsView->setVisible( true );
+    m_animationPlayer->resume();
+
+    emit comparingChanged( false );
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageWidget::isComparing() const
+{
+    return !m_comparisonWidget->isHidden();
+}
+//! [16]
+
+//---------------------------------------------------------------------------
+
+//! [17]
+QImageStatistics QImageWidget::currentPixmapStatistics()
+{
+    if ( !gotPixmap() ) {
+        return QImageStatistics();
+    }
+
+    return m_statisticsCache.statistics( m_currentPixmap, m_currentPixmapRect );
+}
+
+//---------------------------------------------------------------------------
+
+QImageStatistics QImageWidget::visiblePixmapStatistics()
+{
+    if ( !gotPixmap() ) {
+        return QImageStatistics();
+    }
+
+    const QRectF visibleScene = m_customGraphicsView->visibleSceneRect();
+    const QRect shown = currentPixmapRect();
+    const QRect visible = m_graphicsPixmapItem->mapFromScene( visibleScene ).boundingRect().toAlignedRect()
+                          .translated( shown.topLeft() ) & shown;
+
+    if ( visible == shown ) {
+        return currentPixmapStatistics();
+    }
+
+    // the visible tiles change with every scroll, not worth caching
+    return QImageStatistics::compute( m_currentPixmap.toImage(), visible );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::showAnalysis()
+{
+    if ( !gotPixmap() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No pixmap." );
+        return;
+    }
+
+    const QImageStatistics statistics = visiblePixmapStatistics();
+
+    const QString names[] = { trUtf8( "Red: " ), trUtf8( "Green: " ), trUtf8( "Blue: " ), trUtf8( "Alpha: " ) };
+    QString f_color = "green";
+    QString styled = trUtf8( "<font color=%1><b>%2</b></font>%3<br>");
+    QString text = styled.arg( f_color, trUtf8( "Pixels: " ), QString::number( statistics.pixelCount() ) );
+    for ( int channel = QImageStatistics::Red; channel <= QImageStatistics::Alpha; ++channel ) {
+        const QImageStatistics::Channel c = QImageStatistics::Channel( channel );
+        text += styled.arg( f_color, names[ channel ],
+                            trUtf8( "min %1, max %2, mean %3, clipped %4 / %5" )
+                            .arg( statistics.minimum( c ) )
+                            .arg( statistics.maximum( c ) )
+                            .arg( statistics.mean( c ), 0, 'f', 1 )
+                            .arg( statistics.clippedLow( c ) )
+                            .arg( statistics.clippedHigh( c ) ) );
+    }
+
+    m_analysisBox->setWindowTitle( currentPixmapFileName() );
+    m_analysisBox->setIconPixmap( QPixmap::fromImage( statistics.histogramImage( QSize( 256, 100 ) ) ) );
+    m_analysisBox->setText( text );
+    m_analysisBox->show();
+}
+//! [17]
+
+//---------------------------------------------------------------------------
+
+//! [18]
+bool QImageWidget::isDecoding() const
+{
+    return m_progressiveDecoder->isRunning();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::cancelDecoding()
+{
+    // parts shown so far stay until the next image
+    m_progressiveDecoder->cancel();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::startProgressiveDecoding()
+{
+    // nothing to show until the first rows arrive
+    m_animationPlayer->stop();
+    stopCrossfade();
+
+    m_currentPixmap = QPixmap();
+    m_currentPixmapOrientation = QImageOrientation::Normal;
+    m_customGraphicsView->scene()->clear();
+    m_graphicsPixmapItem = 0;
+    m_progressiveItem = 0;
+
+    QIW_TRACE( lcImageWidgetPixmap, "Decode progressively." );
+    m_progressiveDecoder->decode( m_currentPixmapPath );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::progressiveDecodingStarted( const QString &path, const QSize &size, const int &orientation )
+{
+    if ( path != m_currentPixmapPath ) {
+        return; // cancelled meanwhile
+    }
+
+    m_customGraphicsView->scene()->clear();
+    m_graphicsPixmapItem = 0;
+
+    // parts are placed in stored pixels, the parent turns them upright
+    m_progressiveItem = new QGraphicsRectItem( QRectF( QPointF( 0, 0 ), size ) );
+    m_progressiveItem->setPen( Qt::NoPen );
+    m_progressiveItem->setTransform( QImageOrientation::transform( orientation, size ) );
+    m_customGraphicsView->scene()->addItem( m_progressiveItem );
+
+    m_customGraphicsView->scene()->setSceneRect( QRectF( QPointF( 0, 0 ),
+                                                         QImageOrientation::orientedSize( size, orientation ) ) );
+    fillSize();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::progressivePartDecoded( const QString &path, const QImage &part, const QRect &rect )
+{
+    if ( path != m_currentPixmapPath || !m_progressiveItem ) {
+        return;
+    }
+
+    // a pass of a progressive JPEG refines everything before it
+    if ( rect == m_progressiveItem->rect().toRect() ) {
+        qDeleteAll( m_progressiveItem->childItems() );
+    }
+
+    QGraphicsPixmapItem *item = new QGraphicsPixmapItem( QPixmap::fromImage( part ), m_progressiveItem );
+    item->setTransformationMode( Qt::SmoothTransformation );
+    item->setPos( rect.topLeft() );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::progressiveDecodingProgress( const QString &path, const int &percent )
+{
+    if ( path == m_currentPixmapPath ) {
+        emit decodingProgress( percent );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::progressiveDecoded( const QString &path, const QImage &image )
+{
+    if ( path != m_currentPixmapPath ) {
+        return;
+    }
+
+    if ( image.isNull() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "Cannot decode" ) << path;
+
+        // nothing more comes for this step
+        if ( m_navigationSettling ) {
+            reportNavigationSettled();
+        }
+        return;
+    }
+
+    // the parts go with the scene
+    m_currentPixmap = QPixmap::fromImage( image );
+    m_currentPixmapOrientation = QImageOrientation::of( image );
+    updatePixmap();
+    updateAnimation();
+
+    if ( m_navigationSettling ) {
+        reportNavigationSettled();
+    }
+}
+//! [18]
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::updateAnimation()
+{
+    if ( gotPath() && m_animationPlayer->isAnimated( m_currentPixmapPath ) ) {
+        QIW_TRACE( lcImageWidgetView, "Start animation." );
+        // frame 0 is the decode shown already
+        m_animationPlayer->start( m_currentPixmapPath, !m_currentPixmap.isNull() );
+    } else {
+        m_animationPlayer->stop();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::showAnimationFrame( const QImage &frame, const int &number )
+{
+    // frames have the size of the first one, only the pixels change; the
+    // first comes without an image, it is shown already
+    if ( !frame.isNull() ) {
+        m_currentPixmap = QPixmap::fromImage( frame );
+        m_graphicsPixmapItem->setPixmap( m_currentPixmap );
+    }
+
+    emit animationFrameChanged( number );
+}
+//! [15]
+
+//---------------------------------------------------------------------------
+
+//! [20]
+void QImageWidget::rotateSelected( const int &degrees )
+{
+    QStringList paths = selectedPaths();
+
+    // turning the file would discard the unsaved edits of the shown image
+    if ( isCurrentPixmapModified() && paths.removeAll( m_currentPixmapPath ) > 0 ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "Shown image modified, not turned." ) << m_currentPixmapPath;
+    }
+
+    if ( paths.isEmpty() || degrees % 90 != 0 ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No images or wrong angle." );
+        return;
+    }
+
+    if ( m_bulkOperation->isRunning() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "Already running." );
+        return;
+    }
+
+    // the shown image is not edited, it is not marked modified
+    m_fileUndoStack->push( new QBulkRotateCommand( this, paths, degrees ) );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::exportSelected( const QString &outputDirectory )
+{
+    const QStringList paths = selectedPaths();
+    if ( paths.isEmpty() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No images." );
+        return;
+    }
+
+    if ( m_bulkOperation->isRunning() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "Already running." );
+        return;
+    }
+
+    const QImageExporter::Settings settings = m_exportSettings;
+
+    // distinct names, none over a source: writeFile() refuses the empty ones
+    const QStringList outputPaths = QThumbnailer::outputPaths( paths, outputDirectory, settings.format );
+    QHash < QString, QString > outputs;
+    for ( int i = 0; i < paths.size(); ++i ) {
+        const QString directory = QFileInfo( outputPaths.at( i ) ).absolutePath();
+        if ( !outputPaths.at( i ).isEmpty() && !QDir().mkpath( directory ) ) {
+            qWarning() << Q_FUNC_INFO << trUtf8( "Cannot create" ) << directory;
+            return;
+        }
+        outputs.insert( paths.at( i ), outputPaths.at( i ) );
+    }
+
+    QSharedPointer < QImageExporter::Summary > summary( new QImageExporter::Summary );
+
+    m_bulkRotation = 0;
+    m_exportSummary = summary;
+    m_bulkOperation->start( paths, [ outputs, settings, summary ] ( const QString &path ) {
+        const QImageExporter::Result result = QImageExporter::writeFile( path, outputs.value( path ), settings );
+        summary->add( result );
+        return result.written;
+    } );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::copySelectedPaths()
+{
+    const QStringList paths = selectedPaths();
+    if ( paths.isEmpty() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "No images." );
+        return;
+    }
+
+    // file managers take the urls, editors the text
+    QList < QUrl > urls;
+    foreach ( const QString &path, paths ) {
+        urls.append( QUrl::fromLocalFile( path ) );
+    }
+
+    QMimeData *data = new QMimeData;
+    data->setUrls( urls );
+    data->setText( paths.join( "\n" ) );
+    QApplication::clipboard()->setMimeData( data );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::rotateFiles( const QStringList &paths, const int &degrees, const BulkDone &done )
+{
+    // an undo right after its redo turns the same files, one batch at a
+    // time; the user interface is not held up meanwhile
+    if ( m_bulkOperation->isRunning() ) {
+        afterBulk( [ this, paths, degrees, done ] () {
+            rotateFiles( paths, degrees, done );
+        } );
+        return;
+    }
+
+    if ( paths.isEmpty() ) {
+        if ( done ) {
+            done( QStringList() );
+        }
+        return;
+    }
+
+    m_bulkRotation = degrees;
+    m_bulkDone = done;
+    m_exportSummary.clear();
+    m_bulkOperation->start( paths, [ degrees ] ( const QString &path ) {
+        return QImageEditPipeline::rotateFile( path, degrees );
+    } );
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::afterBulk( const std::function < void () > &start )
+{
+    if ( m_bulkOperation->isRunning() ) {
+        m_bulkQueue.append( start );
+    } else {
+        start();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+bool QImageWidget::isBulkRunning() const
+{
+    return m_bulkOperation->isRunning();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::cancelBulk()
+{
+    m_bulkOperation->cancel();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::bulkOperationFinished( const QStringList &succeeded, const QStringList &failed )
+{
+    const int rotation = m_bulkRotation;
+    const BulkDone done = m_bulkDone;
+    m_bulkRotation = 0;
+    m_bulkDone = BulkDone();
+
+    if ( !failed.isEmpty() ) {
+        qWarning() << Q_FUNC_INFO << trUtf8( "Failed" ) << failed;
+    }
+
+    // the turned files are shown anew, their previews are turned as they are
+    if ( rotation != 0 && !succeeded.isEmpty() ) {
+        foreach ( const QString &path, succeeded ) {
+            m_metadataCache.remove( path );
+            m_imageCache.remove( path );
+
+            const int row = m_pixmapsPaths.indexOf( path );
+            if ( row >= 0 ) {
+                rotatePreview( row, rotation );
+            }
+        }
+
+        if ( !m_slideshowRunning ) {
+            m_decodeQueue->clear();
+        }
+
+        // an undo or redo may turn the shown file after it was edited, the
+        // edits are kept and saving them wins
+        if ( succeeded.contains( m_currentPixmapPath ) && !isCurrentPixmapModified() ) {
+            updatePixmapByIndex();
+        } else {
+            prefetchNext();
+        }
+    }
+
+    emit bulkFinished( succeeded, failed );
+
+    if ( m_exportSummary ) {
+        const QSharedPointer < QImageExporter::Summary > summary = m_exportSummary;
+        m_exportSummary.clear();
+        emit exportFinished( summary->written(), summary->inputBytes(), summary->outputBytes(),
+                             summary->averagePsnr() );
+    }
+
+    if ( done ) {
+        done( succeeded );
+    }
+
+    // a batch that has nothing to do starts none, the next one goes on
+    while ( !m_bulkQueue.isEmpty() && !m_bulkOperation->isRunning() ) {
+        m_bulkQueue.takeFirst()();
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::rotatePreview( const int &row, const int &degrees )
+{
+    QListWidgetItem *item = m_previewWidget->item( row );
+    QWidget *widget = item ? m_previewWidget->itemWidget( item ) : 0;
+    if ( !widget ) {
+        return;
+    }
+
+    foreach ( QLabel *label, widget->findChildren < QLabel * > () ) {
+        const QPixmap *pixmap = label->pixmap();
+        if ( pixmap && !pixmap->isNull() ) {
+            label->setPixmap( pixmap->transformed( QTransform().rotate( degrees ) ) );
+        }
+    }
+}
+//! [20]
+
+//---------------------------------------------------------------------------
+
+//! [21]
+void QImageWidget::setNavigationDelay( const int &delay )
+{
+    m_navigationDelay = qMax( 0, delay );
+}
+
+//---------------------------------------------------------------------------
+
+int QImageWidget::navigationDelay() const
+{
+    return m_navigationDelay;
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::navigateToIndex()
+{
+    m_navigationSettling = false;
+
+    // steps queued behind a decode arrive together, the time counts from
+    // the end of the step before
+    const bool burst = m_navigationDelay > 0 && !m_slideshowRunning
+                       && ( m_navigationTimer->isActive()
+                            || ( m_navigationStepClock.isValid()
+                                 && m_navigationStepClock.elapsed() < m_navigationDelay ) );
+
+    if ( burst ) {
+        QIW_TRACE_VALUE( lcImageWidgetView, "Navigation coalesced:", m_currentPixmapIndex );
+        showNavigationStandIn();
+        m_navigationClock.start();
+        m_navigationTimer->start( m_navigationDelay );
+    } else {
+        m_navigationClock.start();
+        updatePixmapByIndex();
+        if ( !isDecoding() ) {
+            reportNavigationSettled();
+        } else {
+            m_navigationSettling = true;
+        }
+    }
+
+    m_navigationStepClock.start();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::showNavigationStandIn()
+{
+    const QString path = m_pixmapsPaths.at( m_currentPixmapIndex );
+
+    // decoded ahead or for a comparison, as good as the decode
+    const QImage decoded = m_decodeQueue->isReady( path ) ? m_decodeQueue->image( path )
+                                                          : m_imageCache.cachedImage( path );
+    if ( !decoded.isNull() ) {
+        cancelDecoding();
+        m_currentPixmapPath = path;
+        m_currentPixmapRect = QRect();
+        m_slideshowIndex = m_currentPixmapIndex;
+        m_currentPixmap = QPixmap::fromImage( decoded );
+        m_currentPixmapOrientation = QImageOrientation::of( decoded );
+        updatePixmap();
+        updateAnimation();
+        return;
+    }
+
+    // no pixmap until the decode, nothing to save or edit meanwhile
+    cancelDecoding();
+    m_animationPlayer->stop();
+    stopCrossfade();
+
+    m_currentPixmapPath = path;
+    m_currentPixmapRect = QRect();
+    m_slideshowIndex = m_currentPixmapIndex;
+    m_currentPixmap = QPixmap();
+    m_currentPixmapOrientation = QImageOrientation::Normal;
+
+    // the previous image stays if there is no preview yet
+    const QPixmap preview = previewPixmap( m_currentPixmapIndex );
+    if ( !preview.isNull() ) {
+        m_customGraphicsView->scene()->clear();
+        m_graphicsPixmapItem = 0;
+        m_progressiveItem = 0;
+
+        QGraphicsPixmapItem *item = new QGraphicsPixmapItem( preview );
+        item->setTransformationMode( Qt::SmoothTransformation );
+        m_customGraphicsView->scene()->addItem( item );
+        m_customGraphicsView->scene()->setSceneRect( QRectF( preview.rect() ) );
+        fillSize();
+    }
+
+    emit currentPixmapPathChanged( m_currentPixmapPath );
+    updateNavigationAvailable();
+}
+
+//---------------------------------------------------------------------------
+
+QPixmap QImageWidget::previewPixmap( const int &row ) const
+{
+    QListWidgetItem *item = m_previewWidget->item( row );
+    QWidget *widget = item ? m_previewWidget->itemWidget( item ) : 0;
+    if ( !widget ) {
+        return QPixmap();
+    }
+
+    // upright, as the previews are made
+    foreach ( const QLabel *label, widget->findChildren < QLabel * > () ) {
+        const QPixmap *pixmap = label->pixmap();
+        if ( pixmap && !pixmap->isNull() ) {
+            return *pixmap;
+        }
+    }
+
+    return QPixmap();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::navigationSettle()
+{
+    // the list may have changed under the burst
+    if ( m_currentPixmapIndex < 0 || m_currentPixmapIndex >= m_pixmapsPaths.size() ) {
+        return;
+    }
+
+    // the burst may have ended on an image already decoded ahead
+    if ( m_currentPixmapPath != m_pixmapsPaths.at( m_currentPixmapIndex ) || !gotPixmap() ) {
+        updatePixmapByIndex();
+    } else {
+        prefetchNext();
+    }
+
+    if ( isDecoding() ) {
+        m_navigationSettling = true; // progressiveDecoded() reports
+        return;
+    }
+
+    reportNavigationSettled();
+}
+
+//---------------------------------------------------------------------------
+
+void QImageWidget::reportNavigationSettled()
+{
+    m_navigationSettling = false;
+
+    const qint64 latency = m_navigationClock.elapsed();
+    QIW_TRACE_VALUE( lcImageWidgetView, "Navigation settled, ms:", latency );
+    emit navigationSettled( latency );
+}
+//! [21]
+
+//---------------------------------------------------------------------------
@@ -6,6 +6,9 @@
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QGraphicsPixmapItem>
+#include <QGraphicsRectItem>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
 #include <QResizeEvent>
 #include <QWheelEvent>
 #include <QMouseEvent>
@@ -33,11 +36,33 @@
 #include <QThread>
 #include <QDebug>
 
+#include "core/qimagecollection.h"
+#include "core/qimagemetadata.h"
+#include "core/qimagesortfilter.h"
+#include "core/qperceptualhash.h"
+#include "core/qdecodequeue.h"
+#include "core/qanimationplayer.h"
+#include "core/qbatchoperation.h"
+#include "core/qimagecache.h"
+#include "core/qfileremover.h"
+#include "core/qmemorygovernor.h"
+#include "core/qimagestatistics.h"
+#include "core/qimageorientation.h"
+#include "core/qprogressivedecoder.h"
+#include "core/qpreviewloader.h"
+#include "core/qimagescanner.h"
+#include "core/qdirectoryindex.h"
+#include "core/qimageeditpipeline.h"
+#include "core/qimageexporter.h"
+#include "core/qthumbnailer.h"
+
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
 
-class QPreviewThread;
+class QImageComparisonWidget;
+class QUndoMemory;
+class QPreviewMemory;
 
 //!--------------------------------------------------------------------
 //!--------------------------------------------------------------------
@@ -88,6 +113,10 @@ signals:
     void selectedDone();
     //! [2]
 
+    //! [3] ZOOM, SCROLL
+    void viewChanged(); // transform or visible area changed
+    //! [3]
+
     //! PUBLIC METHODS
 public:
     //! [1]
@@ -100,6 +129,12 @@ public:
     void stopSelection();
     //! [2]
 
+    //! [3] ZOOM, SCROLL
+    QPointF viewCenter() const;
+    QRectF visibleSceneRect() const;
+    void setViewState( const QTransform &transform, const QPointF &center );
+    //! [3]
+
     //! PUBLIC SLOTS
 public slots:
     //! [3]
@@ -146,6 +181,30 @@ private:
 };
 
 
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! PIXMAP VIEW ITEM
+//! Pixmap item that shows only a rect of its pixmap. Crops are views into
+//! the shared source pixmap, nothing is copied until pixels are needed.
+class QPixmapViewItem : public QGraphicsPixmapItem
+{
+public:
+    explicit QPixmapViewItem( const QPixmap &pixmap, const QRect &sourceRect = QRect(),
+                              QGraphicsItem *parent = 0 );
+
+    void setSourceRect( const QRect &rect ); // null shows the whole pixmap
+    QRect sourceRect() const;
+
+    QRectF boundingRect() const;
+    QPainterPath shape() const;
+    bool contains( const QPointF &point ) const;
+    void paint( QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget );
+
+private:
+    QRect m_sourceRect;
+};
+
+
 //!--------------------------------------------------------------------
 //!--------------------------------------------------------------------
 //! QIMAGE WIDGET
@@ -155,12 +214,21 @@ class QImageWidget : public QWidget
 
     //! PUBLIC METHODS
 public:
+    //! [14] SLIDESHOW
+    enum SlideshowPolicy {
+        WaitForDecode,  // show a late image as soon as it is decoded, skip it if
+                        // that fails or takes longer than SlideshowWaitLimit
+        SkipLate        // keep the schedule, drop the image that is late
+    };
+    //! [14]
+
     explicit QImageWidget( QWidget *parent = 0);
     ~QImageWidget();
 
     //! [1] MAIN WIDGETS
     QListWidget *previewWidget() { return m_previewWidget; }
     QCustomGraphicsView *customGraphicsView() { return m_customGraphicsView; }
+    QImageComparisonWidget *comparisonWidget() { return m_comparisonWidget; }
     //! [1]
 
     //! [2] PIXMAP
@@ -169,6 +237,11 @@ public:
     bool isCurrentPixmapModified() const;
     //! [2]
 
+    //! [12] DIAGNOSTICS
+    static QString recentEvents(); // last traced events, oldest first
+    static QString pixelKernelPath(); // "scalar", "sse2", "avx2" or "avx512"
+    //! [12]
+
     //! SIGNALS
 signals:
     //! [2] PIXMAP SIGNALS
@@ -178,6 +251,8 @@ signals:
 
     void pixmapAvailable( const bool & );
     void currentPixmapModified( const bool & );
+
+    void pixmapsOrderChanged(); // sorting or filtering applied
     //! [2]
 
     //! [3] CONTROL SIGNALS
@@ -198,8 +273,48 @@ signals:
 
     //! [7]
     void cropped( const bool &c );
+    // a removal finished in background, failed files are back in the list
+    void filesRemoved( const QStringList &removed, const QStringList &failed );
     //! [7]
 
+    //! [13] DUPLICATES
+    void duplicatesFound( const QList < QStringList > &groups );
+    //! [13]
+
+    //! [14] SLIDESHOW
+    void slideshowRunningChanged( const bool & );
+    void slideshowDeadlineMissed( const int &index, const qint64 &lateness ); // ms
+    //! [14]
+
+    //! [15] ANIMATION
+    void animationFrameChanged( const int &frame );
+    //! [15]
+
+    //! [16] COMPARISON
+    void comparingChanged( const bool & );
+    //! [16]
+
+    //! [18] PROGRESSIVE DECODING
+    void decodingProgress( const int &percent ); // large images filling in, 100 when done
+    //! [18]
+
+    //! [20] BULK OPERATIONS
+    void previewSelectionChanged( const int &count );
+    void bulkProgress( const int &done, const int &total ); // files of the whole operation
+    void bulkFinished( const QStringList &succeeded, const QStringList &failed );
+    // after bulkFinished() of exportSelected(); averagePsnr as in
+    // QImageExporter::Summary, measured if exportSettings() say so
+    void exportFinished( const int &written, const qint64 &inputBytes, const qint64 &outputBytes,
+                         const double &averagePsnr );
+    //! [20]
+
+    //! [21] NAVIGATION
+    // the image of a step is shown sharp: ms from the step, the last one
+    // of a coalesced burst, to its decode on screen; also when the decode
+    // failed, nothing more comes for the step then
+    void navigationSettled( const qint64 &latency );
+    //! [21]
+
 
     //! PUBLIC SLOTS
 public slots:
@@ -212,10 +327,31 @@ public slots:
     void setSubDirectorySearching( const bool &enable );
     bool subDirectorySearching() const;
 
+    void setNameFilters( const QStringList &filters ); // "*.png", "*.jpg"...
+    QStringList nameFilters() const;
+
+    // sorting and filtering, applied in background keeping the current image
+    void setSortKey( const QImageSortFilter::SortKey &key );
+    QImageSortFilter::SortKey sortKey() const;
+
+    void setSortOrder( const Qt::SortOrder &order );
+    Qt::SortOrder sortOrder() const;
+
+    void setFilter( const QString &wildcard );
+    QString filter() const;
+
     void setPixmap( const QPixmap &pixmap );
+    // shows rect of pixmap, QRect() for all, turned by the EXIF orientation
+    void setPixmapView( const QPixmap &pixmap, const QRect &rect,
+                        const int &orientation = QImageOrientation::Normal );
 
     // getters
-    QPixmap currentPixmap() const;
+    QPixmap currentPixmap() const;  // a cropped or turned view is copied here
+    QRect currentPixmapRect() const; // shown rect of the source pixmap
+    int currentPixmapOrientation() const; // EXIF orientation it is shown in
+    QSize currentPixmapSize() const {
+        return QImageOrientation::orientedSize( currentPixmapRect().size(), m_currentPixmapOrientation );
+    }
     QString currentPixmapPath() const;
 
     int currentPixmapIndex() const;
@@ -265,9 +401,18 @@ public slots:
     void rotateRight();
     void setCurrentPixmapModified( const bool &changed );
     void crop();
-    void remove();
+    void remove(); // the selected previews, or the current image
+    // drops paths from the list at once and shows the next image, the
+    // files are removed in background
+    void removePaths( const QStringList &paths );
     void setShowRemoveDialog( const bool &show );
     bool showRemoveDialog() const;
+    void setMoveToTrash( const bool &toTrash ); // true by default
+    bool moveToTrash() const;
+    // encoder settings of save(), saveAs() and exportSelected(); save()
+    // and saveAs() take the format from the suffix
+    void setExportSettings( const QImageExporter::Settings &settings );
+    QImageExporter::Settings exportSettings() const;
     bool setAsWallpaper();
     bool save();
     bool saveAs();
@@ -283,6 +428,12 @@ public slots:
     void setPreviewPixmapSize( const QSize &size );
     QSize previewPixmapSize() const;
 
+    // in list order, the current image if none is selected
+    QStringList selectedPaths() const;
+    void setSelectedPaths( const QStringList &paths );
+    void selectAllPreviews();
+    void clearPreviewSelection();
+
     //! [8]
 
     //! [9] INFORMATION
@@ -297,14 +448,14 @@ public slots:
 
     QString currentPixmapCreated() const {
         if ( gotPath() ) {
-            return QFileInfo ( m_currentPixmapPath ).created().toString( "dd MMMM yyyy" );
+            return currentPixmapMetadata().created.toString( "dd MMMM yyyy" );
         }
         return QString();
     }
 
     QString currentPixmapLastModified() const {
         if ( gotPath() ) {
-            return QFileInfo ( m_currentPixmapPath ).lastModified().toString( "dd MMMM yyyy" );
+            return currentPixmapMetadata().lastModified.toString( "dd MMMM yyyy" );
         }
         return QString();
     }
@@ -318,35 +469,35 @@ public slots:
 
     float currentPixmapSize() const {
         if ( gotPath() ) {
-            return QFileInfo ( m_currentPixmapPath ).size();
+            return currentPixmapMetadata().fileSize;
         }
         return -1;
     }
 
     float currentPixmapSizeMB() const {
         if ( gotPath() ) {
-            return QFileInfo ( m_currentPixmapPath ).size() / ( 1024 * 1024 );
+            return currentPixmapMetadata().fileSize / ( 1024 * 1024 );
         }
         return -1;
     }
 
     float currentPixmapSizeKB() const {
         if ( gotPath() ) {
-            return QFileInfo ( m_currentPixmapPath ).size() / ( 1024 );
+            return currentPixmapMetadata().fileSize / ( 1024 );
         }
         return -1;
     }
 
     int currentPixmapWidth() const {
         if ( gotPixmap() ) {
-            return m_currentPixmap.size().width();
+            return currentPixmapSize().width();
         }
         return -1;
     }
 
     int currentPixmapHeight() const {
         if ( gotPixmap() ) {
-            return m_currentPixmap.size().height();
+            return currentPixmapSize().height();
         }
         return -1;
     }
@@ -358,6 +509,100 @@ public slots:
     QList < QAction * > contexActions();
     //! [10]
 
+    //! [13] DUPLICATES
+    // hashes the loaded images in background, emits duplicatesFound()
+    void findDuplicates( const int &maxDistance = 6 );
+    QList < QStringList > duplicateGroups() const;
+
+    // loads the groups one after another, goNext() walks through them
+    void showDuplicates();
+    //! [13]
+
+    //! [14] SLIDESHOW
+    void startSlideshow();
+    void stopSlideshow();
+    bool isSlideshowRunning() const;
+
+    void setSlideshowInterval( const int &msec );
+    int slideshowInterval() const;
+
+    void setSlideshowPolicy( const SlideshowPolicy &policy );
+    SlideshowPolicy slideshowPolicy() const;
+
+    void setSlideshowCrossfade( const int &msec ); // 0 disables
+    int slideshowCrossfade() const;
+    //! [14]
+
+    //! [15] ANIMATION
+    bool isCurrentPixmapAnimated() const;
+    bool isAnimationPaused() const;
+    int animationFrameCount() const; // 0 if unknown
+    int animationCurrentFrame() const;
+
+    void pauseAnimation();
+    void resumeAnimation();
+    void seekAnimation( const int &frame );
+    //! [15]
+
+    //! [16] COMPARISON
+    // shows 2 to 4 images in synchronized panes instead of the view
+    void compare( const QStringList &paths );
+    void compareWithCurrent( const QString &path );
+    void stopComparison();
+    bool isComparing() const;
+    //! [16]
+
+    //! [17] ANALYSIS
+    QImageStatistics currentPixmapStatistics();  // whole image, cached
+    QImageStatistics visiblePixmapStatistics();  // only the visible part when zoomed in
+    void showAnalysis();
+
+    QImageStatisticsCache *statisticsCache() { return &m_statisticsCache; }
+    //! [17]
+
+    //! [18] PROGRESSIVE DECODING
+    // large PNG and JPEG files fill in while they are decoded; navigating
+    // away cancels
+    bool isDecoding() const;
+    void cancelDecoding();
+    //! [18]
+
+    //! [19] MEMORY
+    // one budget over the decoded images, the prefetch window, the undo
+    // history, the previews and the statistics, metadata, hash and
+    // directory caches, none by default; usage() tells them apart
+    QMemoryGovernor *memoryGovernor() { return m_memoryGovernor; }
+    //! [19]
+
+    //! [20] BULK OPERATIONS
+    // over selectedPaths(), the files in parallel; remove() is the bulk
+    // delete
+    void rotateSelected( const int &degrees ); // one entry of fileUndoStack()
+    void exportSelected( const QString &outputDirectory ); // upright copies, in exportSettings()
+    void copySelectedPaths(); // as text and as urls
+
+    // changes to files, apart from the edits of the shown image
+    QUndoStack *fileUndoStack() { return m_fileUndoStack; }
+
+    typedef std::function < void ( const QStringList &succeeded ) > BulkDone;
+
+    // not undoable, rotateSelected() pushes this as a command; after the
+    // running batch if there is one, done gets the files turned
+    void rotateFiles( const QStringList &paths, const int &degrees, const BulkDone &done = BulkDone() );
+
+    bool isBulkRunning() const;
+    void cancelBulk(); // files not started yet
+    //! [20]
+
+    //! [21] NAVIGATION
+    // steps closer than delay ms to the one before, a held key or a fast
+    // scroll through the previews, are coalesced: they show the image
+    // decoded ahead or the preview, and only the step the burst ends on is
+    // decoded, delay ms after it; 0 decodes every step. 80 by default
+    void setNavigationDelay( const int &delay );
+    int navigationDelay() const;
+    //! [21]
+
     //! PRIVATE SIGNALS
 private slots:
     //! [5] EDIT
@@ -366,16 +611,51 @@ private slots:
 
     //! [7] OPERATIONS
     void getSelection( const QRect &rect );
+    void removeFinished();
     //! [7]
 
+    //! [2] PIXMAP
+    void sortFilterFinished();
+    //! [2]
+
     //! [8] PREVIEW
     void currentPreviewChanged( const int &index );
     //! [8]
 
+    //! [13] DUPLICATES
+    void duplicatesFinished();
+    //! [13]
+
+    //! [14] SLIDESHOW
+    void slideshowTick();
+    void slideshowDecoded( const QString &path );
+    void crossfadeFinished();
+    //! [14]
+
+    //! [15] ANIMATION
+    void showAnimationFrame( const QImage &frame, const int &number );
+    //! [15]
+
     //! [11]
-    void appendNewPreview(const QString &path, QPixmap pixmap, const int &index);
+    void previewReady( const int &row, const QString &path, const QImage &preview );
+    void updateVisiblePreviews(); // after scrolling
     //! [11]
 
+    //! [18] PROGRESSIVE DECODING
+    void progressiveDecodingStarted( const QString &path, const QSize &size, const int &orientation );
+    void progressivePartDecoded( const QString &path, const QImage &part, const QRect &rect );
+    void progressiveDecodingProgress( const QString &path, const int &percent );
+    void progressiveDecoded( const QString &path, const QImage &image );
+    //! [18]
+
+    //! [20] BULK OPERATIONS
+    void bulkOperationFinished( const QStringList &succeeded, const QStringList &failed );
+    //! [20]
+
+    //! [21] NAVIGATION
+    void navigationSettle();
+    //! [21]
+
     //! PRIVATE FIELDS
 private:
     //! [1] MAIN WIDGETS
@@ -386,14 +666,28 @@ private:
     //! [1]
 
     //! [2] PIXMAPS
-    QStringList m_pixmapsPaths;
-    QPixmap m_currentPixmap;
-    QGraphicsPixmapItem *m_graphicsPixmapItem;
+    QImageCollection m_pixmapsPaths;
+    QPixmap m_currentPixmap;        // source, shared with the undo commands
+    QRect m_currentPixmapRect;      // shown part of it, null for all
+    int m_currentPixmapOrientation; // how it is turned, pixels are as stored
+    QPixmapViewItem *m_graphicsPixmapItem;
     QString m_currentPixmapPath;
     int m_currentPixmapIndex;
     bool m_isCurrentPixmapModified;
     bool m_subDirectorySearching;
     QString m_filters; // png, jpg etc
+    QDirectoryIndex m_directoryIndex; // listings of the scanned directories, persisted
+
+    QStringList m_sourcePaths; // as loaded, before sorting and filtering
+    QImageSortFilter::Settings m_sortFilterSettings;
+    QImageSortFilter::Result m_sortFilterResult; // last result for m_sourcePaths
+    QFutureWatcher < QImageSortFilter::Result > *m_sortFilterWatcher;
+    QImageMetadataCache m_metadataCache;
+    QFuture < void > m_metadataFuture; // background gathering for the source
+    // every sort, gathering and index load or save not finished, replaced
+    // ones too: they use m_metadataCache and the indexes, the destructor
+    // waits for all of them
+    QList < QFuture < void > > m_cacheWorkers;
     //! [2]
 
     //! [3] CONTROL
@@ -415,11 +709,13 @@ private:
     //! [7] OPERATIONS
     bool m_showRemoveDialog;
     bool m_moveToTrash;
+    QFutureWatcher < QFileRemover::Result > *m_removeWatcher;
+    QStringList m_removeQueue; // removed from the list while a batch runs
     //! [7]
 
     //! [8] PREVIEW
     bool m_previewVisible;
-    QStringList m_pixmapsPathsBefore;
+    quint64 m_previewsGeneration; // collection generation the previews were built for
     QSize m_previewPixmapSize;
     //! [8]
 
@@ -431,18 +727,92 @@ private:
     QList < QAction * > m_contexActions;
     //! [10]
 
-    //! [11] PREVIEW THREAD
-    QPreviewThread *m_previewThread;
+    //! [11] PREVIEW LOADER
+    QPreviewLoader *m_previewLoader;
     //! [11]
 
+    //! [13] DUPLICATES
+    QPerceptualHashIndex m_perceptualHashIndex;
+    QFutureWatcher < QList < QStringList > > *m_duplicatesWatcher;
+    QList < QStringList > m_duplicateGroups;
+    //! [13]
+
+    //! [14] SLIDESHOW
+    QDecodeQueue *m_decodeQueue;
+
+    bool m_slideshowRunning;
+    int m_slideshowIndex;           // last slot shown or dropped
+    int m_slideshowWaitingIndex;    // late image waited for, -1 if on time
+    enum { SlideshowWaitLimit = 30000 }; // ms a late image is waited for, an interval if longer
+    QTimer *m_slideshowTimer;
+    QElapsedTimer m_slideshowClock;
+    qint64 m_slideshowDeadline;     // next slot, ms on m_slideshowClock
+    int m_slideshowInterval;
+    SlideshowPolicy m_slideshowPolicy;
+
+    int m_slideshowCrossfade;
+    QVariantAnimation *m_crossfadeAnimation;
+    QPixmapViewItem *m_crossfadeItem; // previous image fading out
+    //! [14]
+
+    //! [15] ANIMATION
+    QAnimationPlayer *m_animationPlayer;
+    //! [15]
+
+    //! [16] COMPARISON
+    QImageCache m_imageCache; // full decodes shared by the panes
+    QImageComparisonWidget *m_comparisonWidget;
+    //! [16]
+
+    //! [17] ANALYSIS
+    QImageStatisticsCache m_statisticsCache;
+    QMessageBox *m_analysisBox;
+    //! [17]
+
+    //! [18] PROGRESSIVE DECODING
+    QProgressiveDecoder *m_progressiveDecoder;
+    QGraphicsRectItem *m_progressiveItem; // parts decoded so far are its children
+    //! [18]
+
+    //! [19] MEMORY
+    QMemoryGovernor *m_memoryGovernor;
+    QUndoMemory *m_undoMemory;
+    QPreviewMemory *m_previewMemory;
+    //! [19]
+
+    //! [20] BULK OPERATIONS
+    QBatchOperation *m_bulkOperation;
+    int m_bulkRotation; // degrees of the running batch, 0 for other operations
+    BulkDone m_bulkDone; // of the running batch
+    QList < std::function < void () > > m_bulkQueue; // batches waiting for the running one
+    QUndoStack *m_fileUndoStack;
+    QImageExporter::Settings m_exportSettings;
+    QSharedPointer < QImageExporter::Summary > m_exportSummary; // of the running export
+    //! [20]
+
+    //! [21] NAVIGATION
+    QTimer *m_navigationTimer; // runs while a burst goes on
+    int m_navigationDelay;
+    QElapsedTimer m_navigationStepClock; // since the last step was handled
+    QElapsedTimer m_navigationClock;     // latency of the step being settled
+    bool m_navigationSettling; // a progressive decode reports it
+    //! [21]
+
     //! PRIVATE METHODS
 private:
     //! [2] PIXMAP
     void updatePixmapByIndex();
     void updatePixmap();
+    void prefetchNext(); // outside slideshows, so going on shows it at once
 
     QStringList searchDirectory(const QString &dirPath );
 
+    void setSourcePaths( const QStringList &paths );
+    void applySortFilter();
+    void keepCacheWorker( const QFuture < void > &future );
+    void clearPixmap();
+    void updateNavigationAvailable();
+
     bool gotPaths() const {
         return !m_pixmapsPaths.isEmpty();
     }
@@ -455,6 +825,11 @@ private:
         return !m_currentPixmap.isNull();
     }
 
+    // served from the cache, one stat the first time
+    QImageMetadata currentPixmapMetadata() const {
+        return m_metadataCache.metadata( m_currentPixmapPath, QImageMetadata::FileInfo );
+    }
+
     //! [2]
 
     //! [4] SCALE
@@ -469,17 +844,51 @@ private:
     //! [6]
 
     //! [7] OPERATIONS
-    void deleteImage( const QString &path );
+    void startRemoving();
     //! [7]
 
     //! [8] PREVIEW
     void createPreviews();
+    void updatePreviews();
+    void appendPreviewItem( const QString &path ); // its preview comes later
     QString m_startedDirectoryPath;
     //! [8]
 
     //! [10] CONTEX MENU
     void contextMenuEvent( QContextMenuEvent *event );
     //! [10]
+
+    //! [14] SLIDESHOW
+    int slideshowNextIndex( const int &index ) const;
+    void slideshowPrefetch();
+    void scheduleSlideshowTick();
+    void showDecodedPixmap( const int &index, const QImage &image );
+    void startCrossfade( const QPixmap &previous, const QRect &rect, const int &orientation );
+    void stopCrossfade();
+    //! [14]
+
+    //! [15] ANIMATION
+    void updateAnimation();
+    //! [15]
+
+    //! [18] PROGRESSIVE DECODING
+    void startProgressiveDecoding();
+    //! [18]
+
+    //! [20] BULK OPERATIONS
+    void rotatePreview( const int &row, const int &degrees );
+    // now if no batch runs, else when it is finished; start may start one
+    void afterBulk( const std::function < void () > &start );
+    friend class QBulkRotateCommand;
+    //! [20]
+
+    //! [21] NAVIGATION
+    // all steps to m_currentPixmapIndex go through here
+    void navigateToIndex();
+    void showNavigationStandIn();
+    QPixmap previewPixmap( const int &row ) const;
+    void reportNavigationSettled();
+    //! [21]
 };
 
 //!--------------------------------------------------------------------
@@ -489,30 +898,43 @@ private:
 class QCropCommand : public QUndoCommand
 {
 public:
+    // rect is relative to the shown pixmapRect of pixmap, both are views
+    // into the same pixmap, so undo and redo copy nothing
     explicit QCropCommand( QImageWidget *imageWidget,
-                           const QPixmap &originalPixmap,
-                           const QPixmap &croppedPixmap,
+                           const QPixmap &pixmap,
+                           const QRect &pixmapRect,
+                           const int &orientation,
+                           const QRect &rect,
                            QUndoCommand *parent = 0 )
         : QUndoCommand( parent ) {
         m_imageWidget = imageWidget;
-        m_originalPixmap = originalPixmap;
-        m_croppedPixmap = croppedPixmap;
+        m_pixmap = pixmap;
+        m_orientation = orientation;
+        m_originalRect = pixmapRect.isNull() ? pixmap.rect() : pixmapRect;
+        m_croppedRect = rect.translated( m_originalRect.topLeft() ) & m_originalRect;
     }
 
     ~QCropCommand() {}
 
     void undo() {
-        m_imageWidget->setPixmap( m_originalPixmap );
+        m_imageWidget->setPixmapView( m_pixmap, m_originalRect, m_orientation );
     }
 
     void redo() {
-        m_imageWidget->setPixmap( m_croppedPixmap );
+        m_imageWidget->statisticsCache()->cropped( m_pixmap, m_originalRect, m_croppedRect );
+        m_imageWidget->setPixmapView( m_pixmap, m_croppedRect, m_orientation );
+    }
+
+    QList < QPixmap > pixmaps() const {
+        return QList < QPixmap >() << m_pixmap;
     }
 
 private:
     QImageWidget *m_imageWidget;
-    QPixmap m_originalPixmap;
-    QPixmap m_croppedPixmap;
+    QPixmap m_pixmap;
+    QRect m_originalRect;
+    QRect m_croppedRect;
+    int m_orientation;
 };
 
 //! PASTE COMMAND
@@ -521,18 +943,22 @@ class QPasteCommand : public QUndoCommand
 public:
     explicit QPasteCommand( QImageWidget *imageWidget,
                             const QPixmap &originalPixmap,
+                            const QRect &originalRect,
+                            const int &originalOrientation,
                             const QPixmap &pastedPixmap,
                             QUndoCommand *parent = 0 )
         : QUndoCommand ( parent ) {
         m_imageWidget = imageWidget;
         m_originalPixmap = originalPixmap;
+        m_originalRect = originalRect;
+        m_originalOrientation = originalOrientation;
         m_pastedPixmap = pastedPixmap;
     }
 
     ~QPasteCommand() {}
 
     void undo() {
-        m_imageWidget->setPixmap( m_originalPixmap );
+        m_imageWidget->setPixmapView( m_originalPixmap, m_originalRect, m_originalOrientation );
     }
 
     void redo() {
@@ -540,9 +966,15 @@ public:
         m_imageWidget->setCurrentPixmapModified( true );
     }
 
+    QList < QPixmap > pixmaps() const {
+        return QList < QPixmap >() << m_originalPixmap << m_pastedPixmap;
+    }
+
 private:
     QImageWidget *m_imageWidget;
     QPixmap m_originalPixmap;
+    QRect m_originalRect;
+    int m_originalOrientation;
     QPixmap m_pastedPixmap;
 
 };
@@ -554,78 +986,134 @@ class QRotateCommand : public QUndoCommand
 public:
     enum Direction { Left, Right };
 
+    // turns the view only, together with the EXIF orientation it was
+    // decoded with; the pixels are turned once, when saved or copied
     explicit QRotateCommand( QImageWidget *imageWidget,
-                             const QPixmap &originalPixmap,
+                             const QPixmap &pixmap,
+                             const QRect &pixmapRect,
+                             const int &orientation,
                              const Direction &direction,
                              QUndoCommand *parent = 0 )
         : QUndoCommand ( parent ) {
         m_imageWidget = imageWidget;
-        m_originalPixmap = originalPixmap;
-        m_direction = direction;
+        m_pixmap = pixmap;
+        m_pixmapRect = pixmapRect;
+        m_originalOrientation = orientation;
+        m_rotatedOrientation = QImageOrientation::rotated( orientation, direction == Right ? -90 : 90 );
     }
 
     void undo() {
-        if ( m_direction == Right ) {
-            m_originalPixmap = m_originalPixmap.transformed( QMatrix().rotate( 90 ) );
-        } else {
-            m_originalPixmap = m_originalPixmap.transformed( QMatrix().rotate( -90 ) );
-        }
-
-        m_imageWidget->setPixmap( m_originalPixmap );
+        m_imageWidget->setPixmapView( m_pixmap, m_pixmapRect, m_originalOrientation );
     }
 
     void redo() {
-        if ( m_direction == Right ) {
-            m_originalPixmap = m_originalPixmap.transformed( QMatrix().rotate( -90 ) );
-        } else {
-            m_originalPixmap = m_originalPixmap.transformed( QMatrix().rotate( 90 ) );
-        }
-
-        m_imageWidget->setPixmap( m_originalPixmap );
+        m_imageWidget->setPixmapView( m_pixmap, m_pixmapRect, m_rotatedOrientation );
         m_imageWidget->setCurrentPixmapModified( true );
     }
 
+    QList < QPixmap > pixmaps() const {
+        return QList < QPixmap >() << m_pixmap;
+    }
+
 private:
     QImageWidget *m_imageWidget;
-    QPixmap m_originalPixmap;
-    Direction m_direction;
+    QPixmap m_pixmap;
+    QRect m_pixmapRect;
+    int m_originalOrientation;
+    int m_rotatedOrientation;
 
 };
 
-//!--------------------------------------------------------------------
-//!--------------------------------------------------------------------
-//! PREVIEW THREAD
-class QPreviewThread : public QThread
+//! BULK ROTATE COMMAND
+class QBulkRotateCommand : public QUndoCommand
 {
-    Q_OBJECT
 
-signals:
-    void previewWidgetReady( QListWidget * );
-    void appendNewPreview( const QString &, QPixmap, const int & );
+public:
+    // turns the files, not the view; undo turns them back
+    explicit QBulkRotateCommand( QImageWidget *imageWidget,
+                                 const QStringList &paths,
+                                 const int &degrees,
+                                 QUndoCommand *parent = 0 )
+        : QUndoCommand ( parent ),
+          m_turned( new QStringList ) {
+        m_imageWidget = imageWidget;
+        m_paths = paths;
+        m_degrees = degrees;
+    }
+
+    // the batches run after each other, each one takes the files the one
+    // before left; only files that were turned are turned back
+    void undo();
+    void redo();
+
+private:
+    QImageWidget *m_imageWidget;
+    QStringList m_paths;
+    int m_degrees;
+    // turned and not turned back, shared with the batches, which outlive
+    // the command if the stack is cleared
+    QSharedPointer < QStringList > m_turned;
+
+};
 
+//! UNDO MEMORY
+//! Pixmaps only the undo history keeps alive, for the memory governor;
+//! counted, never evicted, the history belongs to the user
+class QUndoMemory : public QMemoryGovernor::Client
+{
 public:
-    explicit QPreviewThread( QObject *parent )
-        : QThread( parent ) {
+    QUndoMemory( const QUndoStack *undoStack, const QPixmap *currentPixmap )
+        : m_undoStack( undoStack ),
+          m_currentPixmap( currentPixmap ) {
 
     }
 
-    ~QPreviewThread() {
+    qint64 bytes() const override;
 
+    // after the stack changed
+    void changed() {
+        grown();
     }
 
-    void run() {
-        for ( int i = 0; i < m_previewsList.size(); ++i ) {
-            QPixmap pixmap = QPixmap( m_previewsList.at( i ) );
-            emit appendNewPreview( m_previewsList.at(i), pixmap, i );
-        }
+private:
+    const QUndoStack *m_undoStack;
+    const QPixmap *m_currentPixmap;
+};
+
+//! PREVIEW MEMORY
+//! Pixmaps of the preview strip, for the memory governor; counted, never
+//! evicted, the strip shows them
+class QPreviewMemory : public QMemoryGovernor::Client
+{
+public:
+    QPreviewMemory()
+        : m_bytes( 0 ) {
+
     }
 
-    void setPreviewsList( const QStringList & list) {
-        m_previewsList = list;
+    qint64 bytes() const override {
+        return m_bytes;
+    }
+
+    void added( const QPixmap &pixmap ) {
+        m_bytes += pixmapBytes( pixmap );
+        grown();
+    }
+
+    void removed( const QPixmap &pixmap ) {
+        m_bytes -= pixmapBytes( pixmap );
+    }
+
+    void clear() {
+        m_bytes = 0;
     }
 
 private:
-    QStringList m_previewsList;
+    static qint64 pixmapBytes( const QPixmap &pixmap ) {
+        return qint64( pixmap.width() ) * pixmap.height() * pixmap.depth() / 8;
+    }
 
+    qint64 m_bytes;
 };
+
 #endif // QImageWidget_H
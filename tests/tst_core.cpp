@@ -0,0 +1,1145 @@
+#include <QtTest>
+#include <QImageWriter>
+
+#include "core/qbatchoperation.h"
+#include "core/qdirectoryindex.h"
+#include "core/qexifreader.h"
+#include "core/qimagecollection.h"
+#include "core/qimagedecoder.h"
+#include "core/qimageexporter.h"
+#include "core/qfileremover.h"
+#include "core/qioscheduler.h"
+#include "core/qjpegdecoder.h"
+#include "core/qimagecache.h"
+#include "core/qimagemetadata.h"
+#include "core/qmemorygovernor.h"
+#include "core/qmappedfile.h"
+#include "core/qpngdecoder.h"
+#include "core/qpreviewloader.h"
+#include "core/qimagesortfilter.h"
+#include "core/qimageeditpipeline.h"
+#include "core/qimageorientation.h"
+#include "core/qimagerotation.h"
+#include "core/qimagestatistics.h"
+#include "core/qpixelkernels.h"
+#include "core/qthumbnailer.h"
+
+//!--------------------------------------------------------------------
+//!--------------------------------------------------------------------
+//! CORE TESTS
+class TestCore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    //! [1] COLLECTION
+    void collectionIndex();
+    void collectionGeneration();
+    void collectionRemoveAll();
+    //! [1]
+
+    //! [2] SORTING
+    void naturalCompare();
+    void metadataCache();
+    //! [2]
+
+    //! [3] EDITS
+    void editPipelineParse();
+    void editPipelineApply();
+    void rotation_data();
+    void rotation();
+    void orientation_data();
+    void orientation();
+    void rotateFile_data();
+    void rotateFile();
+    //! [3]
+
+    //! [4] STATISTICS
+    void statistics();
+    void statisticsCropped();
+    //! [4]
+
+    //! [5] KERNELS
+    void absDiff();
+    void kernelsBitExact_data();
+    void kernelsBitExact();
+    //! [5]
+
+    //! [6] DECODING
+    void jpegScaleDenominator_data();
+    void jpegScaleDenominator();
+    void jpegPreview();
+    void incrementalDecode_data();
+    void incrementalDecode();
+    void mappedFile_data();
+    void mappedFile();
+    //! [6]
+
+    //! [7] SCHEDULING
+    void ioSchedulerOrder();
+    void ioSchedulerClaim();
+    void previewLoader();
+    //! [7]
+
+    //! [8] MEMORY
+    void memoryGovernor();
+    void memoryGovernorCaches();
+    //! [8]
+
+    //! [9] FILES
+    void fileRemover();
+    void batchOperation();
+    void directoryIndex();
+    void thumbnailerOutputPaths();
+    //! [9]
+
+    //! [10] ENCODING
+    void exporterPsnr();
+    void exporterWriteAll();
+    void exporterKeepsSources();
+    //! [10]
+
+private:
+    static QImage gradient( const int &width, const int &height );
+    static QByteArray withOrientation( const QByteArray &jpeg, const int &orientation, const bool &bigEndian );
+};
+
+//---------------------------------------------------------------------------
+
+QImage TestCore::gradient( const int &width, const int &height )
+{
+    QImage image( width, height, QImage::Format_ARGB32 );
+    for ( int y = 0; y < height; ++y ) {
+        for ( int x = 0; x < width; ++x ) {
+            image.setPixel( x, y, qRgba( x % 256, y % 256, ( x + y ) % 256, 255 ) );
+        }
+    }
+
+    return image;
+}
+
+//---------------------------------------------------------------------------
+
+QByteArray TestCore::withOrientation( const QByteArray &jpeg, const int &orientation, const bool &bigEndian )
+{
+    // TIFF header and IFD0 with the Orientation tag only
+    const char littleTiff[] = { 'I', 'I', 42, 0, 8, 0, 0, 0,
+                                1, 0, 0x12, 0x01, 3, 0, 1, 0, 0, 0, char( orientation ), 0, 0, 0,
+                                0, 0, 0, 0 };
+    const char bigTiff[] = { 'M', 'M', 0, 42, 0, 0, 0, 8,
+                             0, 1, 0x01, 0x12, 0, 3, 0, 0, 0, 1, 0, char( orientation ), 0, 0,
+                             0, 0, 0, 0 };
+    const QByteArray tiff( bigEndian ? bigTiff : littleTiff, 26 );
+
+    const int length = 2 + 6 + tiff.size();
+    QByteArray app1( "\xFF\xE1" );
+    app1.append( char( length >> 8 ) ).append( char( length & 0xFF ) );
+    app1.append( QByteArray( "Exif\0\0", 6 ) ).append( tiff );
+
+    return jpeg.left( 2 ) + app1 + jpeg.mid( 2 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::collectionIndex()
+{
+    QImageCollection collection( QStringList() << "a" << "b" << "c" << "b" );
+    QCOMPARE( collection.indexOf( "b" ), 1 ); // first of duplicates
+
+    collection.removeAt( 0 );
+    QCOMPARE( collection.indexOf( "c" ), 1 );
+    QCOMPARE( collection.indexOf( "a" ), -1 );
+
+    collection.insert( 0, "d" );
+    QCOMPARE( collection.indexOf( "d" ), 0 );
+    QCOMPARE( collection.indexOf( "c" ), 2 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::collectionGeneration()
+{
+    QImageCollection first( QStringList() << "a" );
+    QImageCollection second( QStringList() << "a" );
+    QVERIFY( first.generation() != second.generation() );
+
+    const quint64 generation = first.generation();
+    first.append( "b" );
+    QVERIFY( first.generation() != generation );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::collectionRemoveAll()
+{
+    QImageCollection collection( QStringList() << "a" << "b" << "c" << "d" << "e" );
+    QCOMPARE( collection.indexOf( "e" ), 4 ); // index built before
+
+    const quint64 generation = collection.generation();
+    QCOMPARE( collection.removeAll( QSet < QString > () << "b" << "d" << "x" ), 2 );
+    QVERIFY( collection.generation() != generation );
+
+    QCOMPARE( collection.paths(), QStringList() << "a" << "c" << "e" );
+    QCOMPARE( collection.indexOf( "e" ), 2 );
+    QCOMPARE( collection.indexOf( "b" ), -1 );
+    QCOMPARE( collection.indexOf( "d" ), -1 );
+
+    const quint64 unchanged = collection.generation();
+    QCOMPARE( collection.removeAll( QSet < QString > () << "x" ), 0 );
+    QCOMPARE( collection.generation(), unchanged );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::naturalCompare()
+{
+    QVERIFY( QImageSortFilter::naturalCompare( "img2.png", "img10.png" ) < 0 );
+    QVERIFY( QImageSortFilter::naturalCompare( "img10.png", "img2.png" ) > 0 );
+    QCOMPARE( QImageSortFilter::naturalCompare( "a.png", "a.png" ), 0 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::metadataCache()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    const QString path = QDir( directory.path() ).filePath( "a.png" );
+    QImage small( 8, 4, QImage::Format_RGB32 );
+    small.fill( Qt::red );
+    QVERIFY( small.save( path ) );
+    const qint64 size = QFileInfo( path ).size();
+
+    QImageMetadataCache cache;
+    cache.gather( QStringList() << path, QImageMetadata::FileInfo | QImageMetadata::Dimensions );
+    QCOMPARE( cache.value( path ).fileSize, size );
+    QCOMPARE( cache.value( path ).dimensions, QSize( 8, 4 ) );
+
+    // changed by another program: read again, not served from the cache
+    QImage large( 16, 16, QImage::Format_RGB32 );
+    large.fill( Qt::blue );
+    QVERIFY( large.save( path ) );
+    QVERIFY( QFileInfo( path ).size() != size );
+    cache.gather( QStringList() << path, QImageMetadata::FileInfo | QImageMetadata::Dimensions );
+    QCOMPARE( cache.value( path ).fileSize, QFileInfo( path ).size() );
+    QCOMPARE( cache.value( path ).dimensions, QSize( 16, 16 ) );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::editPipelineParse()
+{
+    QImageEditPipeline pipeline;
+    QVERIFY( pipeline.parse( "crop=1,2,30,40;rotate=90" ) );
+    QCOMPARE( pipeline.operations().size(), 2 );
+    QCOMPARE( pipeline.operations().at( 0 ).rect, QRect( 1, 2, 30, 40 ) );
+    QCOMPARE( pipeline.operations().at( 1 ).degrees, 90 );
+
+    QString error;
+    QVERIFY( !pipeline.parse( "rotate=45", &error ) );
+    QVERIFY( !error.isEmpty() );
+    QCOMPARE( pipeline.operations().size(), 2 ); // unchanged on errors
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::editPipelineApply()
+{
+    const QImage image = gradient( 40, 30 );
+
+    QImageEditPipeline pipeline;
+    pipeline.crop( QRect( 0, 0, 20, 10 ) );
+    pipeline.rotate( 90 );
+
+    const QImage result = pipeline.apply( image );
+    QCOMPARE( result.size(), QSize( 10, 20 ) );
+
+    // clockwise: the top left pixel goes to the top right
+    QCOMPARE( result.pixel( 9, 0 ), image.pixel( 0, 0 ) );
+
+    QCOMPARE( QImageEditPipeline::rotated( image, 360 ), image );
+    QCOMPARE( QImageEditPipeline::rotated( QImageEditPipeline::rotated( image, 90 ), -90 ), image );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::rotation_data()
+{
+    QTest::addColumn < int > ( "format" );
+    QTest::addColumn < QSize > ( "size" );
+
+    // odd sizes hit the edges of tiles and of the 4 x 4 blocks
+    const QSize sizes[] = { QSize( 1, 1 ), QSize( 7, 3 ), QSize( 64, 64 ), QSize( 131, 67 ), QSize( 1030, 1100 ) };
+    for ( int i = 0; i < 5; ++i ) {
+        const QByteArray name = QByteArray::number( sizes[ i ].width() ) + "x" + QByteArray::number( sizes[ i ].height() );
+        QTest::newRow( "ARGB32 " + name ) << int( QImage::Format_ARGB32 ) << sizes[ i ];
+        QTest::newRow( "RGB888 " + name ) << int( QImage::Format_RGB888 ) << sizes[ i ];
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::rotation()
+{
+    QFETCH( int, format );
+    QFETCH( QSize, size );
+
+    const QImage image = gradient( size.width(), size.height() ).convertToFormat( QImage::Format( format ) );
+
+    for ( int degrees = -270; degrees <= 360; degrees += 90 ) {
+        const QImage expected = image.transformed( QTransform().rotate( degrees ) );
+        const QImage actual = QImageRotation::rotated( image, degrees );
+        QCOMPARE( actual.format(), image.format() );
+        QCOMPARE( actual.convertToFormat( QImage::Format_ARGB32 ), expected.convertToFormat( QImage::Format_ARGB32 ) );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::orientation_data()
+{
+    QTest::addColumn < int > ( "orientation" );
+
+    for ( int orientation = 1; orientation <= 8; ++orientation ) {
+        QTest::newRow( qPrintable( QString::number( orientation ) ) ) << orientation;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::orientation()
+{
+    QFETCH( int, orientation );
+
+    const QImage image = gradient( 7, 5 );
+    const QImage turned = QImageOrientation::applied( image, orientation );
+    QCOMPARE( turned.size(), QImageOrientation::orientedSize( image.size(), orientation ) );
+
+    // the view transform puts every pixel where the turned pixels have it
+    const QTransform transform = QImageOrientation::transform( orientation, image.size() );
+    for ( int y = 0; y < image.height(); ++y ) {
+        for ( int x = 0; x < image.width(); ++x ) {
+            const QPointF shown = transform.map( QPointF( x + 0.5, y + 0.5 ) );
+            QCOMPARE( turned.pixel( int( shown.x() ), int( shown.y() ) ), image.pixel( x, y ) );
+        }
+    }
+
+    // turning the view is turning the pixels
+    const int rotated = QImageOrientation::rotated( orientation, 90 );
+    QCOMPARE( QImageOrientation::applied( image, rotated ), QImageRotation::rotated( turned, 90 ) );
+    QCOMPARE( QImageOrientation::rotated( rotated, -90 ), orientation );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::rotateFile_data()
+{
+    QTest::addColumn < bool > ( "bigEndian" );
+
+    QTest::newRow( "little endian" ) << false;
+    QTest::newRow( "big endian" ) << true;
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::rotateFile()
+{
+    QFETCH( bool, bigEndian );
+
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    // JPEGs with the tag: the tag is rewritten, nothing else
+    QByteArray jpeg;
+    QBuffer buffer( &jpeg );
+    QVERIFY( buffer.open( QIODevice::WriteOnly ) );
+    QVERIFY( gradient( 16, 8 ).save( &buffer, "jpg" ) );
+
+    const QString jpegPath = directory.filePath( "a.jpg" );
+    const QByteArray original = withOrientation( jpeg, 6, bigEndian );
+    QFile jpegFile( jpegPath );
+    QVERIFY( jpegFile.open( QIODevice::WriteOnly ) );
+    jpegFile.write( original );
+    jpegFile.close();
+
+    QCOMPARE( QExifReader::read( jpegPath ).orientation, 6 );
+    QVERIFY( QImageEditPipeline::rotateFile( jpegPath, 90 ) );
+    QCOMPARE( QExifReader::read( jpegPath ).orientation, QImageOrientation::rotated( 6, 90 ) );
+
+    QVERIFY( jpegFile.open( QIODevice::ReadOnly ) );
+    const QByteArray rotated = jpegFile.readAll();
+    jpegFile.close();
+    QCOMPARE( rotated.size(), original.size() );
+    int changed = 0;
+    for ( int i = 0; i < rotated.size(); ++i ) {
+        changed += rotated.at( i ) != original.at( i );
+    }
+    QCOMPARE( changed, 1 );
+
+    QVERIFY( QImageEditPipeline::rotateFile( jpegPath, -90 ) );
+    QCOMPARE( QExifReader::read( jpegPath ).orientation, 6 );
+
+    // JPEGs without EXIF get an APP1 segment, the scan data is kept
+    const QString plainPath = directory.filePath( "c.jpg" );
+    QFile plainFile( plainPath );
+    QVERIFY( plainFile.open( QIODevice::WriteOnly ) );
+    plainFile.write( jpeg );
+    plainFile.close();
+
+    QVERIFY( QImageEditPipeline::rotateFile( plainPath, 90 ) );
+    QCOMPARE( QExifReader::read( plainPath ).orientation, 6 );
+    QVERIFY( plainFile.open( QIODevice::ReadOnly ) );
+    const QByteArray tagged = plainFile.readAll();
+    plainFile.close();
+    QCOMPARE( tagged.size(), jpeg.size() + 36 );
+    QVERIFY( tagged.endsWith( jpeg.mid( 20 ) ) );
+
+    // EXIF without the tag, IFD0 gets it; the only entry becomes ImageWidth
+    QByteArray untagged = withOrientation( jpeg, 1, bigEndian );
+    untagged[ bigEndian ? 23 : 22 ] = 0;
+    QVERIFY( plainFile.open( QIODevice::WriteOnly ) );
+    plainFile.write( untagged );
+    plainFile.close();
+
+    bool order = false;
+    QCOMPARE( QExifReader::orientationOffset( plainPath, &order ), qint64( -1 ) );
+    QVERIFY( QImageEditPipeline::rotateFile( plainPath, -90 ) );
+    QCOMPARE( QExifReader::read( plainPath ).orientation, 8 );
+    QVERIFY( !QImage( plainPath ).isNull() );
+
+    // the others get their pixels turned
+    const QString pngPath = directory.filePath( "b.png" );
+    const QImage image = gradient( 16, 8 );
+    QVERIFY( image.save( pngPath ) );
+    QVERIFY( QImageEditPipeline::rotateFile( pngPath, 90 ) );
+    QCOMPARE( QImage( pngPath ).convertToFormat( QImage::Format_ARGB32 ), QImageRotation::rotated( image, 90 ) );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::statistics()
+{
+    const QImage image = gradient( 256, 600 );
+    const QImageStatistics statistics = QImageStatistics::compute( image );
+
+    QCOMPARE( statistics.pixelCount(), quint64( 256 * 600 ) );
+    QCOMPARE( statistics.minimum( QImageStatistics::Red ), 0 );
+    QCOMPARE( statistics.maximum( QImageStatistics::Red ), 255 );
+    QCOMPARE( statistics.mean( QImageStatistics::Red ), 127.5 );
+    QCOMPARE( statistics.clippedHigh( QImageStatistics::Alpha ), quint64( 256 * 600 ) );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::statisticsCropped()
+{
+    const QPixmap source = QPixmap::fromImage( gradient( 300, 200 ) );
+    const QRect rect( 10, 20, 250, 150 ); // kept area is larger, subtracts
+
+    QImageStatisticsCache cache;
+    cache.statistics( source );
+
+    // crops are views, derived from the shown parent rect
+    cache.cropped( source, QRect(), rect );
+    QVERIFY( cache.contains( source, rect ) );
+
+    const QRect inner( 40, 50, 30, 20 ); // kept area is smaller, computed directly
+    cache.cropped( source, rect, inner );
+    QVERIFY( cache.contains( source, inner ) );
+
+    const QRect rects[] = { rect, inner };
+    for ( const QRect &view : rects ) {
+        const QImageStatistics derived = cache.statistics( source, view );
+        const QImageStatistics computed = QImageStatistics::compute( source.toImage(), view );
+        QCOMPARE( derived.pixelCount(), computed.pixelCount() );
+        for ( int level = 0; level < QImageStatistics::Levels; ++level ) {
+            QCOMPARE( derived.count( QImageStatistics::Blue, level ), computed.count( QImageStatistics::Blue, level ) );
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::absDiff()
+{
+    const int count = 13; // vector part and the rest
+    QVector < QRgb > a( count ), b( count ), out( count );
+    for ( int i = 0; i < count; ++i ) {
+        a[ i ] = qRgba( i * 19, 255 - i, i, 10 );
+        b[ i ] = qRgba( i * 7, i, 255, 200 );
+    }
+
+    QPixelKernels::absDiff( a.constData(), b.constData(), out.data(), count );
+
+    for ( int i = 0; i < count; ++i ) {
+        QCOMPARE( out.at( i ), qRgb( qAbs( qRed( a.at( i ) ) - qRed( b.at( i ) ) ),
+                                     qAbs( qGreen( a.at( i ) ) - qGreen( b.at( i ) ) ),
+                                     qAbs( qBlue( a.at( i ) ) - qBlue( b.at( i ) ) ) ) );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::kernelsBitExact_data()
+{
+    QTest::addColumn < int > ( "path" );
+
+    for ( int path = QPixelKernels::Sse2; path <= QPixelKernels::Avx512; ++path ) {
+        QTest::newRow( qPrintable( QPixelKernels::pathName( QPixelKernels::Path( path ) ) ) ) << path;
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::kernelsBitExact()
+{
+    QFETCH( int, path );
+    if ( !QPixelKernels::isSupported( QPixelKernels::Path( path ) ) ) {
+        QSKIP( "Not built in or not supported by this CPU." );
+    }
+
+    const QPixelKernels::Table reference = QPixelKernels::tableFor( QPixelKernels::Scalar );
+    const QPixelKernels::Table tested = QPixelKernels::tableFor( QPixelKernels::Path( path ) );
+    QCOMPARE( int( tested.path ), path );
+
+    // every tail length, unaligned starts
+    qsrand( 1 );
+    for ( int count = 0; count < 80; ++count ) {
+        for ( int offset = 0; offset < 3; ++offset ) {
+            QVector < QRgb > a( count + offset ), b( count + offset );
+            for ( int i = 0; i < a.size(); ++i ) {
+                a[ i ] = QRgb( qrand() ) * 2654435761u;
+                b[ i ] = QRgb( qrand() ) * 2246822519u;
+            }
+
+            QVector < QRgb > expected( a.size() ), actual( a.size() );
+            reference.absDiff( a.constData() + offset, b.constData() + offset, expected.data() + offset, count );
+            tested.absDiff( a.constData() + offset, b.constData() + offset, actual.data() + offset, count );
+            QCOMPARE( actual, expected );
+
+            QVector < quint32 > expectedHistogram( QPixelKernels::HistogramCopies * QPixelKernels::HistogramSize, 0 );
+            QVector < quint32 > actualHistogram( expectedHistogram.size(), 0 );
+            reference.histogram( a.constData() + offset, count, expectedHistogram.data() );
+            tested.histogram( a.constData() + offset, count, actualHistogram.data() );
+            QCOMPARE( actualHistogram, expectedHistogram );
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::jpegScaleDenominator_data()
+{
+    QTest::addColumn < QSize > ( "imageSize" );
+    QTest::addColumn < QSize > ( "scaledSize" );
+    QTest::addColumn < int > ( "mode" );
+    QTest::addColumn < int > ( "denominator" );
+
+    QTest::newRow( "camera, preview" ) << QSize( 6000, 4000 ) << QSize( 256, 256 ) << int( Qt::KeepAspectRatioByExpanding ) << 8;
+    QTest::newRow( "half" ) << QSize( 800, 600 ) << QSize( 300, 300 ) << int( Qt::KeepAspectRatio ) << 2;
+    QTest::newRow( "rounded up" ) << QSize( 801, 601 ) << QSize( 101, 76 ) << int( Qt::KeepAspectRatio ) << 8;
+    QTest::newRow( "larger" ) << QSize( 640, 480 ) << QSize( 1024, 1024 ) << int( Qt::KeepAspectRatio ) << 1;
+    QTest::newRow( "no size" ) << QSize( 640, 480 ) << QSize() << int( Qt::KeepAspectRatio ) << 1;
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::jpegScaleDenominator()
+{
+    QFETCH( QSize, imageSize );
+    QFETCH( QSize, scaledSize );
+    QFETCH( int, mode );
+    QFETCH( int, denominator );
+
+    QCOMPARE( QJpegDecoder::scaleDenominator( imageSize, scaledSize, Qt::AspectRatioMode( mode ) ), denominator );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::jpegPreview()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    const QString path = directory.filePath( "gradient.jpg" );
+    const QImage source = gradient( 800, 600 );
+    QVERIFY( source.save( path, "JPEG", 95 ) );
+
+    // the same size whichever decoder is built in
+    const QImage preview = QImageDecoder::decode( path, QSize( 100, 100 ) );
+    QCOMPARE( preview.size(), QSize( 100, 75 ) );
+
+    const QImage expanded = QImageDecoder::decode( path, QSize( 100, 100 ), Qt::KeepAspectRatioByExpanding );
+    QCOMPARE( expanded.size(), QSize( 133, 100 ) );
+
+    // smooth content survives the reduced DCT
+    const QRgb expected = source.scaled( preview.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation ).pixel( 48, 50 );
+    const QRgb actual = preview.pixel( 48, 50 );
+    QVERIFY( qAbs( qRed( actual ) - qRed( expected ) ) < 16 );
+    QVERIFY( qAbs( qGreen( actual ) - qGreen( expected ) ) < 16 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::incrementalDecode_data()
+{
+    QTest::addColumn < QString > ( "format" );
+    QTest::addColumn < bool > ( "progressive" );
+
+    QTest::newRow( "png" ) << "png" << false;
+    QTest::newRow( "jpeg" ) << "jpg" << false;
+    QTest::newRow( "progressive jpeg" ) << "jpg" << true;
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::incrementalDecode()
+{
+    QFETCH( QString, format );
+    QFETCH( bool, progressive );
+
+    const bool png = format == "png";
+    if ( !( png ? QPngDecoder::isAvailable() : QJpegDecoder::isAvailable() ) ) {
+        QSKIP( "Library not built in." );
+    }
+
+    QTemporaryDir directory;
+    const QString path = directory.filePath( "image." + format );
+    QImageWriter writer( path );
+    writer.setQuality( 95 );
+    writer.setProgressiveScanWrite( progressive );
+    QVERIFY( writer.write( gradient( 300, 200 ) ) );
+
+    int updates = 0;
+    int lastPercent = 0;
+    QRect covered;
+    const QJpegDecoder::Progress progress = [ & ] ( const QRect &rect, const int &percent ) {
+        updates += rect.isEmpty() ? 0 : 1;
+        covered |= rect;
+        lastPercent = percent;
+        return true;
+    };
+
+    QImage image;
+    QVERIFY( png ? QPngDecoder::decodeIncremental( path, &image, progress )
+                 : QJpegDecoder::decodeIncremental( path, &image, progress ) );
+    QVERIFY( updates > 1 );
+    QCOMPARE( covered, QRect( 0, 0, 300, 200 ) );
+    QCOMPARE( lastPercent, 100 );
+
+    // the same pixels the generic path gives, within libjpeg versions
+    const QImage expected = QImage( path ).convertToFormat( QImage::Format_RGB32 );
+    const QImage actual = image.convertToFormat( QImage::Format_RGB32 );
+    QCOMPARE( actual.size(), expected.size() );
+    for ( int y = 0; y < actual.height(); y += 37 ) {
+        for ( int x = 0; x < actual.width(); x += 41 ) {
+            QVERIFY( qAbs( qGreen( actual.pixel( x, y ) ) - qGreen( expected.pixel( x, y ) ) ) <= 2 );
+        }
+    }
+
+    // cancelling stops at the next batch of rows
+    int calls = 0;
+    QVERIFY( !( png ? QPngDecoder::decodeIncremental( path, &image, [ & ] ( const QRect &, const int & ) { return ++calls < 2; } )
+                    : QJpegDecoder::decodeIncremental( path, &image, [ & ] ( const QRect &, const int & ) { return ++calls < 2; } ) ) );
+    QCOMPARE( calls, 2 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::mappedFile_data()
+{
+    QTest::addColumn < int > ( "size" );
+    QTest::addColumn < bool > ( "mapped" );
+
+    QTest::newRow( "small, read" ) << 1000 << false;
+    QTest::newRow( "large, mapped" ) << int( QMappedFile::MinimumMapSize ) * 3 + 17 << true;
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::mappedFile()
+{
+    QFETCH( int, size );
+    QFETCH( bool, mapped );
+
+    QTemporaryDir directory;
+    const QString path = directory.filePath( "bytes" );
+
+    QByteArray bytes( size, 0 );
+    for ( int i = 0; i < size; ++i ) {
+        bytes[ i ] = char( i * 7 );
+    }
+
+    QFile out( path );
+    QVERIFY( out.open( QIODevice::WriteOnly ) );
+    QCOMPARE( out.write( bytes ), qint64( size ) );
+    out.close();
+
+    QMappedFile file( path );
+    QVERIFY( file.isOpen() );
+    QCOMPARE( file.isMapped(), mapped );
+    QCOMPARE( file.size(), qint64( size ) );
+    QCOMPARE( QByteArray( reinterpret_cast < const char * > ( file.data() ), size ), bytes );
+    QCOMPARE( file.device()->readAll(), bytes );
+
+    QMappedFile::readAhead( path ); // only a hint, must not disturb anything
+    QVERIFY( !QMappedFile( directory.filePath( "missing" ) ).isOpen() );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::ioSchedulerOrder()
+{
+    QTemporaryDir directory;
+    const QString path = directory.filePath( "image.jpg" );
+
+    QIoScheduler scheduler;
+    scheduler.setConcurrency( path, 1 );
+    QCOMPARE( scheduler.concurrency( path ), 1 );
+
+    QMutex mutex;
+    QStringList order;
+    const auto record = [ & ] ( const QString &name ) {
+        return [ &, name ] () {
+            QMutexLocker locker( &mutex );
+            order.append( name );
+        };
+    };
+
+    // holds the only slot of the device while the rest queue up
+    QSemaphore gate;
+    scheduler.submit( path, QIoScheduler::Prefetch, [ & ] () { gate.acquire(); } );
+
+    scheduler.submit( path, QIoScheduler::OffscreenThumbnail, record( "offscreen" ) );
+    const quint64 prefetch = scheduler.submit( path, QIoScheduler::Prefetch, record( "prefetch" ) );
+    scheduler.submit( path, QIoScheduler::VisibleThumbnail, record( "visible" ) );
+    const quint64 cancelled = scheduler.submit( path, QIoScheduler::Prefetch, record( "cancelled" ) );
+
+    QVERIFY( scheduler.cancel( cancelled ) );
+    QVERIFY( scheduler.setPriority( prefetch, QIoScheduler::VisibleThumbnail ) );
+
+    // past the limit at once
+    scheduler.wait( scheduler.submit( path, QIoScheduler::Interactive, record( "interactive" ) ) );
+
+    gate.release();
+    scheduler.waitForDone();
+
+    QCOMPARE( order, QStringList() << "interactive" << "visible" << "prefetch" << "offscreen" );
+    QVERIFY( !scheduler.cancel( prefetch ) );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::ioSchedulerClaim()
+{
+    QTemporaryDir directory;
+    const QString path = directory.filePath( "image.jpg" );
+
+    QIoScheduler scheduler;
+    QAtomicInt done;
+    quint64 task = 0;
+    {
+        const QIoScheduler::Claim claim( &scheduler, path );
+        task = scheduler.submit( path, QIoScheduler::Prefetch, [ & ] () { done.ref(); } );
+        QThread::msleep( 50 );
+        QCOMPARE( done.load(), 0 );
+    }
+
+    scheduler.wait( task );
+    QCOMPARE( done.load(), 1 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::previewLoader()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    QStringList paths;
+    for ( int i = 0; i < 3; ++i ) {
+        paths.append( directory.filePath( QString( "%1.png" ).arg( i ) ) );
+        QVERIFY( gradient( 32, 16 ).save( paths.last() ) );
+    }
+
+    QPreviewLoader loader;
+    QSignalSpy ready( &loader, &QPreviewLoader::previewReady );
+    QSignalSpy finished( &loader, &QPreviewLoader::finished );
+
+    // every row once, in whatever order
+    loader.start( paths, QSize( 8, 8 ), 0, 0 );
+    loader.setVisibleRows( 1, 2 );
+    QTRY_COMPARE( finished.size(), 1 );
+    QVERIFY( !loader.isRunning() );
+    QCOMPARE( ready.size(), 3 );
+
+    QSet < int > rows;
+    foreach ( const QList < QVariant > &arguments, ready ) {
+        const int row = arguments.at( 0 ).toInt();
+        rows.insert( row );
+        QCOMPARE( arguments.at( 1 ).toString(), paths.at( row ) );
+        QCOMPARE( arguments.at( 2 ).value < QImage > ().size(), QSize( 8, 4 ) );
+    }
+    QCOMPARE( rows.size(), 3 );
+
+    // nothing of a cancelled start is delivered
+    ready.clear();
+    loader.start( paths, QSize( 8, 8 ), 0, 2 );
+    loader.cancel();
+    QVERIFY( !loader.isRunning() );
+    QTest::qWait( 100 );
+    QCOMPARE( ready.size(), 0 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::memoryGovernor()
+{
+    QMemoryGovernor governor;
+    governor.setPressureThreshold( 0 );
+
+    QImageCache decodes;
+    QImageCache previews;
+    governor.addClient( "decodes", &decodes );
+    governor.addClient( "previews", &previews );
+
+    const QImage image( 100, 100, QImage::Format_ARGB32 );
+    const qint64 size = image.byteCount();
+
+    decodes.insert( "a", image, 1000 ); // slow to get back
+    QThread::msleep( 5 );
+    previews.insert( "b", image, 0 );
+    QThread::msleep( 5 );
+    previews.insert( "c", image, 0 );
+
+    QCOMPARE( governor.bytes(), 3 * size );
+    QCOMPARE( governor.usage().value( "previews" ), 2 * size );
+
+    // cheap goes before expensive even when newer, old before new
+    governor.setBudget( 2 * size );
+    QVERIFY( decodes.contains( "a" ) );
+    QVERIFY( !previews.contains( "b" ) );
+    QVERIFY( previews.contains( "c" ) );
+
+    // growing on this thread trims at once
+    QThread::msleep( 5 );
+    decodes.insert( "d", image, 1000 );
+    QCOMPARE( governor.bytes(), 2 * size );
+    QVERIFY( !previews.contains( "c" ) );
+
+    governor.removeClient( &previews );
+    QCOMPARE( governor.usage().keys(), QList < QString >() << "decodes" );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::memoryGovernorCaches()
+{
+    QMemoryGovernor governor;
+    governor.setPressureThreshold( 0 );
+
+    QImageStatisticsCache statistics;
+    QImageMetadataCache metadata;
+    governor.addClient( "statistics", &statistics );
+    governor.addClient( "metadata", &metadata );
+
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+    const QString path = directory.filePath( "a.png" );
+    QVERIFY( gradient( 16, 16 ).save( path ) );
+
+    // counted as they fill, metadata is kept whatever the budget
+    metadata.metadata( path, QImageMetadata::FileInfo );
+    const qint64 metadataBytes = governor.usage().value( "metadata" );
+    QVERIFY( metadataBytes > 0 );
+
+    const QPixmap first = QPixmap::fromImage( gradient( 64, 64 ) );
+    const QPixmap second = QPixmap::fromImage( gradient( 32, 32 ) );
+    statistics.statistics( first );
+    QThread::msleep( 5 );
+    statistics.statistics( second );
+    const qint64 entryBytes = governor.usage().value( "statistics" ) / 2;
+    QVERIFY( entryBytes > 0 );
+
+    // the least recently used statistics go first
+    governor.setBudget( metadataBytes + entryBytes );
+    QVERIFY( !statistics.contains( first ) );
+    QVERIFY( statistics.contains( second ) );
+    QCOMPARE( governor.bytes(), metadataBytes + entryBytes );
+
+    metadata.clear();
+    QCOMPARE( governor.usage().value( "metadata" ), qint64( 0 ) );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::fileRemover()
+{
+    QTemporaryDir dataHome;
+    QTemporaryDir directory;
+    QVERIFY( dataHome.isValid() && directory.isValid() );
+
+    const QByteArray previousDataHome = qgetenv( "XDG_DATA_HOME" );
+    qputenv( "XDG_DATA_HOME", QFile::encodeName( dataHome.path() ) );
+
+    const QString path = directory.filePath( "a b.png" );
+    const QString other = directory.filePath( "c.png" );
+    QVERIFY( gradient( 8, 8 ).save( path ) );
+    QVERIFY( gradient( 8, 8 ).save( other ) );
+
+    QFileRemover::Result result = QFileRemover::remove( QStringList() << path << directory.filePath( "none.png" ), true );
+    QCOMPARE( result.removed, QStringList() << path );
+    QCOMPARE( result.failed, QStringList() << directory.filePath( "none.png" ) );
+    QVERIFY( !QFile::exists( path ) );
+
+#if defined( Q_OS_UNIX ) && !defined( Q_OS_DARWIN ) && !defined( Q_OS_ANDROID )
+    // both temporary directories are on the same device, so the home trash
+    const QString trash = dataHome.filePath( "Trash" );
+    QVERIFY( QFile::exists( trash + "/files/a b.png" ) );
+
+    QFile info( trash + "/info/a b.png.trashinfo" );
+    QVERIFY( info.open( QIODevice::ReadOnly ) );
+    const QByteArray content = info.readAll();
+    QVERIFY( content.startsWith( "[Trash Info]\n" ) );
+    QVERIFY( content.contains( "\nPath=" + QUrl::toPercentEncoding( QFileInfo( path ).absoluteFilePath(), "/" ) + "\n" ) );
+    QVERIFY( content.contains( "\nDeletionDate=" ) );
+
+    // same name again
+    QVERIFY( gradient( 8, 8 ).save( path ) );
+    QVERIFY( QFileRemover::moveToTrash( path ) );
+    QVERIFY( QFile::exists( trash + "/files/a b.2.png" ) );
+    QVERIFY( QFile::exists( trash + "/info/a b.2.png.trashinfo" ) );
+#endif
+
+    result = QFileRemover::remove( QStringList() << other, false );
+    QCOMPARE( result.removed, QStringList() << other );
+    QVERIFY( !QFile::exists( other ) );
+
+    if ( previousDataHome.isNull() ) {
+        qunsetenv( "XDG_DATA_HOME" );
+    } else {
+        qputenv( "XDG_DATA_HOME", previousDataHome );
+    }
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::batchOperation()
+{
+    QBatchOperation batch;
+    QSignalSpy progress( &batch, &QBatchOperation::progress );
+    QSignalSpy finished( &batch, &QBatchOperation::finished );
+
+    const QBatchOperation::Operation operation = [] ( const QString &path ) {
+        return path.endsWith( ".ok" );
+    };
+
+    const QStringList paths = QStringList() << "a.ok" << "b.failed" << "c.ok";
+    QVERIFY( batch.start( paths, operation ) );
+    QVERIFY( batch.isRunning() );
+    QVERIFY( !batch.start( paths, operation ) ); // one at a time
+
+    batch.waitForFinished();
+    QVERIFY( !batch.isRunning() );
+
+    // one progress per file, one finished for all
+    QCOMPARE( progress.size(), 3 );
+    QCOMPARE( progress.last().at( 0 ).toInt(), 3 );
+    QCOMPARE( progress.last().at( 1 ).toInt(), 3 );
+    QCOMPARE( finished.size(), 1 );
+
+    QStringList succeeded = finished.first().at( 0 ).toStringList();
+    succeeded.sort();
+    QCOMPARE( succeeded, QStringList() << "a.ok" << "c.ok" );
+    QCOMPARE( finished.first().at( 1 ).toStringList(), QStringList() << "b.failed" );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::directoryIndex()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    const QString root = directory.path();
+    QVERIFY( QDir( root ).mkpath( "sub/deeper" ) );
+    QVERIFY( QDir( root ).mkpath( ".hidden" ) );
+    foreach ( const QString &name, QStringList() << "b.png" << "a.JPG" << "notes.txt" << ".dot.png"
+                                                  << "sub/c.png" << "sub/deeper/d.gif" << ".hidden/e.png" ) {
+        QFile file( QDir( root ).filePath( name ) );
+        QVERIFY( file.open( QIODevice::WriteOnly ) );
+    }
+
+    const QStringList filters = QStringList() << "*.png" << "*.jpg" << "*.gif";
+    const QString cacheFilePath = QDir( root ).filePath( "directories.cache" );
+    QDirectoryIndex index( cacheFilePath );
+
+    // sorted per directory, files before subdirectories, hidden ones skipped
+    const QStringList expected = QStringList() << root + "/a.JPG" << root + "/b.png"
+                                               << root + "/sub/c.png" << root + "/sub/deeper/d.gif";
+    QCOMPARE( index.scan( root, filters ), expected );
+    QCOMPARE( index.scan( root, filters, false ), expected.mid( 0, 2 ) );
+    QCOMPARE( index.directoryCount(), 3 );
+
+    // a saved index answers like the one it was saved from
+    QVERIFY( index.save() );
+    QDirectoryIndex loaded( cacheFilePath );
+    QVERIFY( loaded.load() );
+    QCOMPARE( loaded.directoryCount(), 3 );
+    QCOMPARE( loaded.scan( root, filters ), expected );
+
+    // changes show on the next scan
+    QVERIFY( QFile::remove( QDir( root ).filePath( "sub/deeper/d.gif" ) ) );
+    QVERIFY( QDir( root ).rmdir( "sub/deeper" ) );
+    QFile added( QDir( root ).filePath( "sub/f.png" ) );
+    QVERIFY( added.open( QIODevice::WriteOnly ) );
+    added.close();
+
+    QCOMPARE( loaded.scan( root, filters ), QStringList() << root + "/a.JPG" << root + "/b.png"
+                                                          << root + "/sub/c.png" << root + "/sub/f.png" );
+    QCOMPARE( loaded.directoryCount(), 2 );
+
+    // the first index still holds the directory gone, then nothing is recent
+    QCOMPARE( index.prune(), 1 );
+    QCOMPARE( index.directoryCount(), 2 );
+    QCOMPARE( index.prune( 0 ), 2 );
+    QCOMPARE( index.directoryCount(), 0 );
+
+    QVERIFY( loaded.scan( QDir( root ).filePath( "none" ), filters ).isEmpty() );
+    loaded.invalidate( root );
+    QCOMPARE( loaded.directoryCount(), 0 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::thumbnailerOutputPaths()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    const QString root = directory.path();
+    QVERIFY( QDir( root ).mkpath( "a" ) && QDir( root ).mkpath( "b" ) );
+    const QStringList paths = QStringList() << root + "/a/x.jpg" << root + "/b/x.png" << root + "/b/x.bmp";
+    foreach ( const QString &path, paths ) {
+        QVERIFY( gradient( 8, 8 ).save( path ) );
+    }
+
+    // the tree under the common directory, names taken twice numbered
+    QCOMPARE( QThumbnailer::outputPaths( paths, root + "/out", "jpg" ),
+              QStringList() << root + "/out/a/x.jpg" << root + "/out/b/x.jpg" << root + "/out/b/x.2.jpg" );
+
+    // never over a source
+    const QStringList inPlace = QThumbnailer::outputPaths( paths, root, "jpg" );
+    QVERIFY( inPlace.at( 0 ).isEmpty() );
+    QCOMPARE( inPlace.at( 1 ), root + "/b/x.jpg" );
+    QVERIFY( !QThumbnailer::write( paths.at( 0 ), QSize( 4, 4 ), paths.at( 0 ) ) );
+    QCOMPARE( QImage( paths.at( 0 ) ).size(), QSize( 8, 8 ) );
+
+    QCOMPARE( QThumbnailer::writeAll( paths.mid( 0, 1 ), QSize( 4, 4 ), root + "/a" ), 0 );
+    QCOMPARE( QThumbnailer::writeAll( paths, QSize( 4, 4 ), root + "/out" ), 3 );
+    QVERIFY( QFileInfo( root + "/out/b/x.2.jpg" ).isFile() );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::exporterPsnr()
+{
+    const QImage image = gradient( 40, 30 );
+    QVERIFY( qIsInf( QImageExporter::psnr( image, image ) ) );
+    QCOMPARE( QImageExporter::psnr( image, gradient( 30, 40 ) ), -1.0 );
+
+    // every channel 10 off: 10 log10( 255² / 10² )
+    QImage dark( 16, 16, QImage::Format_RGB32 );
+    QImage light( 16, 16, QImage::Format_RGB32 );
+    dark.fill( qRgb( 100, 100, 100 ) );
+    light.fill( qRgb( 110, 110, 110 ) );
+    QVERIFY( qAbs( QImageExporter::psnr( dark, light ) - 28.1308 ) < 0.001 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::exporterWriteAll()
+{
+    QTemporaryDir input;
+    QTemporaryDir output;
+    QVERIFY( input.isValid() && output.isValid() );
+    QVERIFY( QImageExporter::formats().contains( "png" ) );
+    QVERIFY( QImageExporter::formats().contains( "jpg" ) );
+
+    const QStringList paths = QStringList() << input.filePath( "a.png" ) << input.filePath( "none.png" )
+                                            << input.filePath( "b.png" );
+    QVERIFY( gradient( 64, 48 ).save( paths.at( 0 ) ) );
+    QVERIFY( gradient( 48, 64 ).save( paths.at( 2 ) ) );
+
+    QImageExporter::Settings settings;
+    settings.format = "png";
+    settings.effort = 100;
+    settings.measure = true;
+
+    // in the order of paths, the missing one failed
+    QList < QImageExporter::Result > results = QImageExporter::writeAll( paths, output.path(), settings, 2 );
+    QCOMPARE( results.size(), 3 );
+    QVERIFY( !results.at( 1 ).written );
+
+    QImageExporter::Summary summary;
+    foreach ( const QImageExporter::Result &result, results ) {
+        summary.add( result );
+    }
+    QCOMPARE( summary.written(), 2 );
+    QCOMPARE( summary.failed(), 1 );
+    QCOMPARE( summary.inputBytes(), QFileInfo( paths.at( 0 ) ).size() + QFileInfo( paths.at( 2 ) ).size() );
+    QCOMPARE( summary.outputBytes(), QFileInfo( output.filePath( "a.png" ) ).size() + QFileInfo( output.filePath( "b.png" ) ).size() );
+    QVERIFY( qIsInf( summary.averagePsnr() ) ); // lossless
+    QCOMPARE( QImageDecoder::decode( output.filePath( "b.png" ) ).size(), QSize( 48, 64 ) );
+
+    // lossy, close
+    settings.format = "jpg";
+    settings.quality = 90;
+    const QImageExporter::Result jpeg = QImageExporter::write( gradient( 64, 48 ), output.filePath( "c.jpg" ), settings );
+    QVERIFY( jpeg.written );
+    QVERIFY( jpeg.outputBytes > 0 );
+    QVERIFY( !qIsInf( jpeg.psnr ) && jpeg.psnr > 30 );
+}
+
+//---------------------------------------------------------------------------
+
+void TestCore::exporterKeepsSources()
+{
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+
+    // one base name, two formats
+    const QStringList paths = QStringList() << directory.filePath( "a.jpg" ) << directory.filePath( "a.png" );
+    QVERIFY( gradient( 32, 32 ).save( paths.at( 0 ) ) );
+    QVERIFY( gradient( 16, 16 ).save( paths.at( 1 ) ) );
+
+    QFile source( paths.at( 0 ) );
+    QVERIFY( source.open( QIODevice::ReadOnly ) );
+    const QByteArray original = source.readAll();
+    source.close();
+
+    QImageExporter::Settings settings;
+    settings.format = "jpg";
+
+    // into their own directory both would end up on a.jpg, a source
+    QList < QImageExporter::Result > results = QImageExporter::writeAll( paths, directory.path(), settings );
+    QCOMPARE( results.size(), 2 );
+    QVERIFY( !results.at( 0 ).written );
+    QVERIFY( !results.at( 1 ).written );
+    QVERIFY( source.open( QIODevice::ReadOnly ) );
+    QCOMPARE( source.readAll(), original );
+    source.close();
+
+    // elsewhere, one file each
+    const QString output = directory.filePath( "out" );
+    results = QImageExporter::writeAll( paths, output, settings );
+    QVERIFY( results.at( 0 ).written && results.at( 1 ).written );
+    QCOMPARE( QImageDecoder::decode( output + "/a.jpg" ).size(), QSize( 32, 32 ) );
+    QCOMPARE( QImageDecoder::decode( output + "/a.2.jpg" ).size(), QSize( 16, 16 ) );
+}
+
+//---------------------------------------------------------------------------
+
+QTEST_MAIN( TestCore )
+#include "tst_core.moc"
@@ -0,0 +1,209 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include "core/qimagescanner.h"
+#include "core/qimageeditpipeline.h"
+#include "core/qimageexporter.h"
+#include "core/qimagemetadata.h"
+#include "core/qioscheduler.h"
+#include "core/qthumbnailer.h"
+
+//! qimagetool thumbnail|convert|info <files or directories>
+//! Headless front end of the core library, for batch jobs on machines
+//! without a display.
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream stream( stdout );
+    return stream;
+}
+
+QTextStream &err()
+{
+    static QTextStream stream( stderr );
+    return stream;
+}
+
+// directories are scanned, files taken as they are
+QStringList inputPaths( const QStringList &arguments, const bool &recursive )
+{
+    QStringList paths;
+    foreach ( const QString &argument, arguments ) {
+        const QFileInfo info( argument );
+        if ( info.isDir() ) {
+            paths += QImageScanner::scan( info.absoluteFilePath(), QImageScanner::defaultNameFilters(), recursive );
+        } else if ( info.isFile() ) {
+            paths.append( info.absoluteFilePath() );
+        } else {
+            err() << "No such file or directory: " << argument << endl;
+        }
+    }
+
+    return paths;
+}
+
+QSize parseSize( const QString &text )
+{
+    const QStringList parts = text.split( 'x' );
+    if ( parts.size() == 1 ) {
+        const int side = parts.first().toInt();
+        return QSize( side, side );
+    }
+
+    return parts.size() == 2 ? QSize( parts.at( 0 ).toInt(), parts.at( 1 ).toInt() ) : QSize();
+}
+
+int convert( const QStringList &paths, const QString &outputDirectory,
+             const QImageExporter::Settings &settings, const int &threads,
+             const QImageEditPipeline &pipeline, const bool &report )
+{
+    if ( !QImageExporter::isSupported( settings.format ) ) {
+        err() << "No encoder for " << settings.format << ", available: "
+              << QImageExporter::formats().join( ", " ) << endl;
+        return 0;
+    }
+
+    const QList < QImageExporter::Result > results =
+            QImageExporter::writeAll( paths, outputDirectory, settings, threads, pipeline );
+
+    QImageExporter::Summary summary;
+    for ( int i = 0; i < results.size(); ++i ) {
+        const QImageExporter::Result &result = results.at( i );
+        summary.add( result );
+
+        if ( report && result.written ) {
+            out() << paths.at( i ) << '\t'
+                  << result.inputBytes << '\t'
+                  << result.outputBytes << '\t'
+                  << QString::number( double( result.outputBytes ) / qMax( result.inputBytes, qint64( 1 ) ), 'f', 3 ) << '\t'
+                  << QString::number( result.psnr, 'f', 2 ) << '\t'
+                  << result.encodeTime << endl;
+        }
+    }
+
+    if ( report ) {
+        err() << summary.inputBytes() << " bytes in, " << summary.outputBytes() << " bytes out";
+        if ( settings.measure ) {
+            err() << ", average PSNR " << QString::number( summary.averagePsnr(), 'f', 2 ) << " dB";
+        }
+        err() << endl;
+    }
+
+    return summary.written();
+}
+
+void info( const QStringList &paths )
+{
+    QImageMetadataCache cache;
+    cache.gather( paths, QImageMetadata::AllFields );
+
+    foreach ( const QString &path, paths ) {
+        const QImageMetadata metadata = cache.value( path );
+        out() << path << '\t'
+              << metadata.dimensions.width() << 'x' << metadata.dimensions.height() << '\t'
+              << metadata.fileSize << '\t'
+              << metadata.captureTime.toString( Qt::ISODate ) << endl;
+    }
+}
+
+} // namespace
+
+int main( int argc, char *argv[] )
+{
+    QCoreApplication app( argc, argv );
+    QCoreApplication::setApplicationName( "qimagetool" );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Batch thumbnails, conversion and information of images." );
+    parser.addHelpOption();
+    parser.addPositionalArgument( "command", "thumbnail, convert or info" );
+    parser.addPositionalArgument( "inputs", "Image files or directories.", "<inputs...>" );
+
+    const QCommandLineOption outputOption( QStringList() << "o" << "output", "Output directory, required by thumbnail and convert.", "dir" );
+    const QCommandLineOption sizeOption( QStringList() << "s" << "size", "Thumbnail size, WxH or N.", "size", "256" );
+    const QCommandLineOption formatOption( QStringList() << "f" << "format", "Output format.", "format", "jpg" );
+    const QCommandLineOption qualityOption( QStringList() << "q" << "quality", "Output quality, 0 to 100.", "quality", "-1" );
+    const QCommandLineOption editOption( QStringList() << "e" << "edit", "Edits for convert, \"crop=x,y,w,h;rotate=90\".", "edits" );
+    const QCommandLineOption effortOption( "effort", "Encoder effort for convert, 0 to 100: smaller and slower.", "effort", "-1" );
+    const QCommandLineOption progressiveOption( "progressive", "Progressive JPEG for convert." );
+    const QCommandLineOption threadsOption( "threads", "Files encoded at a time by convert, 0 for one per core.", "count", "0" );
+    const QCommandLineOption measureOption( "measure", "Decode what convert wrote and measure its PSNR." );
+    const QCommandLineOption reportOption( "report", "Per file of convert: input bytes, output bytes, ratio, PSNR, ms." );
+    const QCommandLineOption recursiveOption( QStringList() << "r" << "recursive", "Scan directories recursively." );
+    const QCommandLineOption readsOption( "reads", "Thumbnail files read at a time per disk, 0 detects.", "count", "0" );
+    parser.addOption( outputOption );
+    parser.addOption( sizeOption );
+    parser.addOption( formatOption );
+    parser.addOption( qualityOption );
+    parser.addOption( editOption );
+    parser.addOption( effortOption );
+    parser.addOption( progressiveOption );
+    parser.addOption( threadsOption );
+    parser.addOption( measureOption );
+    parser.addOption( reportOption );
+    parser.addOption( recursiveOption );
+    parser.addOption( readsOption );
+    parser.process( app );
+
+    QStringList arguments = parser.positionalArguments();
+    if ( arguments.size() < 2 ) {
+        parser.showHelp( 1 );
+    }
+
+    const QString command = arguments.takeFirst();
+    const QStringList paths = inputPaths( arguments, parser.isSet( recursiveOption ) );
+    const QString outputDirectory = parser.value( outputOption );
+
+    // no default: the inputs' own directory would be written over
+    if ( ( command == "thumbnail" || command == "convert" ) && outputDirectory.isEmpty() ) {
+        err() << "No output directory, give one with -o" << endl;
+        return 1;
+    }
+    const QString format = parser.value( formatOption );
+    const int quality = parser.value( qualityOption ).toInt();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int written = 0;
+    if ( command == "thumbnail" ) {
+        const QSize size = parseSize( parser.value( sizeOption ) );
+        if ( size.isEmpty() ) {
+            err() << "Wrong size: " << parser.value( sizeOption ) << endl;
+            return 1;
+        }
+        foreach ( const QString &argument, arguments ) {
+            QIoScheduler::globalInstance()->setConcurrency( argument, parser.value( readsOption ).toInt() );
+        }
+        written = QThumbnailer::writeAll( paths, size, outputDirectory, format, quality );
+    } else if ( command == "convert" ) {
+        QImageEditPipeline pipeline;
+        QString error;
+        if ( !pipeline.parse( parser.value( editOption ), &error ) ) {
+            err() << error << endl;
+            return 1;
+        }
+        QImageExporter::Settings settings;
+        settings.format = format.toLower().toLatin1();
+        settings.quality = quality;
+        settings.effort = parser.value( effortOption ).toInt();
+        settings.progressive = parser.isSet( progressiveOption );
+        settings.measure = parser.isSet( measureOption );
+        written = convert( paths, outputDirectory, settings, parser.value( threadsOption ).toInt(),
+                           pipeline, parser.isSet( reportOption ) );
+    } else if ( command == "info" ) {
+        info( paths );
+        return 0;
+    } else {
+        err() << "Unknown command: " << command << endl;
+        return 1;
+    }
+
+    err() << written << " of " << paths.size() << " images written in " << timer.elapsed() << " ms" << endl;
+    return written == paths.size() ? 0 : 2;
+}